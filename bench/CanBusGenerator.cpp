@@ -0,0 +1,164 @@
+#include "CanBusGenerator.h"
+#include <string.h>
+#include <algorithm>
+
+namespace {
+    bool IsLater(const auto& pending1, const auto& pending2) {
+        return pending1.dueTime > pending2.dueTime;
+    }
+}
+
+CanBusGenerator::CanBusGenerator(uint64_t inSeed) : _state(inSeed * 0x9E3779B97F4A7C15ull + 1) {
+    const std::vector<MessageType>& messageTypes = GetMessageTypes();
+    for (size_t index = 0; index < messageTypes.size(); index++) {
+        // Spread the first frames over the first cycle
+        _pending.push_back({ Random() % messageTypes[index].cycleTime, index });
+    }
+    std::make_heap(_pending.begin(), _pending.end(), IsLater<Pending, Pending>);
+}
+
+const std::vector<CanBusGenerator::MessageType>& CanBusGenerator::GetMessageTypes() {
+    static const std::vector<MessageType> messageTypes = {
+        { 0x0E2, "frontPassengerSideDoorStatus", 1000000, 4, true },
+        { 0x0E6, "rearPassengerSideDoorStatus", 1000000, 4, true },
+        { 0x0EA, "frontDriverSideDoorStatus", 1000000, 4, true },
+        { 0x0EE, "rearDriverSideDoorStatus", 1000000, 4, true },
+        { 0x0F6, "mirrorFoldStatus", 2000000, 8, true },
+        { 0x130, "ignitionAndKeyLocation", 100000, 5, true },
+        { 0x1B4, "vehicleSpeed", 100000, 8, true },
+        { 0x1B8, "iDriveControler", 200000, 6, true },
+        { 0x1D2, "gearShifterPosition", 200000, 6, true },
+        { 0x23A, "remoteControlAndDoorHandleInput", 5000000, 4, true },
+        { 0x26E, "windowRoofAndMirrorControl", 5000000, 8, true },
+        { 0x2A0, "doorLockControl", 5000000, 8, true },
+        { 0x2F8, "dateTime", 1000000, 8, true },
+        { 0x2FA, "passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus", 1000000, 5, true },
+        { 0x2FC, "doorOpenStatuses", 1000000, 7, true },
+        { 0x34F, "handbrakeStatus", 1000000, 2, true },
+        { 0x39E, "setDateTime", 10000000, 8, true },
+        // Messages of other control units
+        { 0x0A8, "engineTorque", 10000, 8, false },
+        { 0x0AA, "engineSpeed", 10000, 8, false },
+        { 0x0C4, "steeringAngle", 10000, 7, false },
+        { 0x0CE, "wheelSpeeds", 20000, 8, false },
+        { 0x19E, "stabilityControl", 20000, 8, false },
+        { 0x1A0, "vehicleDynamics", 20000, 8, false },
+        { 0x1D0, "engineTemperatures", 200000, 8, false },
+        { 0x1F6, "indicators", 1000000, 2, false },
+        { 0x21A, "lights", 5000000, 3, false },
+        { 0x24A, "steeringColumn", 200000, 8, false },
+        { 0x2CA, "outsideTemperature", 1000000, 2, false },
+        { 0x330, "odometer", 1000000, 8, false },
+        { 0x3B4, "batteryVoltage", 1000000, 8, false }
+    };
+    return messageTypes;
+}
+
+void CanBusGenerator::Generate(CanCoder::Frame* outFrames, size_t inFrameCount) {
+    const std::vector<MessageType>& messageTypes = GetMessageTypes();
+    for (size_t index = 0; index < inFrameCount; index++) {
+        std::pop_heap(_pending.begin(), _pending.end(), IsLater<Pending, Pending>);
+        Pending& pending = _pending.back();
+        const MessageType& messageType = messageTypes[pending.messageType];
+        FillData(messageType, pending.dueTime, outFrames[index]);
+        // Jitter of up to 1% of the cycle time, without drifting
+        uint64_t cycleTime = messageType.cycleTime;
+        pending.dueTime = (pending.dueTime / cycleTime + 1) * cycleTime + Random() % (cycleTime / 100 + 1);
+        std::push_heap(_pending.begin(), _pending.end(), IsLater<Pending, Pending>);
+    }
+}
+
+void CanBusGenerator::GenerateMessage(uint32_t inIdentifier, CanCoder::Frame* outFrames, size_t inFrameCount) {
+    const MessageType* messageType = nullptr;
+    for (const MessageType& candidate : GetMessageTypes()) {
+        if (candidate.identifier == inIdentifier) {
+            messageType = &candidate;
+        }
+    }
+    MessageType unknownType = { inIdentifier, "unknown", 10000, 8, false };
+    if (messageType == nullptr) {
+        messageType = &unknownType;
+    }
+    for (size_t index = 0; index < inFrameCount; index++) {
+        FillData(*messageType, index * messageType->cycleTime, outFrames[index]);
+    }
+}
+
+uint64_t CanBusGenerator::Random() {
+    // xorshift64*
+    _state ^= _state >> 12;
+    _state ^= _state << 25;
+    _state ^= _state >> 27;
+    return _state * 0x2545F4914F6CDD1Dull;
+}
+
+void CanBusGenerator::FillData(const MessageType& inMessageType, uint64_t inTimestamp, CanCoder::Frame& outFrame) {
+    outFrame.identifier = inMessageType.identifier;
+    outFrame.dataLengthCode = inMessageType.dataLengthCode;
+    outFrame.timestamp = inTimestamp;
+    memset(outFrame.data, 0, sizeof(outFrame.data));
+    uint64_t seconds = inTimestamp / 1000000;
+    switch (inMessageType.identifier) {
+    case 0x0E2:
+    case 0x0E6:
+    case 0x0EA:
+    case 0x0EE:
+        // Doors open for a while every minute
+        outFrame.data[0] = seconds % 60 < 50 ? 0x81 : 0x80;
+        outFrame.data[3] = seconds % 60 < 50 ? 0xfc : 0xfd;
+        break;
+    case 0x1B4: {
+        // Speed going up and down between 0 and 120 km/h over 4 minutes, in 0.1 km/h
+        uint64_t phase = (inTimestamp / 100000) % 2400;
+        uint32_t speed = (uint32_t)(phase < 1200 ? phase : 2400 - phase);
+        outFrame.data[0] = (uint8_t)speed;
+        outFrame.data[1] = (uint8_t)(0xd0 | (speed >> 8));
+        outFrame.data[2] = (uint8_t)Random();
+        break;
+    }
+    case 0x1B8: {
+        uint16_t dialValue = (uint16_t)(inTimestamp / 400000);
+        outFrame.data[0] = Random() % 16 == 0 ? 0x00 : 0x0f;
+        outFrame.data[1] = 0xc0 | (Random() % 32 == 0 ? 0x01 : 0x00);
+        outFrame.data[2] = (uint8_t)dialValue;
+        outFrame.data[3] = (uint8_t)(dialValue >> 8);
+        outFrame.data[4] = 0x14;
+        outFrame.data[5] = 0x10;
+        break;
+    }
+    case 0x1D2:
+        outFrame.data[0] = seconds % 120 < 10 ? 0xe1 : 0x78;
+        outFrame.data[1] = 0x0f;
+        outFrame.data[2] = 0xf0;
+        outFrame.data[3] = (uint8_t)(0x0c | (_counter += 0x10));
+        outFrame.data[4] = 0xf0;
+        outFrame.data[5] = 0xff;
+        break;
+    case 0x2F8:
+    case 0x39E:
+        outFrame.data[0] = (uint8_t)(seconds / 3600 % 24);
+        outFrame.data[1] = (uint8_t)(seconds / 60 % 60);
+        outFrame.data[2] = (uint8_t)(seconds % 60);
+        outFrame.data[3] = 15;
+        outFrame.data[4] = 0x6f;
+        outFrame.data[5] = 0xe6;
+        outFrame.data[6] = 0x07;
+        outFrame.data[7] = 0xf2;
+        break;
+    case 0x2FC:
+        outFrame.data[0] = 0x81;
+        outFrame.data[1] = seconds % 60 < 50 ? 0x00 : 0x01;
+        outFrame.data[2] = 0x00;
+        break;
+    case 0x34F:
+        outFrame.data[0] = seconds % 120 < 10 ? 0xfe : 0xfd;
+        outFrame.data[1] = 0xff;
+        break;
+    default:
+        // Other messages have changing data
+        for (uint8_t index = 0; index < inMessageType.dataLengthCode; index++) {
+            outFrame.data[index] = (uint8_t)Random();
+        }
+        break;
+    }
+}
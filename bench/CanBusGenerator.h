@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanBusGenerator
+ *
+ * Synthetic CAN bus traffic resembling the bus of a BMW Mini R60
+ *
+ * Each identifier is sent with its own cycle time plus a small jitter, the frames are
+ * returned in time order. Besides the messages supported by CanCoder the bus carries
+ * messages of other control units that CanCoder does not know, as on a real bus most
+ * traffic is not decoded. Signal values change over time: the speed follows a drive
+ * cycle, the dial of the iDrive controller turns, doors open and close.
+ * The cycle times are estimates from logs, the generator is meant for benchmarks and
+ * not as a reference of the bus.
+ * The sequence of frames only depends on the seed.
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class CanBusGenerator {
+public:
+    /// @brief Message sent on the synthetic bus
+    struct MessageType {
+        uint32_t identifier;
+        const char* name;
+        // Cycle time in microseconds
+        uint64_t cycleTime;
+        uint8_t dataLengthCode;
+        // Whether CanCoder decodes this message
+        bool supported;
+    };
+
+    /// @param inSeed Seed of the pseudo random jitter and signal values
+    explicit CanBusGenerator(uint64_t inSeed = 1);
+
+    /// @brief Get the message types on the bus
+    static const std::vector<MessageType>& GetMessageTypes();
+
+    /// @brief Generate the next frames in time order
+    /// @param outFrames Receives the frames
+    /// @param inFrameCount Number of frames
+    void Generate(CanCoder::Frame* outFrames, size_t inFrameCount);
+    /// @brief Generate frames of one message type, with changing signal values
+    /// @param inIdentifier Identifier of the message type
+    /// @param outFrames Receives the frames
+    /// @param inFrameCount Number of frames
+    void GenerateMessage(uint32_t inIdentifier, CanCoder::Frame* outFrames, size_t inFrameCount);
+
+private:
+    struct Pending {
+        uint64_t dueTime;
+        size_t messageType;
+    };
+
+    uint64_t Random();
+    void FillData(const MessageType& inMessageType, uint64_t inTimestamp, CanCoder::Frame& outFrame);
+
+    uint64_t _state;
+    // Min-heap of the next frame of each message type
+    std::vector<Pending> _pending;
+    uint8_t _counter = 0;
+};
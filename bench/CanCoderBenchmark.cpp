@@ -0,0 +1,361 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanCoderBenchmark
+ *
+ * Benchmarks of CanCoder in nanoseconds per frame
+ *
+ * Usage: CanCoderBenchmark [--format text|json|csv] [--output file] [--quick] [--filter text]
+ *
+ * Micro benchmarks measure Decode and Encode per identifier, Decode of identifiers that
+ * are not supported and the string functions. Macro benchmarks replay synthetic R60 bus
+ * traffic from CanBusGenerator with Decode, DecodeBatch and DecodeChanges, and
+ * CanPayloadSearch with 4, 16 and 64 patterns compared with every frame.
+ * Each benchmark is repeated and the fastest repetition is reported, which is the most
+ * stable measure on a busy machine. The JSON and CSV output is meant to be stored per
+ * release, so regressions show up when comparing them.
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: CanPayloadSearch benchmarks
+ *
+ */
+
+#include "CanBusGenerator.h"
+#include "CanCoder.h"
+#include "CanPayloadSearch.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Result {
+        std::string name;
+        double nanosecondsPerFrame;
+        size_t framesPerRepetition;
+        int repetitions;
+    };
+
+    struct Options {
+        const char* format = "text";
+        const char* output = nullptr;
+        const char* filter = nullptr;
+        bool quick = false;
+    };
+
+    // Keeps the compiler from removing the work being measured
+    volatile uint64_t sink;
+
+    class Benchmark {
+    public:
+        explicit Benchmark(const Options& inOptions) : _options(inOptions) {}
+
+        // Run inFunction, which processes inFrameCount frames per call, and record the fastest repetition
+        template <typename Function>
+        void Run(const std::string& inName, size_t inFrameCount, Function&& inFunction) {
+            if (_options.filter != nullptr && inName.find(_options.filter) == std::string::npos) {
+                return;
+            }
+            int repetitions = _options.quick ? 3 : 15;
+            // Warm up caches and branch predictors
+            inFunction();
+            double fastest = 0;
+            for (int repetition = 0; repetition < repetitions; repetition++) {
+                auto start = std::chrono::steady_clock::now();
+                inFunction();
+                auto end = std::chrono::steady_clock::now();
+                double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+                if (repetition == 0 || nanoseconds < fastest) {
+                    fastest = nanoseconds;
+                }
+            }
+            _results.push_back({ inName, fastest / (double)inFrameCount, inFrameCount, repetitions });
+        }
+
+        bool Write() const {
+            FILE* file = stdout;
+            if (_options.output != nullptr) {
+                file = fopen(_options.output, "w");
+                if (file == nullptr) {
+                    fprintf(stderr, "Can not open %s\n", _options.output);
+                    return false;
+                }
+            }
+            if (strcmp(_options.format, "text") == 0) {
+                for (const Result& result : _results) {
+                    fprintf(file, "%-64s %10.2f ns/frame\n", result.name.c_str(), result.nanosecondsPerFrame);
+                }
+            }
+            else if (strcmp(_options.format, "json") == 0) {
+                fprintf(file, "{\n  \"unit\": \"ns/frame\",\n  \"benchmarks\": [\n");
+                for (size_t index = 0; index < _results.size(); index++) {
+                    const Result& result = _results[index];
+                    fprintf(file, "    { \"name\": \"%s\", \"nsPerFrame\": %.3f, \"frames\": %zu, \"repetitions\": %d }%s\n",
+                        result.name.c_str(), result.nanosecondsPerFrame, result.framesPerRepetition, result.repetitions,
+                        index + 1 < _results.size() ? "," : "");
+                }
+                fprintf(file, "  ]\n}\n");
+            }
+            else if (strcmp(_options.format, "csv") == 0) {
+                fprintf(file, "name,nsPerFrame,frames,repetitions\n");
+                for (const Result& result : _results) {
+                    fprintf(file, "%s,%.3f,%zu,%d\n", result.name.c_str(), result.nanosecondsPerFrame, result.framesPerRepetition, result.repetitions);
+                }
+            }
+            if (file != stdout) {
+                fclose(file);
+            }
+            return true;
+        }
+
+        size_t FrameCount(size_t inFrameCount) const {
+            return _options.quick ? inFrameCount / 16 : inFrameCount;
+        }
+
+    private:
+        const Options& _options;
+        std::vector<Result> _results;
+    };
+
+    void DecodeBenchmarks(Benchmark& benchmark) {
+        CanBusGenerator generator;
+        size_t frameCount = benchmark.FrameCount(1 << 16);
+        std::vector<CanCoder::Frame> frames(frameCount);
+        for (const CanBusGenerator::MessageType& messageType : CanBusGenerator::GetMessageTypes()) {
+            if (!messageType.supported) {
+                continue;
+            }
+            generator.GenerateMessage(messageType.identifier, frames.data(), frameCount);
+            benchmark.Run(std::string("decode/") + messageType.name, frameCount, [&]() {
+                CanCoder coder;
+                for (CanCoder::Frame& frame : frames) {
+                    coder.Decode(frame.identifier, frame.dataLengthCode, frame.data);
+                }
+                sink = (uint64_t)coder._vehicleSpeed.speed + coder._dateTime.second;
+            });
+        }
+
+        // Identifiers of other control units and identifiers outside the standard range
+        for (size_t index = 0; index < frameCount; index++) {
+            const std::vector<CanBusGenerator::MessageType>& messageTypes = CanBusGenerator::GetMessageTypes();
+            const CanBusGenerator::MessageType& messageType = messageTypes[messageTypes.size() - 1 - index % 13];
+            generator.GenerateMessage(messageType.identifier, &frames[index], 1);
+        }
+        benchmark.Run("decode/unknownIdentifier", frameCount, [&]() {
+            CanCoder coder;
+            uint64_t decodedCount = 0;
+            for (CanCoder::Frame& frame : frames) {
+                decodedCount += coder.Decode(frame.identifier, frame.dataLengthCode, frame.data);
+            }
+            sink = decodedCount;
+        });
+        for (size_t index = 0; index < frameCount; index++) {
+            frames[index].identifier = 0x800 + (uint32_t)index * 7919;
+        }
+        benchmark.Run("decode/outOfRangeIdentifier", frameCount, [&]() {
+            CanCoder coder;
+            uint64_t decodedCount = 0;
+            for (CanCoder::Frame& frame : frames) {
+                decodedCount += coder.Decode(frame.identifier, frame.dataLengthCode, frame.data);
+            }
+            sink = decodedCount;
+        });
+    }
+
+    void EncodeBenchmarks(Benchmark& benchmark) {
+        size_t frameCount = benchmark.FrameCount(1 << 16);
+        for (const CanBusGenerator::MessageType& messageType : CanBusGenerator::GetMessageTypes()) {
+            if (!messageType.supported || !CanCoder::IsEncodable((CanCoder::Identifier)messageType.identifier)) {
+                continue;
+            }
+            benchmark.Run(std::string("encode/") + messageType.name, frameCount, [&]() {
+                CanCoder coder;
+                coder._identifier = (CanCoder::Identifier)messageType.identifier;
+                uint32_t identifier;
+                uint8_t dataLengthCode;
+                uint8_t data[8] = {};
+                uint64_t checksum = 0;
+                for (size_t index = 0; index < frameCount; index++) {
+                    coder._dateTime.second = (int)(index % 60);
+                    coder._iDriveController.dialValue = (unsigned short)index;
+                    coder.Encode(identifier, dataLengthCode, data);
+                    checksum += data[0] + data[3];
+                }
+                sink = checksum;
+            });
+        }
+    }
+
+    void StringBenchmarks(Benchmark& benchmark) {
+        CanBusGenerator generator;
+        size_t frameCount = benchmark.FrameCount(1 << 14);
+        std::vector<CanCoder::Frame> frames(frameCount);
+        generator.Generate(frames.data(), frameCount);
+
+        benchmark.Run("string/rawMessageToString/buffer", frameCount, [&]() {
+            char buffer[CanCoder::stringBufferSize];
+            uint64_t length = 0;
+            for (const CanCoder::Frame& frame : frames) {
+                length += CanCoder::RawMessageToString(frame.identifier, frame.dataLengthCode, frame.data, buffer, sizeof(buffer));
+            }
+            sink = length;
+        });
+        benchmark.Run("string/rawMessageToString/string", frameCount, [&]() {
+            std::string string;
+            uint64_t length = 0;
+            for (const CanCoder::Frame& frame : frames) {
+                CanCoder::RawMessageToString(frame.identifier, frame.dataLengthCode, frame.data, string);
+                length += string.size();
+            }
+            sink = length;
+        });
+        benchmark.Run("string/rawMessageToString/returned", frameCount, [&]() {
+            uint64_t length = 0;
+            for (CanCoder::Frame& frame : frames) {
+                length += CanCoder::RawMessageToString(frame.identifier, frame.dataLengthCode, frame.data).size();
+            }
+            sink = length;
+        });
+
+        // Only frames that are decoded have contents to show
+        std::vector<CanCoder::Frame> decodedFrames;
+        CanCoder decoder;
+        for (CanCoder::Frame& frame : frames) {
+            if (decoder.Decode(frame.identifier, frame.dataLengthCode, frame.data)) {
+                decodedFrames.push_back(frame);
+            }
+        }
+        std::vector<CanCoder> coders(decodedFrames.size());
+        for (size_t index = 0; index < decodedFrames.size(); index++) {
+            coders[index].Decode(decodedFrames[index].identifier, decodedFrames[index].dataLengthCode, decodedFrames[index].data);
+        }
+        benchmark.Run("string/toString/buffer", coders.size(), [&]() {
+            char buffer[CanCoder::stringBufferSize];
+            uint64_t length = 0;
+            for (const CanCoder& coder : coders) {
+                length += coder.ToString(buffer, sizeof(buffer));
+            }
+            sink = length;
+        });
+        benchmark.Run("string/toString/string", coders.size(), [&]() {
+            std::string string;
+            uint64_t length = 0;
+            for (const CanCoder& coder : coders) {
+                coder.ToString(string);
+                length += string.size();
+            }
+            sink = length;
+        });
+        benchmark.Run("string/toString/returned", coders.size(), [&]() {
+            uint64_t length = 0;
+            for (CanCoder& coder : coders) {
+                length += coder.ToString().size();
+            }
+            sink = length;
+        });
+    }
+
+    void ReplayBenchmarks(Benchmark& benchmark) {
+        CanBusGenerator generator;
+        size_t frameCount = benchmark.FrameCount(1 << 20);
+        std::vector<CanCoder::Frame> frames(frameCount);
+        generator.Generate(frames.data(), frameCount);
+
+        benchmark.Run("replay/decode", frameCount, [&]() {
+            CanCoder coder;
+            uint64_t decodedCount = 0;
+            for (CanCoder::Frame& frame : frames) {
+                decodedCount += coder.Decode(frame.identifier, frame.dataLengthCode, frame.data);
+            }
+            sink = decodedCount;
+        });
+        benchmark.Run("replay/decodeBatch", frameCount, [&]() {
+            CanCoder coder;
+            uint32_t results[64 / 32];
+            uint64_t decodedCount = 0;
+            for (size_t index = 0; index < frameCount; index += 64) {
+                size_t batchSize = frameCount - index < 64 ? frameCount - index : 64;
+                decodedCount += coder.DecodeBatch(&frames[index], batchSize, results);
+            }
+            sink = decodedCount;
+        });
+        benchmark.Run("replay/decodeChanges", frameCount, [&]() {
+            CanCoder coder;
+            uint64_t changedCount = 0;
+            for (CanCoder::Frame& frame : frames) {
+                uint32_t changedFields;
+                coder.DecodeChanges(frame.identifier, frame.dataLengthCode, frame.data, changedFields);
+                changedCount += changedFields != 0;
+            }
+            sink = changedCount;
+        });
+    }
+
+    void SearchBenchmarks(Benchmark& benchmark) {
+        CanBusGenerator generator;
+        size_t frameCount = benchmark.FrameCount(1 << 20);
+        std::vector<CanCoder::Frame> frames(frameCount);
+        generator.Generate(frames.data(), frameCount);
+
+        for (int patternCount : { 4, 16, 64 }) {
+            // Patterns for any identifier on the first 2 bytes, so every frame is compared with all of them
+            CanPayloadSearch search;
+            for (int patternNumber = 0; patternNumber < patternCount; patternNumber++) {
+                uint8_t value[2] = { (uint8_t)(0xA5 ^ patternNumber), (uint8_t)(0x5A + patternNumber) };
+                uint8_t mask[2] = { 0xFF, 0xF0 };
+                search.AddPattern(CanPayloadSearch::anyIdentifier, value, mask, 2);
+            }
+            search.Compile();
+            std::vector<CanPayloadSearch::Hit> hits;
+            benchmark.Run("search/anyIdentifier/" + std::to_string(patternCount) + "Patterns", frameCount, [&]() {
+                hits.clear();
+                sink = search.Search(frames.data(), frameCount, hits);
+            });
+        }
+    }
+
+    void PrintUsage() {
+        fprintf(stderr, "Usage: CanCoderBenchmark [--format text|json|csv] [--output file] [--quick] [--filter text]\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int index = 1; index < argc; index++) {
+        if (strcmp(argv[index], "--format") == 0 && index + 1 < argc) {
+            options.format = argv[++index];
+        }
+        else if (strcmp(argv[index], "--output") == 0 && index + 1 < argc) {
+            options.output = argv[++index];
+        }
+        else if (strcmp(argv[index], "--filter") == 0 && index + 1 < argc) {
+            options.filter = argv[++index];
+        }
+        else if (strcmp(argv[index], "--quick") == 0) {
+            options.quick = true;
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (strcmp(options.format, "text") != 0 && strcmp(options.format, "json") != 0 && strcmp(options.format, "csv") != 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    Benchmark benchmark(options);
+    DecodeBenchmarks(benchmark);
+    EncodeBenchmarks(benchmark);
+    StringBenchmarks(benchmark);
+    ReplayBenchmarks(benchmark);
+    SearchBenchmarks(benchmark);
+    return benchmark.Write() ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+#include "CanBusAnalyzer.h"
+#include <math.h>
+#include <string.h>
+#include <bit>
+
+namespace {
+    // Bits from the acknowledge delimiter to the end of the interframe space, never stuffed:
+    // CRC delimiter, acknowledge slot, acknowledge delimiter, end of frame, interframe space
+    constexpr uint32_t unstuffedBitCount = 1 + 1 + 1 + 7 + 3;
+    constexpr uint16_t crcPolynomial = 0x4599;
+    constexpr uint64_t defaultTimeoutPeriods = 3;
+
+    constexpr uint16_t UpdateCrc(uint16_t crc, bool bit) {
+        bool next = bit ^ ((crc >> 14) & 1);
+        crc = (uint16_t)((crc << 1) & 0x7fff);
+        return next ? (uint16_t)(crc ^ crcPolynomial) : crc;
+    }
+
+    // CRC of the register after shifting in the 8 bits of the index, with the register starting at 0
+    constexpr auto crcTable = []() {
+        struct {
+            uint16_t entries[256];
+        } table = {};
+        for (unsigned index = 0; index < 256; index++) {
+            uint16_t crc = (uint16_t)(index << 7);
+            for (unsigned bit = 0; bit < 8; bit++) {
+                crc = UpdateCrc(crc, false);
+            }
+            table.entries[index] = crc;
+        }
+        return table;
+    }();
+
+    // Bit stuffing as a state machine: the value of the last bit and the number of equal bits
+    // in a row, 0-4. After 5 equal bits a stuff bit of the opposite value is inserted, which
+    // starts the next row
+    constexpr unsigned stuffingStateCount = 10;
+    constexpr unsigned initialStuffingState = 1 * 5 + 0;
+
+    constexpr unsigned NextStuffingState(unsigned state, bool bit, unsigned& stuffBitCount) {
+        unsigned value = state / 5;
+        unsigned length = state % 5;
+        if (bit == (value != 0)) {
+            if (++length == 5) {
+                stuffBitCount++;
+                value ^= 1;
+                length = 1;
+            }
+        }
+        else {
+            value = bit;
+            length = 1;
+        }
+        return value * 5 + length;
+    }
+
+    // For each state and byte, the next state in bits 0-3 and the number of stuff bits in bits 4-7
+    constexpr auto stuffingTable = []() {
+        struct {
+            uint8_t entries[stuffingStateCount][256];
+        } table = {};
+        for (unsigned state = 0; state < stuffingStateCount; state++) {
+            for (unsigned byte = 0; byte < 256; byte++) {
+                unsigned stuffBitCount = 0;
+                unsigned nextState = state;
+                for (unsigned bit = 8; bit-- > 0;) {
+                    nextState = NextStuffingState(nextState, (byte >> bit) & 1, stuffBitCount);
+                }
+                table.entries[state][byte] = (uint8_t)(nextState | (stuffBitCount << 4));
+            }
+        }
+        return table;
+    }();
+
+    // Bits of a frame from the start of frame up to and including the CRC, which are stuffed
+    // Bit n of the frame is bit 63 - n % 64 of word n / 64
+    class FrameBits {
+    public:
+        void Add(uint32_t value, unsigned bitCount) {
+            uint64_t bits = (uint64_t)value & ((1ull << bitCount) - 1);
+            unsigned word = _count / 64;
+            int shift = 64 - (int)(_count % 64) - (int)bitCount;
+            if (shift >= 0) {
+                _words[word] |= bits << shift;
+            }
+            else {
+                _words[word] |= bits >> -shift;
+                _words[word + 1] |= bits << (64 + shift);
+            }
+            _count += bitCount;
+        }
+
+        // Add the CRC of all bits added so far, computed a byte at a time
+        void AddCrc() {
+            uint16_t crc = 0;
+            unsigned byteCount = _count / 8;
+            for (unsigned index = 0; index < byteCount; index++) {
+                crc = (uint16_t)(((crc << 8) & 0x7fff) ^ crcTable.entries[((crc >> 7) ^ GetByte(index)) & 0xff]);
+            }
+            for (unsigned position = byteCount * 8; position < _count; position++) {
+                crc = UpdateCrc(crc, GetBit(position));
+            }
+            Add(crc, 15);
+        }
+
+        // The bits are fed to the stuffing state machine a byte at a time
+        uint32_t GetStuffBitCount() const {
+            uint32_t stuffBitCount = 0;
+            unsigned state = initialStuffingState;
+            unsigned byteCount = _count / 8;
+            for (unsigned index = 0; index < byteCount; index++) {
+                uint8_t entry = stuffingTable.entries[state][GetByte(index)];
+                state = entry & 0x0f;
+                stuffBitCount += entry >> 4;
+            }
+            for (unsigned position = byteCount * 8; position < _count; position++) {
+                state = NextStuffingState(state, GetBit(position), stuffBitCount);
+            }
+            return stuffBitCount;
+        }
+
+        unsigned GetCount() const { return _count; }
+
+    private:
+        uint8_t GetByte(unsigned index) const { return (uint8_t)(_words[index / 8] >> (56 - index % 8 * 8)); }
+        bool GetBit(unsigned position) const { return (_words[position / 64] >> (63 - position % 64)) & 1; }
+
+        // Extended frame with 8 bytes: 39 + 64 + 15 bits
+        uint64_t _words[2] = {};
+        unsigned _count = 0;
+    };
+}
+
+CanBusAnalyzer::CanBusAnalyzer(uint32_t inBitRate) : _bitRate(inBitRate) {
+    Reset();
+}
+
+uint32_t CanBusAnalyzer::GetFrameBitCount(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData, uint32_t& outStuffBitCount) {
+    uint8_t dataLength = inDataLengthCode > 8 ? 8 : inDataLengthCode;
+    FrameBits bits;
+    // Start of frame
+    bits.Add(0, 1);
+    if ((inIdentifier & CanCoder::extendedIdentifierFlag) != 0) {
+        uint32_t identifier = inIdentifier & 0x1fffffff;
+        // Base identifier, substitute remote request and identifier extension, which are recessive
+        bits.Add(identifier >> 18, 11);
+        bits.Add(0x3, 2);
+        // Identifier extension, remote transmission request and reserved bits r1 and r0
+        bits.Add(identifier & 0x3ffff, 18);
+        bits.Add(0, 3);
+    }
+    else {
+        // Identifier, remote transmission request, identifier extension and reserved bit r0
+        bits.Add(inIdentifier & 0x7ff, 11);
+        bits.Add(0, 3);
+    }
+    bits.Add(dataLength, 4);
+    for (uint8_t index = 0; index < dataLength; index++) {
+        bits.Add(inData[index], 8);
+    }
+    bits.AddCrc();
+    outStuffBitCount = bits.GetStuffBitCount();
+    return bits.GetCount() + outStuffBitCount + unstuffedBitCount;
+}
+
+size_t CanBusAnalyzer::GetBucket(uint64_t inInterval) {
+    // Intervals 0-7 have a bucket each, above that each power of 2 has 8 buckets
+    if (inInterval < 8) {
+        return (size_t)inInterval;
+    }
+    unsigned power = 63 - std::countl_zero(inInterval);
+    size_t bucket = (power - 2) * 8 + ((inInterval >> (power - 3)) & 7);
+    return bucket < histogramBucketCount ? bucket : histogramBucketCount - 1;
+}
+
+uint64_t CanBusAnalyzer::GetBucketLowerBound(size_t inBucket) {
+    if (inBucket < 8) {
+        return inBucket;
+    }
+    unsigned power = (unsigned)(inBucket / 8 + 2);
+    return (uint64_t)(8 + inBucket % 8) << (power - 3);
+}
+
+CanBusAnalyzer::Slot* CanBusAnalyzer::FindSlot(uint32_t inIdentifier, bool inCreate) {
+    constexpr size_t tableSize = sizeof(_slotNumbers) / sizeof(_slotNumbers[0]);
+    size_t position = (inIdentifier * 2654435761u) % tableSize;
+    while (_slotNumbers[position] != 0) {
+        Slot& slot = _slots[_slotNumbers[position] - 1];
+        if (slot.identifier == inIdentifier) {
+            return &slot;
+        }
+        position = (position + 1) % tableSize;
+    }
+    if (!inCreate || _slotCount == maximumIdentifierCount) {
+        return nullptr;
+    }
+    Slot& slot = _slots[_slotCount++];
+    memset(&slot, 0, sizeof(slot));
+    slot.identifier = inIdentifier;
+    slot.minimumInterval = UINT64_MAX;
+    _slotNumbers[position] = (uint16_t)_slotCount;
+    return &slot;
+}
+
+const CanBusAnalyzer::Slot* CanBusAnalyzer::FindSlot(uint32_t inIdentifier) const {
+    return const_cast<CanBusAnalyzer*>(this)->FindSlot(inIdentifier, false);
+}
+
+void CanBusAnalyzer::Add(const CanCoder::Frame& inFrame) {
+    uint32_t stuffBitCount;
+    uint32_t bitCount = GetFrameBitCount(inFrame.identifier, inFrame.dataLengthCode, inFrame.data, stuffBitCount);
+    if (_frameCount == 0) {
+        _firstTimestamp = inFrame.timestamp;
+    }
+    _frameCount++;
+    _bitCount += bitCount;
+    _stuffBitCount += stuffBitCount;
+    _lastTimestamp = inFrame.timestamp;
+
+    Slot* slot = FindSlot(inFrame.identifier, true);
+    if (slot == nullptr) {
+        _untrackedFrameCount++;
+        return;
+    }
+    slot->bitCount += bitCount;
+    slot->timedOut = false;
+    if (slot->frameCount++ == 0) {
+        slot->firstTimestamp = inFrame.timestamp;
+        slot->lastTimestamp = inFrame.timestamp;
+        return;
+    }
+    uint64_t interval = inFrame.timestamp > slot->lastTimestamp ? inFrame.timestamp - slot->lastTimestamp : 0;
+    slot->lastTimestamp = inFrame.timestamp;
+    uint64_t intervalCount = slot->frameCount - 1;
+    double difference = (double)interval - slot->mean;
+    slot->mean += difference / (double)intervalCount;
+    slot->squaredDifferences += difference * ((double)interval - slot->mean);
+    if (interval < slot->minimumInterval) {
+        slot->minimumInterval = interval;
+    }
+    if (interval > slot->maximumInterval) {
+        slot->maximumInterval = interval;
+    }
+    slot->histogram[GetBucket(interval)]++;
+    // A frame more than half a period late means frames were missed
+    if (slot->expectedPeriod != 0 && interval > slot->expectedPeriod + slot->expectedPeriod / 2) {
+        slot->missedCount += (interval + slot->expectedPeriod / 2) / slot->expectedPeriod - 1;
+    }
+}
+
+bool CanBusAnalyzer::SetExpectedPeriod(uint32_t inIdentifier, uint64_t inPeriod, uint64_t inTimeout) {
+    Slot* slot = FindSlot(inIdentifier, true);
+    if (slot == nullptr) {
+        return false;
+    }
+    slot->expectedPeriod = inPeriod;
+    slot->timeout = inTimeout != 0 ? inTimeout : inPeriod * defaultTimeoutPeriods;
+    return true;
+}
+
+size_t CanBusAnalyzer::CheckTimeouts(uint64_t inNow, TimeoutListener inListener, void* inContext) {
+    size_t timedOutCount = 0;
+    for (Slot* slot = _slots; slot < _slots + _slotCount; slot++) {
+        if (slot->expectedPeriod == 0 || slot->timedOut) {
+            continue;
+        }
+        uint64_t lastTimestamp = slot->frameCount != 0 ? slot->lastTimestamp : _firstTimestamp;
+        if ((slot->frameCount == 0 && _frameCount == 0) || inNow <= lastTimestamp || inNow - lastTimestamp <= slot->timeout) {
+            continue;
+        }
+        slot->timedOut = true;
+        slot->timeoutCount++;
+        timedOutCount++;
+        if (inListener != nullptr) {
+            inListener(inContext, slot->identifier, slot->lastTimestamp);
+        }
+    }
+    return timedOutCount;
+}
+
+bool CanBusAnalyzer::GetStatistics(uint32_t inIdentifier, IdentifierStatistics& outStatistics) const {
+    const Slot* slot = FindSlot(inIdentifier);
+    if (slot == nullptr) {
+        return false;
+    }
+    uint64_t intervalCount = slot->frameCount > 1 ? slot->frameCount - 1 : 0;
+    outStatistics.identifier = slot->identifier;
+    outStatistics.frameCount = slot->frameCount;
+    outStatistics.bitCount = slot->bitCount;
+    outStatistics.firstTimestamp = slot->firstTimestamp;
+    outStatistics.lastTimestamp = slot->lastTimestamp;
+    outStatistics.meanInterval = slot->mean;
+    outStatistics.jitter = intervalCount > 1 ? sqrt(slot->squaredDifferences / (double)(intervalCount - 1)) : 0;
+    outStatistics.minimumInterval = intervalCount > 0 ? slot->minimumInterval : 0;
+    outStatistics.maximumInterval = slot->maximumInterval;
+    outStatistics.expectedPeriod = slot->expectedPeriod;
+    outStatistics.missedCount = slot->missedCount;
+    outStatistics.timeoutCount = slot->timeoutCount;
+    return true;
+}
+
+uint64_t CanBusAnalyzer::GetIntervalPercentile(uint32_t inIdentifier, double inPercentile) const {
+    const Slot* slot = FindSlot(inIdentifier);
+    if (slot == nullptr || slot->frameCount < 2) {
+        return 0;
+    }
+    uint64_t intervalCount = slot->frameCount - 1;
+    // Rank of the interval, 1 for the smallest
+    uint64_t rank = (uint64_t)ceil(inPercentile / 100 * (double)intervalCount);
+    rank = rank < 1 ? 1 : (rank > intervalCount ? intervalCount : rank);
+    uint64_t count = 0;
+    for (size_t bucket = 0; bucket < histogramBucketCount; bucket++) {
+        count += slot->histogram[bucket];
+        if (count >= rank) {
+            // The middle of the bucket, clamped to the intervals seen
+            uint64_t lowerBound = GetBucketLowerBound(bucket);
+            uint64_t upperBound = bucket + 1 < histogramBucketCount ? GetBucketLowerBound(bucket + 1) - 1 : slot->maximumInterval;
+            uint64_t interval = lowerBound + (upperBound - lowerBound) / 2;
+            interval = interval < slot->minimumInterval ? slot->minimumInterval : interval;
+            return interval > slot->maximumInterval ? slot->maximumInterval : interval;
+        }
+    }
+    return slot->maximumInterval;
+}
+
+CanBusAnalyzer::BusStatistics CanBusAnalyzer::GetBusStatistics() const {
+    BusStatistics statistics;
+    statistics.frameCount = _frameCount;
+    statistics.bitCount = _bitCount;
+    statistics.stuffBitCount = _stuffBitCount;
+    statistics.untrackedFrameCount = _untrackedFrameCount;
+    statistics.firstTimestamp = _firstTimestamp;
+    statistics.lastTimestamp = _lastTimestamp;
+    uint64_t duration = _lastTimestamp - _firstTimestamp;
+    statistics.load = duration > 0 ? (double)_bitCount * 1000000 / ((double)duration * _bitRate) : 0;
+    return statistics;
+}
+
+size_t CanBusAnalyzer::GetIdentifiers(uint32_t* outIdentifiers, size_t inMaximumCount) const {
+    for (size_t index = 0; outIdentifiers != nullptr && index < _slotCount && index < inMaximumCount; index++) {
+        outIdentifiers[index] = _slots[index].identifier;
+    }
+    return _slotCount;
+}
+
+void CanBusAnalyzer::Reset() {
+    _slotCount = 0;
+    memset(_slotNumbers, 0, sizeof(_slotNumbers));
+    _frameCount = 0;
+    _bitCount = 0;
+    _stuffBitCount = 0;
+    _untrackedFrameCount = 0;
+    _firstTimestamp = 0;
+    _lastTimestamp = 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanBusAnalyzer
+ *
+ * Timing and bus load statistics of a stream of frames
+ *
+ * The analyzer is fed the frames passing through the decoder and keeps statistics per
+ * identifier in constant memory, without storing the frames:
+ * Cycle time    Mean and jitter (standard deviation) of the interval between frames of
+ *               an identifier, computed with Welford's streaming algorithm, its minimum
+ *               and maximum, and percentiles from a histogram with 8 buckets per power
+ *               of 2 (within 7% of the actual interval)
+ * Schedule      With an expected period the frames that were missed are counted and
+ *               CheckTimeouts reports identifiers that stopped being sent
+ * Bus load      The exact number of bits of each frame on the wire: the CRC is computed
+ *               to count the stuff bits, plus delimiters, acknowledge, end of frame and
+ *               interframe space
+ *
+ * Up to maximumIdentifierCount identifiers are tracked, frames of further identifiers
+ * only count for the bus load. Timestamps are in microseconds and should be in time
+ * order, as they are when received. Extended identifiers carry CanCoder::extendedIdentifierFlag.
+ * Frames are counted as CAN 2.0 data frames of at most 8 bytes.
+ * The analyzer holds the statistics inline, about 260 kB, allocate it with new or
+ * make it static rather than putting it on the stack.
+ *
+ * For example, finding ECUs drifting off their schedule:
+ *     auto analyzer = std::make_unique<CanBusAnalyzer>(500000);
+ *     analyzer->SetExpectedPeriod(0x1B4, 20000);
+ *     // For each frame received
+ *     analyzer->Add(frame);
+ *     coder.Decode(frame.identifier, frame.dataLengthCode, frame.data);
+ *     // Every second
+ *     analyzer->CheckTimeouts(now, &ReportTimeout, nullptr);
+ *     CanBusAnalyzer::IdentifierStatistics speed;
+ *     if (analyzer->GetStatistics(0x1B4, speed) && speed.meanInterval > 21000) {
+ *         ...
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class CanBusAnalyzer {
+public:
+    /// @brief Maximum number of identifiers with statistics
+    static constexpr size_t maximumIdentifierCount = 256;
+    /// @brief Number of buckets of the interval histograms, covering intervals up to 2^27 microseconds (134 s)
+    static constexpr size_t histogramBucketCount = 200;
+
+    /// @brief Statistics of an identifier
+    struct IdentifierStatistics {
+        uint32_t identifier;
+        uint64_t frameCount;
+        // Bits on the wire, including stuff bits
+        uint64_t bitCount;
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+        // Interval between frames, in microseconds
+        double meanInterval;
+        // Standard deviation of the interval
+        double jitter;
+        uint64_t minimumInterval;
+        uint64_t maximumInterval;
+        // 0 when no period is expected
+        uint64_t expectedPeriod;
+        // Frames missing between frames that arrived late
+        uint64_t missedCount;
+        // Times CheckTimeouts reported the identifier
+        uint64_t timeoutCount;
+    };
+
+    /// @brief Statistics of the bus
+    struct BusStatistics {
+        uint64_t frameCount;
+        // Bits on the wire, including stuff bits
+        uint64_t bitCount;
+        uint64_t stuffBitCount;
+        // Frames of identifiers beyond maximumIdentifierCount
+        uint64_t untrackedFrameCount;
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+        // Fraction of the bit rate used between the first and last frame, 0-1
+        double load;
+    };
+
+    /// @brief Function called for an identifier that timed out
+    /// @param inContext The context passed to CheckTimeouts
+    /// @param inIdentifier The identifier
+    /// @param inLastTimestamp Timestamp of the last frame of the identifier
+    using TimeoutListener = void (*)(void* inContext, uint32_t inIdentifier, uint64_t inLastTimestamp);
+
+    /// @param inBitRate Bit rate of the bus in bits per second
+    explicit CanBusAnalyzer(uint32_t inBitRate = 500000);
+
+    /// @brief Add a frame
+    /// @param inFrame The frame, its timestamp in microseconds
+    void Add(const CanCoder::Frame& inFrame);
+    /// @brief Set the expected period of an identifier, for counting missed frames and timeouts
+    /// @param inIdentifier CAN message identifier
+    /// @param inPeriod Expected period in microseconds, 0 to remove it
+    /// @param inTimeout Time without frames after which the identifier times out, 0 for 3 periods
+    /// @return true on success, false when maximumIdentifierCount identifiers are tracked
+    bool SetExpectedPeriod(uint32_t inIdentifier, uint64_t inPeriod, uint64_t inTimeout = 0);
+    /// @brief Report the identifiers with an expected period that timed out
+    ///
+    /// An identifier is reported once, until its next frame arrives.
+    /// Identifiers of which no frame arrived yet time out relative to the first frame of the bus.
+    /// @param inNow The current time in microseconds
+    /// @param inListener Function called for each identifier that timed out, may be nullptr
+    /// @param inContext Passed to the listener
+    /// @return The number of identifiers that timed out
+    size_t CheckTimeouts(uint64_t inNow, TimeoutListener inListener, void* inContext);
+
+    /// @brief Get the statistics of an identifier
+    /// @return true on success, false when the identifier is not tracked
+    bool GetStatistics(uint32_t inIdentifier, IdentifierStatistics& outStatistics) const;
+    /// @brief Get a percentile of the interval between frames of an identifier
+    /// @param inIdentifier CAN message identifier
+    /// @param inPercentile The percentile, 0-100
+    /// @return The interval in microseconds, 0 when there are no intervals
+    uint64_t GetIntervalPercentile(uint32_t inIdentifier, double inPercentile) const;
+    /// @brief Get the statistics of the bus
+    BusStatistics GetBusStatistics() const;
+    /// @brief Get the tracked identifiers, in the order of their first frame
+    /// @param outIdentifiers Receives the identifiers, may be nullptr
+    /// @param inMaximumCount Maximum number of identifiers to store in outIdentifiers
+    /// @return The number of tracked identifiers
+    size_t GetIdentifiers(uint32_t* outIdentifiers, size_t inMaximumCount) const;
+    /// @brief Remove all statistics, including the expected periods
+    void Reset();
+
+    /// @brief Get the number of bits of a frame on the wire
+    /// @param inIdentifier CAN message identifier, extended identifiers carry CanCoder::extendedIdentifierFlag
+    /// @param inDataLengthCode Data length code, data of more than 8 bytes counts as 8
+    /// @param inData The data
+    /// @param outStuffBitCount Receives the number of stuff bits, included in the result
+    /// @return The number of bits, from start of frame up to and including the interframe space
+    static uint32_t GetFrameBitCount(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData, uint32_t& outStuffBitCount);
+
+private:
+    struct Slot {
+        uint32_t identifier;
+        bool timedOut;
+        uint64_t frameCount;
+        uint64_t bitCount;
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+        // Welford's running mean and sum of squared differences of the intervals
+        double mean;
+        double squaredDifferences;
+        uint64_t minimumInterval;
+        uint64_t maximumInterval;
+        uint64_t expectedPeriod;
+        uint64_t timeout;
+        uint64_t missedCount;
+        uint64_t timeoutCount;
+        uint32_t histogram[histogramBucketCount];
+    };
+
+    static size_t GetBucket(uint64_t inInterval);
+    static uint64_t GetBucketLowerBound(size_t inBucket);
+
+    Slot* FindSlot(uint32_t inIdentifier, bool inCreate);
+    const Slot* FindSlot(uint32_t inIdentifier) const;
+
+    uint32_t _bitRate;
+    Slot _slots[maximumIdentifierCount];
+    size_t _slotCount = 0;
+    // Open addressing hash table of slot numbers plus 1, 0 for empty
+    uint16_t _slotNumbers[maximumIdentifierCount * 2];
+    uint64_t _frameCount = 0;
+    uint64_t _bitCount = 0;
+    uint64_t _stuffBitCount = 0;
+    uint64_t _untrackedFrameCount = 0;
+    uint64_t _firstTimestamp = 0;
+    uint64_t _lastTimestamp = 0;
+};
@@ -0,0 +1,280 @@
+#include "CanCapture.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char headerMagic[8] = { 'C', 'A', 'N', 'C', 'A', 'P', '0', '1' };
+    const char trailerMagic[8] = { 'C', 'A', 'N', 'C', 'A', 'P', 'I', 'X' };
+
+    struct Header {
+        char magic[8];
+        uint32_t recordSize;
+        uint32_t reserved;
+    };
+
+    struct Record {
+        // Bits 0-27 are the timestamp relative to the block base, bits 28-31 the data length code
+        uint32_t timestampAndDataLengthCode;
+        uint32_t identifier;
+        uint8_t data[8];
+    };
+    static_assert(sizeof(Record) == 16, "Records must be 16 bytes");
+
+    struct Trailer {
+        uint64_t blockTablePosition;
+        uint64_t blockCount;
+        uint64_t identifierTablePosition;
+        uint64_t identifierCount;
+        uint64_t recordCount;
+        char magic[8];
+    };
+
+    constexpr uint32_t timestampBits = 28;
+    constexpr uint32_t timestampMask = (1u << timestampBits) - 1;
+    // Number of records sharing a base timestamp, unless a block has to be started earlier
+    constexpr uint64_t blockSize = 4096;
+}
+
+CanCaptureWriter::~CanCaptureWriter() {
+    Close();
+}
+
+bool CanCaptureWriter::Open(const char* inPath) {
+    Close();
+    _file = fopen(inPath, "wb");
+    if (_file == nullptr) {
+        return false;
+    }
+    setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+    Header header = {};
+    memcpy(header.magic, headerMagic, sizeof(header.magic));
+    header.recordSize = sizeof(Record);
+    return fwrite(&header, sizeof(header), 1, _file) == 1;
+}
+
+bool CanCaptureWriter::Write(const CanCoder::Frame& inFrame) {
+    if (_file == nullptr || _recordCount == UINT32_MAX) {
+        return false;
+    }
+    if (_blocks.empty() ||
+        _recordCount - _blocks.back().firstRecord >= blockSize ||
+        inFrame.timestamp < _blocks.back().baseTimestamp ||
+        inFrame.timestamp - _blocks.back().baseTimestamp > timestampMask) {
+        _blocks.push_back({ inFrame.timestamp, _recordCount });
+    }
+    Record record;
+    uint8_t dataLengthCode = inFrame.dataLengthCode > 8 ? 8 : inFrame.dataLengthCode;
+    record.timestampAndDataLengthCode = (uint32_t)(inFrame.timestamp - _blocks.back().baseTimestamp) | ((uint32_t)dataLengthCode << timestampBits);
+    record.identifier = inFrame.identifier;
+    memcpy(record.data, inFrame.data, sizeof(record.data));
+    if (fwrite(&record, sizeof(record), 1, _file) != 1) {
+        return false;
+    }
+
+    auto identifierIndex = _identifierIndexes.find(inFrame.identifier);
+    if (identifierIndex == _identifierIndexes.end()) {
+        identifierIndex = _identifierIndexes.emplace(inFrame.identifier, IdentifierIndex{ inFrame.timestamp, inFrame.timestamp, {} }).first;
+    }
+    identifierIndex->second.lastTimestamp = inFrame.timestamp;
+    identifierIndex->second.recordNumbers.push_back(_recordCount);
+    _recordCount++;
+    return true;
+}
+
+bool CanCaptureWriter::Write(const CanCoder::Frame* inFrames, size_t inFrameCount) {
+    for (size_t index = 0; index < inFrameCount; index++) {
+        if (!Write(inFrames[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CanCaptureWriter::Close() {
+    if (_file == nullptr) {
+        return false;
+    }
+    bool success = true;
+    Trailer trailer = {};
+    trailer.recordCount = _recordCount;
+
+    trailer.blockTablePosition = sizeof(Header) + (uint64_t)_recordCount * sizeof(Record);
+    trailer.blockCount = _blocks.size();
+    success &= fwrite(_blocks.data(), sizeof(CanCaptureReader::Block), _blocks.size(), _file) == _blocks.size();
+
+    std::vector<uint32_t> identifiers;
+    for (const auto& identifierIndex : _identifierIndexes) {
+        identifiers.push_back(identifierIndex.first);
+    }
+    std::sort(identifiers.begin(), identifiers.end());
+    trailer.identifierTablePosition = trailer.blockTablePosition + _blocks.size() * sizeof(CanCaptureReader::Block);
+    trailer.identifierCount = identifiers.size();
+    uint64_t recordNumbersPosition = trailer.identifierTablePosition + identifiers.size() * sizeof(CanCaptureReader::IdentifierEntry);
+    for (uint32_t identifier : identifiers) {
+        const IdentifierIndex& identifierIndex = _identifierIndexes[identifier];
+        CanCaptureReader::IdentifierEntry entry = {
+            identifier, (uint32_t)identifierIndex.recordNumbers.size(),
+            identifierIndex.firstTimestamp, identifierIndex.lastTimestamp,
+            recordNumbersPosition
+        };
+        success &= fwrite(&entry, sizeof(entry), 1, _file) == 1;
+        recordNumbersPosition += identifierIndex.recordNumbers.size() * sizeof(uint32_t);
+    }
+    for (uint32_t identifier : identifiers) {
+        const std::vector<uint32_t>& recordNumbers = _identifierIndexes[identifier].recordNumbers;
+        success &= fwrite(recordNumbers.data(), sizeof(uint32_t), recordNumbers.size(), _file) == recordNumbers.size();
+    }
+    memcpy(trailer.magic, trailerMagic, sizeof(trailer.magic));
+    success &= fwrite(&trailer, sizeof(trailer), 1, _file) == 1;
+    success &= fclose(_file) == 0;
+
+    _file = nullptr;
+    _recordCount = 0;
+    _blocks.clear();
+    _identifierIndexes.clear();
+    return success;
+}
+
+CanCaptureReader::~CanCaptureReader() {
+    Close();
+}
+
+bool CanCaptureReader::Open(const char* inPath) {
+    Close();
+    _fileDescriptor = open(inPath, O_RDONLY | O_CLOEXEC);
+    if (_fileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(_fileDescriptor, &fileStatus) != 0 || (size_t)fileStatus.st_size < sizeof(Header) + sizeof(Trailer)) {
+        Close();
+        return false;
+    }
+    void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    _data = (const uint8_t*)data;
+    _size = fileStatus.st_size;
+
+    Header header;
+    Trailer trailer;
+    memcpy(&header, _data, sizeof(header));
+    memcpy(&trailer, _data + _size - sizeof(trailer), sizeof(trailer));
+    uint64_t tablesEnd = _size - sizeof(trailer);
+    // The counts are compared with the space left for their table, so a corrupt count can not overflow a size
+    if (memcmp(header.magic, headerMagic, sizeof(headerMagic)) != 0 ||
+        memcmp(trailer.magic, trailerMagic, sizeof(trailerMagic)) != 0 ||
+        header.recordSize != sizeof(Record) ||
+        trailer.recordCount > UINT32_MAX ||
+        trailer.blockTablePosition != sizeof(Header) + trailer.recordCount * sizeof(Record) ||
+        trailer.blockTablePosition > tablesEnd ||
+        trailer.blockCount > (tablesEnd - trailer.blockTablePosition) / sizeof(Block) ||
+        trailer.identifierTablePosition != trailer.blockTablePosition + trailer.blockCount * sizeof(Block) ||
+        trailer.identifierCount > (tablesEnd - trailer.identifierTablePosition) / sizeof(IdentifierEntry) ||
+        (trailer.recordCount > 0 && trailer.blockCount == 0)) {
+        Close();
+        return false;
+    }
+    _records = _data + sizeof(Header);
+    _recordCount = (uint32_t)trailer.recordCount;
+    _blocks = (const Block*)(_data + trailer.blockTablePosition);
+    _blockCount = trailer.blockCount;
+    _identifierEntries = (const IdentifierEntry*)(_data + trailer.identifierTablePosition);
+    _identifierCount = trailer.identifierCount;
+    // GetTimestamp expects the first block to start at record 0 and the blocks in record order
+    for (size_t index = 0; index < _blockCount; index++) {
+        if (index == 0 ? _blocks[index].firstRecord != 0 : _blocks[index].firstRecord < _blocks[index - 1].firstRecord) {
+            Close();
+            return false;
+        }
+    }
+    for (size_t index = 0; index < _identifierCount; index++) {
+        const IdentifierEntry& entry = _identifierEntries[index];
+        if (entry.recordNumbersPosition % sizeof(uint32_t) != 0 ||
+            entry.recordNumbersPosition > tablesEnd ||
+            entry.recordCount > (tablesEnd - entry.recordNumbersPosition) / sizeof(uint32_t)) {
+            Close();
+            return false;
+        }
+        const uint32_t* recordNumbers = (const uint32_t*)(_data + entry.recordNumbersPosition);
+        for (uint32_t recordIndex = 0; recordIndex < entry.recordCount; recordIndex++) {
+            if (recordNumbers[recordIndex] >= _recordCount) {
+                Close();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void CanCaptureReader::Close() {
+    if (_data != nullptr) {
+        munmap((void*)_data, _size);
+        _data = nullptr;
+        _size = 0;
+    }
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+    _records = nullptr;
+    _recordCount = 0;
+    _blocks = nullptr;
+    _blockCount = 0;
+    _identifierEntries = nullptr;
+    _identifierCount = 0;
+}
+
+uint64_t CanCaptureReader::GetTimestamp(size_t inRecordNumber) const {
+    // The block of a record is the last block starting at or before it
+    const Block* block = std::upper_bound(_blocks, _blocks + _blockCount, inRecordNumber,
+        [](size_t recordNumber, const Block& block) { return recordNumber < block.firstRecord; }) - 1;
+    uint32_t timestampAndDataLengthCode;
+    memcpy(&timestampAndDataLengthCode, _records + inRecordNumber * sizeof(Record), sizeof(timestampAndDataLengthCode));
+    return block->baseTimestamp + (timestampAndDataLengthCode & timestampMask);
+}
+
+void CanCaptureReader::GetFrame(size_t inFrameNumber, CanCoder::Frame& outFrame) const {
+    Record record;
+    memcpy(&record, _records + inFrameNumber * sizeof(Record), sizeof(record));
+    outFrame.identifier = record.identifier;
+    outFrame.dataLengthCode = (uint8_t)(record.timestampAndDataLengthCode >> timestampBits);
+    memcpy(outFrame.data, record.data, sizeof(outFrame.data));
+    outFrame.timestamp = GetTimestamp(inFrameNumber);
+}
+
+size_t CanCaptureReader::GetFrames(size_t inFirstFrameNumber, size_t inFrameCount, CanCoder::Frame* outFrames) const {
+    if (inFirstFrameNumber >= _recordCount) {
+        return 0;
+    }
+    size_t frameCount = std::min(inFrameCount, _recordCount - inFirstFrameNumber);
+    for (size_t index = 0; index < frameCount; index++) {
+        GetFrame(inFirstFrameNumber + index, outFrames[index]);
+    }
+    return frameCount;
+}
+
+std::vector<CanCaptureReader::IdentifierInfo> CanCaptureReader::GetIdentifiers() const {
+    std::vector<IdentifierInfo> identifiers;
+    for (size_t index = 0; index < _identifierCount; index++) {
+        const IdentifierEntry& entry = _identifierEntries[index];
+        identifiers.push_back({ entry.identifier, entry.recordCount, entry.firstTimestamp, entry.lastTimestamp });
+    }
+    return identifiers;
+}
+
+bool CanCaptureReader::FindRecordNumbers(uint32_t inIdentifier, const uint32_t*& outRecordNumbers, uint32_t& outRecordCount) const {
+    const IdentifierEntry* entry = std::lower_bound(_identifierEntries, _identifierEntries + _identifierCount, inIdentifier,
+        [](const IdentifierEntry& entry, uint32_t identifier) { return entry.identifier < identifier; });
+    if (entry == _identifierEntries + _identifierCount || entry->identifier != inIdentifier) {
+        return false;
+    }
+    outRecordNumbers = (const uint32_t*)(_data + entry->recordNumbersPosition);
+    outRecordCount = entry->recordCount;
+    return true;
+}
@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanCapture
+ *
+ * Compact binary capture files of CAN bus frames
+ *
+ * A capture holds CanCoder::Frame records of 16 bytes, 4 times smaller than a text log.
+ * The footer holds an index with for each identifier the numbers of its records and its
+ * first and last timestamp. Reading all frames of one identifier within a time window
+ * jumps directly to those records instead of scanning the whole capture.
+ *
+ * File layout (little endian):
+ * Header        "CANCAP01", record size
+ * Records       16 bytes each:
+ *               bits 0-27 of word 0: timestamp in microseconds relative to the block base
+ *               bits 28-31 of word 0: data length code
+ *               word 1: identifier, bit 31 marks extended identifiers
+ *               8 data bytes
+ * Block table   Base timestamp and first record for each block
+ *               A new block starts every blockSize records, when the relative timestamp
+ *               does not fit in 28 bits or when the timestamp goes back in time
+ * Identifiers   For each identifier its record count, first and last timestamp and the
+ *               position of its record numbers
+ * Record numbers
+ * Trailer       Positions of the tables, "CANCAPIX"
+ *
+ * Time window lookups expect the frames of an identifier to be written in time order.
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+class CanCaptureReader {
+public:
+    /// @brief Time range and number of frames of an identifier in the capture
+    struct IdentifierInfo {
+        uint32_t identifier;
+        uint32_t frameCount;
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+    };
+
+    CanCaptureReader() = default;
+    CanCaptureReader(const CanCaptureReader&) = delete;
+    CanCaptureReader& operator=(const CanCaptureReader&) = delete;
+    ~CanCaptureReader();
+
+    /// @brief Open and memory map a capture file
+    /// @param inPath Path of the capture file
+    /// @return true on success, false when the file can not be mapped or is not a valid capture
+    bool Open(const char* inPath);
+    /// @brief Close the capture file
+    void Close();
+
+    /// @brief Get the number of frames in the capture
+    size_t GetFrameCount() const { return _recordCount; }
+    /// @brief Get a frame
+    /// @param inFrameNumber Number of the frame, must be less than GetFrameCount()
+    /// @param outFrame The frame
+    void GetFrame(size_t inFrameNumber, CanCoder::Frame& outFrame) const;
+    /// @brief Get consecutive frames, for example to pass them to CanCoder::DecodeBatch
+    /// @param inFirstFrameNumber Number of the first frame
+    /// @param inFrameCount Maximum number of frames
+    /// @param outFrames Must be able to hold inFrameCount frames
+    /// @return The number of frames
+    size_t GetFrames(size_t inFirstFrameNumber, size_t inFrameCount, CanCoder::Frame* outFrames) const;
+    /// @brief Get the identifiers in the capture with their time range
+    std::vector<IdentifierInfo> GetIdentifiers() const;
+
+    /// @brief Call a function for each frame in the capture
+    /// @param inCallback Function called as inCallback(const CanCoder::Frame& frame)
+    template <typename Callback>
+    void ForEachFrame(Callback&& inCallback) const {
+        CanCoder::Frame frame;
+        for (size_t frameNumber = 0; frameNumber < _recordCount; frameNumber++) {
+            GetFrame(frameNumber, frame);
+            inCallback(frame);
+        }
+    }
+
+    /// @brief Call a function for each frame of an identifier within a time window, using the index
+    /// @param inIdentifier CAN message identifier
+    /// @param inBeginTimestamp First timestamp of the window
+    /// @param inEndTimestamp Last timestamp of the window
+    /// @param inCallback Function called as inCallback(const CanCoder::Frame& frame)
+    /// @return The number of frames
+    template <typename Callback>
+    size_t ForEachFrame(uint32_t inIdentifier, uint64_t inBeginTimestamp, uint64_t inEndTimestamp, Callback&& inCallback) const {
+        const uint32_t* recordNumbers;
+        uint32_t recordCount;
+        if (!FindRecordNumbers(inIdentifier, recordNumbers, recordCount)) {
+            return 0;
+        }
+        const uint32_t* first = std::lower_bound(recordNumbers, recordNumbers + recordCount, inBeginTimestamp,
+            [this](uint32_t recordNumber, uint64_t timestamp) { return GetTimestamp(recordNumber) < timestamp; });
+        size_t frameCount = 0;
+        CanCoder::Frame frame;
+        for (const uint32_t* recordNumber = first; recordNumber < recordNumbers + recordCount; recordNumber++) {
+            GetFrame(*recordNumber, frame);
+            if (frame.timestamp > inEndTimestamp) {
+                break;
+            }
+            inCallback(frame);
+            frameCount++;
+        }
+        return frameCount;
+    }
+
+private:
+    friend class CanCaptureWriter;
+
+    struct Block {
+        uint64_t baseTimestamp;
+        uint64_t firstRecord;
+    };
+    struct IdentifierEntry {
+        uint32_t identifier;
+        uint32_t recordCount;
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+        uint64_t recordNumbersPosition;
+    };
+
+    uint64_t GetTimestamp(size_t inRecordNumber) const;
+    bool FindRecordNumbers(uint32_t inIdentifier, const uint32_t*& outRecordNumbers, uint32_t& outRecordCount) const;
+
+    int _fileDescriptor = -1;
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    const uint8_t* _records = nullptr;
+    uint32_t _recordCount = 0;
+    const Block* _blocks = nullptr;
+    size_t _blockCount = 0;
+    // Sorted by identifier
+    const IdentifierEntry* _identifierEntries = nullptr;
+    size_t _identifierCount = 0;
+};
+
+class CanCaptureWriter {
+public:
+    CanCaptureWriter() = default;
+    CanCaptureWriter(const CanCaptureWriter&) = delete;
+    CanCaptureWriter& operator=(const CanCaptureWriter&) = delete;
+    ~CanCaptureWriter();
+
+    /// @brief Create a capture file
+    /// @param inPath Path of the capture file
+    /// @return true on success, false on failure
+    bool Open(const char* inPath);
+    /// @brief Write a frame
+    /// @param inFrame The frame
+    /// @return true on success, false on failure
+    bool Write(const CanCoder::Frame& inFrame);
+    /// @brief Write multiple frames
+    /// @param inFrames The frames
+    /// @param inFrameCount Number of frames
+    /// @return true on success, false on failure
+    bool Write(const CanCoder::Frame* inFrames, size_t inFrameCount);
+    /// @brief Write the index and close the capture file
+    /// @return true on success, false on failure
+    bool Close();
+
+private:
+    struct IdentifierIndex {
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+        std::vector<uint32_t> recordNumbers;
+    };
+
+    FILE* _file = nullptr;
+    uint32_t _recordCount = 0;
+    std::vector<CanCaptureReader::Block> _blocks;
+    std::unordered_map<uint32_t, IdentifierIndex> _identifierIndexes;
+};
@@ -0,0 +1,250 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanChannelPool
+ *
+ * Decoding of many buses on a pool of worker threads
+ *
+ * Each channel, for example one bus of one vehicle, has its own CanCoder, a CanFrameQueue
+ * filled by the thread reading that bus and a CanSnapshot with its latest decoded state.
+ * The channels are allocated once, each on its own cache lines.
+ * Every channel has a home worker that decodes it. A worker that has nothing to do steals
+ * channels with pending frames from other workers, so a busy bus does not leave the other
+ * cores idle. A channel is only ever decoded by one worker at a time, guarded by a flag
+ * per channel.
+ * Workers can be pinned to cores, worker n running on core n.
+ * The capacity of the queues is a template parameter, the default of 256 frames keeps a
+ * channel at about 6 KB. A pool of a few busy buses can use larger queues to ride out
+ * longer stalls of the workers.
+ *
+ * The state of all channels can be queried from any thread through the snapshots.
+ *
+ * For example, the highest speed of all vehicles:
+ *     CanChannelPool<> pool(vehicleCount);
+ *     pool.Start(4);
+ *
+ *     // Thread reading the bus of vehicle n
+ *     pool.Push(n, frame);
+ *
+ *     // Any thread
+ *     int maximumSpeed = 0;
+ *     pool.ForEachChannel([&](size_t channel, const CanCoder& state) {
+ *         maximumSpeed = std::max(maximumSpeed, state._vehicleSpeed.speed);
+ *     });
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: the queue capacity is a template parameter
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include "CanFrameQueue.h"
+#include "CanSnapshot.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// @brief Pool of workers decoding many channels
+/// @tparam QueueCapacity Number of frames each channel can queue, must be a power of 2
+template <size_t QueueCapacity = 256>
+class CanChannelPool {
+public:
+    /// @brief Number of frames each channel can queue
+    static constexpr size_t queueCapacity = QueueCapacity;
+    /// @brief Maximum number of frames decoded before a worker moves on to the next channel
+    static constexpr size_t batchSize = 64;
+
+    /// @brief Statistics of a channel
+    struct ChannelStatistics {
+        uint64_t frameCount;
+        uint64_t decodedCount;
+        uint64_t droppedCount;
+        // Batches decoded by another worker than the home worker
+        uint64_t stolenBatchCount;
+    };
+
+    /// @param inChannelCount Number of channels
+    explicit CanChannelPool(size_t inChannelCount) :
+        _channelCount(inChannelCount),
+        _channels(new Channel[inChannelCount]) {
+    }
+    CanChannelPool(const CanChannelPool&) = delete;
+    CanChannelPool& operator=(const CanChannelPool&) = delete;
+    ~CanChannelPool() {
+        Stop();
+    }
+
+    /// @brief Start the workers
+    /// @param inWorkerCount Number of workers, 0 for one worker per core
+    /// @param inPinWorkers When true, worker n is pinned to core n (Linux only)
+    /// @return true on success, false when the workers are already running
+    bool Start(unsigned inWorkerCount = 0, bool inPinWorkers = false) {
+        if (_running.exchange(true)) {
+            return false;
+        }
+        if (inWorkerCount == 0) {
+            inWorkerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        _workerCount = inWorkerCount;
+        for (unsigned worker = 0; worker < _workerCount; worker++) {
+            _workers.emplace_back(&CanChannelPool::Work, this, worker, inPinWorkers);
+        }
+        return true;
+    }
+    /// @brief Stop the workers, frames that were not decoded yet stay queued
+    void Stop() {
+        _running.store(false);
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+        _workers.clear();
+    }
+
+    /// @brief Get the number of channels
+    size_t GetChannelCount() const { return _channelCount; }
+    /// @brief Queue a frame for decoding, only to be called by the one thread feeding the channel
+    /// @param inChannel The channel
+    /// @param inFrame The frame
+    /// @return true on success, false when the queue of the channel is full and the frame was dropped
+    bool Push(size_t inChannel, const CanCoder::Frame& inFrame) {
+        return _channels[inChannel].queue.Push(inFrame);
+    }
+    /// @brief Queue frames for decoding, only to be called by the one thread feeding the channel
+    /// @param inChannel The channel
+    /// @param inFrames The frames
+    /// @param inFrameCount Number of frames
+    /// @return The number of frames queued, the remaining frames were dropped
+    size_t Push(size_t inChannel, const CanCoder::Frame* inFrames, size_t inFrameCount) {
+        return _channels[inChannel].queue.PushBatch(inFrames, inFrameCount);
+    }
+
+    /// @brief Read the latest decoded state of a channel, from any thread
+    /// @param inChannel The channel
+    /// @param outCoder Receives the state
+    /// @return The version of the state, it increases with every batch decoded
+    uint64_t Read(size_t inChannel, CanCoder& outCoder) const {
+        return _channels[inChannel].snapshot.Read(outCoder);
+    }
+    /// @brief Call a function with the latest decoded state of each channel, from any thread
+    /// @param inCallback Function called as inCallback(size_t channel, const CanCoder& state)
+    template <typename Callback>
+    void ForEachChannel(Callback&& inCallback) const {
+        CanCoder state;
+        for (size_t channel = 0; channel < _channelCount; channel++) {
+            _channels[channel].snapshot.Read(state);
+            inCallback(channel, (const CanCoder&)state);
+        }
+    }
+    /// @brief Get the statistics of a channel, from any thread
+    ChannelStatistics GetStatistics(size_t inChannel) const {
+        const Channel& channel = _channels[inChannel];
+        return {
+            channel.frameCount.load(std::memory_order_relaxed),
+            channel.decodedCount.load(std::memory_order_relaxed),
+            channel.queue.GetDroppedCount(),
+            channel.stolenBatchCount.load(std::memory_order_relaxed)
+        };
+    }
+
+private:
+    struct alignas(64) Channel {
+        // Set by the worker decoding the channel
+        std::atomic<bool> busy{ false };
+        std::atomic<uint64_t> frameCount{ 0 };
+        std::atomic<uint64_t> decodedCount{ 0 };
+        std::atomic<uint64_t> stolenBatchCount{ 0 };
+        CanCoder coder;
+        CanFrameQueue<QueueCapacity> queue;
+        CanSnapshot snapshot;
+    };
+
+    void Work(unsigned inWorker, bool inPinWorker) {
+#if defined(__linux__)
+        if (inPinWorker) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(inWorker % CPU_SETSIZE, &cpuSet);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        }
+#endif
+        unsigned idleRounds = 0;
+        while (_running.load(std::memory_order_relaxed)) {
+            // Home channels are channel n with n % workerCount equal to the worker
+            size_t frameCount = 0;
+            for (size_t channel = inWorker; channel < _channelCount; channel += _workerCount) {
+                frameCount += DecodeChannel(channel, false);
+            }
+            if (frameCount == 0) {
+                // Steal the channel with the most pending frames
+                size_t busiestChannel = _channelCount;
+                size_t busiestSize = 0;
+                for (size_t channel = 0; channel < _channelCount; channel++) {
+                    size_t size = _channels[channel].queue.GetSize();
+                    if (channel % _workerCount != inWorker && size > busiestSize && !_channels[channel].busy.load(std::memory_order_relaxed)) {
+                        busiestChannel = channel;
+                        busiestSize = size;
+                    }
+                }
+                if (busiestChannel < _channelCount) {
+                    frameCount = DecodeChannel(busiestChannel, true);
+                }
+            }
+            if (frameCount != 0) {
+                idleRounds = 0;
+            }
+            else if (++idleRounds < 64) {
+                std::this_thread::yield();
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+    // Decode a batch of a channel when it is not busy, returns the number of frames decoded
+    size_t DecodeChannel(size_t inChannel, bool inStolen) {
+        Channel& channel = _channels[inChannel];
+        if (channel.queue.GetSize() == 0) {
+            return 0;
+        }
+        // The flag makes the worker the only consumer of the queue and the only user of the coder
+        bool busy = false;
+        if (!channel.busy.compare_exchange_strong(busy, true, std::memory_order_acquire)) {
+            return 0;
+        }
+        CanCoder::Frame frames[batchSize];
+        size_t frameCount = channel.queue.PopBatch(frames, batchSize);
+        if (frameCount != 0) {
+            size_t decodedCount = channel.coder.DecodeBatch(frames, frameCount, nullptr);
+            channel.snapshot.Publish(channel.coder);
+            channel.frameCount.fetch_add(frameCount, std::memory_order_relaxed);
+            channel.decodedCount.fetch_add(decodedCount, std::memory_order_relaxed);
+            if (inStolen) {
+                channel.stolenBatchCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        channel.busy.store(false, std::memory_order_release);
+        return frameCount;
+    }
+
+    size_t _channelCount;
+    std::unique_ptr<Channel[]> _channels;
+    std::vector<std::thread> _workers;
+    unsigned _workerCount = 0;
+    std::atomic<bool> _running{ false };
+};
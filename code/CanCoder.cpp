@@ -1,469 +1,1176 @@
 #include "CanCoder.h"
-#include <sstream>
-#include <iomanip>
+#include "CanSignal.h"
+#include <stddef.h>
+#include <string.h>
+#include <charconv>
+#if CANCODER_STATISTICS && CANCODER_LATENCY_SAMPLE_INTERVAL > 0
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
 
-bool CanCoder::Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData) {
-    _identifier = (Identifier)inIdentifier;
+namespace {
+    // Signals
+    // Decoders and encoders of the same message use the same description
 
-    if (inDataLengthCode > 8) {
-        return false;
+    namespace DoorStatusSignals {
+        // The open status is in bit 0 of byte 3
+        using Open = CanSignal<24, 1>;
+        // The lock status is in bits 0 and 1 of byte 0, the door is unlocked when it is 1
+        using Lock = CanSignal<0, 2>;
     }
 
-    switch ((Identifier)inIdentifier) {
-    case Identifier::frontPassengerSideDoorStatus:
-        if (inDataLengthCode >= 4) {
-            // The open status is in bit 0 of byte 3
-            _frontPassengerSideDoorStatus.open = (inData[3] & 0x01) != 0x00;
-            // The lock status is in bits 0 and 1 of byte 0
-            _frontPassengerSideDoorStatus.locked = (inData[0] & 0x03) != 0x01;
-            return true;
-        }
-        break;
-    case Identifier::rearPassengerSideDoorStatus:
-        if (inDataLengthCode >= 4) {
-            // The open status is in bit 0 of byte 3
-            _rearPassengerSideDoorStatus.open = (inData[3] & 0x01) != 0x00;
-            // The lock status is in bits 0 and 1 of byte 0
-            _rearPassengerSideDoorStatus.locked = (inData[0] & 0x03) != 0x01;
-            return true;
-        }
-        break;
-    case Identifier::frontDriverSideDoorStatus:
-        if (inDataLengthCode >= 4) {
-            // The open status is in bit 0 of byte 3
-            _frontDriverSideDoorStatus.open = (inData[3] & 0x01) != 0x00;
-            // The lock status is in bits 0 and 1 of byte 0
-            _frontDriverSideDoorStatus.locked = (inData[0] & 0x03) != 0x01;
-            return true;
-        }
-        break;
-    case Identifier::rearDriverSideDoorStatus:
-        if (inDataLengthCode >= 4) {
-            // The open status is in bit 0 of byte 3
-            _rearDriverSideDoorStatus.open = (inData[3] & 0x01) != 0x00;
-            // The lock status is in bits 0 and 1 of byte 0
-            _rearDriverSideDoorStatus.locked = (inData[0] & 0x03) != 0x01;
-            return true;
-        }
-        break;
-    case Identifier::mirrorFoldStatus:
-        if (inDataLengthCode >= 1) {
-            // Byte 0 will be F7 when the mirrors are being folded
-            _mirrorFoldStatus.folded = inData[0] == 0xF7;
-            return true;
-        }
-        break;
-    case Identifier::ignitionAndKeyLocation:
-        if (inDataLengthCode >= 4) {
-            // When the key is outside bytes 1 and 3 will be 0E/04 or 01/06 (door handle button is pushed)
-            _ignitionAndKeyLocation.keyIsOutside =
-                (inData[1] == 0x0E && inData[3] == 0x04) ||
-                (inData[1] == 0x01 && inData[3] == 0x06);
-            return true;
-        }
-        break;
-    case Identifier::vehicleSpeed:
-        if (inDataLengthCode >= 2) {
-            // The vehicle speed is in the first 12 bits of bytes 0 and 1
-            // The unit is 0.1 km/h
-            _vehicleSpeed.speed = inData[0] + ((inData[1] & 0x0F) << 8);
-            return true;
-        }
-        break;
-    case Identifier::iDriveControler:
-        if (inDataLengthCode >= 4) {
-            // The stick direction is encoded in byte 0
-            // Each direction has a value rather than using seperate bits
-            _iDriveController.stickUp = (inData[0] & 0x0f) == 0x00;
-            _iDriveController.stickRight = (inData[0] & 0x0f) == 0x02;
-            _iDriveController.stickDown = (inData[0] & 0x0f) == 0x04;
-            _iDriveController.stickLeft = (inData[0] & 0x0f) == 0x06;
-            // The buttons are encoded in bits 0, 2 and 4 of byte 1
-            _iDriveController.stickPush = (inData[1] & 0x01) != 0;
-            _iDriveController.homeButton = (inData[1] & 0x04) != 0;
-            _iDriveController.menuButton = (inData[1] & 0x10) != 0;
-            // The dial value is encode in bytes 2 and 3
-            _iDriveController.dialValue = inData[2] + (inData[3] << 8);
-            _iDriveController.additionalData.dataLengthCode = inDataLengthCode;
-            for (int index = 4; index < inDataLengthCode; index++) {
-                _iDriveController.additionalData.uncodedData[index - 4] = inData[index];
-            }
-            return true;
-        }
-        break;
-    case Identifier::gearShifterPosition:
-        if (inDataLengthCode >= 1) {
-            // The automatic gear shifter position is encoded in bits 0-3 of byte 0
-            // Bits 0-3 respectively represent P-R-N-D
-            // Bits 4-7 are an inverted version of bits 0-3
-            if ((inData[0] & 0x01) != 0)
-            {
-                _gearShifterPosition.position = 'P';
-            }
-            else if ((inData[0] & 0x02) != 0)
-            {
-                _gearShifterPosition.position = 'R';
-            }
-            else if ((inData[0] & 0x04) != 0)
-            {
-                _gearShifterPosition.position = 'N';
-            }
-            else if ((inData[0] & 0x08) != 0)
-            {
-                _gearShifterPosition.position = 'D';
-            }
-            _gearShifterPosition.additionalData.dataLengthCode = inDataLengthCode;
-            for (int index = 1; index < inDataLengthCode; index++) {
-                _gearShifterPosition.additionalData.uncodedData[index - 1] = inData[index];
-            }
-            return true;
-        }
-        break;
-    case Identifier::remoteControlAndDoorHandleInput:
-        if (inDataLengthCode >= 3) {
-            // Bits 0 and 1 of byte 1 are zero when the input comes from the remote control
-            // They are 3 when it comes from the door handle
-            bool comingFromRemoteControl = (inData[1] & 0x03) == 0;
-            // Bit 0 of byte 2 represents the unlock button
-            bool unlockButton = (inData[2] & 0x01) != 0;
-            if (comingFromRemoteControl) {
-                _remoteControlAndDoorHandleInput.remoteControlUnlockButton = unlockButton;
-            }
-            else {
-                _remoteControlAndDoorHandleInput.doorHandleUnlockButton = unlockButton;
-            }
-            // Bit 2 of byte 2 represents the lock button
-            bool lockButton = (inData[2] & 0x04) != 0;
-            if (comingFromRemoteControl) {
-                _remoteControlAndDoorHandleInput.remoteControlLockButton = lockButton;
-            }
-            else {
-                _remoteControlAndDoorHandleInput.doorHandleLockButton = lockButton;
-            }
-            return true;
-        }
-        break;
-    case Identifier::windowRoofAndMirrorControl:
-        if (inDataLengthCode >= 4) {
-            // Closing action for the windows and roof is encode with 0x1b in bytes 0 and 2
-            // Byte 3 should be 0x52
-            _windowRoofAndMirrorControl.closeWindowsAndRoof = inData[0] == 0x1b && inData[2] == 0x1b && inData[3] == 0x52;
-            // Folding action for the mirrors is encode with 0x1b in byte 1
-            // Byte 3 should be 0x52
-            _windowRoofAndMirrorControl.foldMirrors = inData[1] == 0x1b && inData[3] == 0x52;
-            _windowRoofAndMirrorControl.additionalData.dataLengthCode = inDataLengthCode;
-            for (int index = 4; index < inDataLengthCode; index++) {
-                _windowRoofAndMirrorControl.additionalData.uncodedData[index - 4] = inData[index];
-            }
-            return true;
-        }
-        break;
-    case Identifier::doorLockControl:
-        if (inDataLengthCode >= 4) {
-            // Door locking action is encoded in bytes 0-3
-            _doorLockControl.lockDoors = inData[0] == 0x33 && inData[1] == 0x33 && inData[2] == 0x38 && inData[3] == 0x00;
-            _doorLockControl.additionalData.dataLengthCode = inDataLengthCode;
-            for (int index = 4; index < inDataLengthCode; index++) {
-                _doorLockControl.additionalData.uncodedData[index - 4] = inData[index];
-            }
-            return true;
-        }
-        break;
-    case Identifier::dateTime:
-    case Identifier::setDateTime:
-        if (inDataLengthCode >= 7) {
-            // The year is in byte 5 and 6
-            _dateTime.year = inData[5] + (inData[6] << 8);
-            // The month is in bits 4-7 of byte 4
-            _dateTime.month = inData[4] >> 4;
-            // The day is in byte 3
-            _dateTime.day = inData[3];
-            // The hour is in byte 0
-            _dateTime.hour = inData[0];
-            // The minute is in byte 1
-            _dateTime.minute = inData[1];
-            // The second is in byte 2
-            _dateTime.second = inData[2];
-            _dateTime.additionalData.dataLengthCode = inDataLengthCode;
-            if (inDataLengthCode == 8) {
-                _dateTime.additionalData.uncodedDataByte7 = inData[7];
-            }
-            return true;
-        }
-        break;
-    case Identifier::passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus:
-        if (inDataLengthCode >= 2) {
-            // The seatbelt status is in bit 0 of byte 1
-            _passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.seatbeltFastened = (inData[1] & 0x01) == 0x01;
-            // When bits 2, 5 and 6 are 1 the seat is occupied
-            _passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.occupied = (inData[1] & 0x64) == 0x64;
-            return true;
-        }
-        break;
-    case Identifier::doorOpenStatuses:
-        if (inDataLengthCode >= 3) {
-            // The front driver side door open status is in bit 0 of byte 1
-            _doorOpenStatuses.frontDriverSideDoorIsOpen = (inData[1] & 0x01) != 0;
-            // The front passenger side door open status is in bit 2 of byte 1
-            _doorOpenStatuses.frontPassengerSideDoorIsOpen = (inData[1] & 0x04) != 0;
-            // The rear driver side door open status is in bit 4 of byte 1
-            _doorOpenStatuses.rearDriverSideDoorIsOpen = (inData[1] & 0x10) != 0;
-            // The rear passenger side door open status is in bit 6 of byte 1
-            _doorOpenStatuses.rearPassengerSideDoorIsOpen = (inData[1] & 0x40) != 0;
-            // The boot open status is in bit 0 of byte 2
-            _doorOpenStatuses.bootIsOpen = (inData[2] & 0x01) != 0;
-            // The bonnet open status is in bit 2 of byte 2
-            _doorOpenStatuses.bonnetIsOpen = (inData[2] & 0x04) != 0;
-            return true;
-        }
-        break;
-    case Identifier::handbrakeStatus:
-        if (inDataLengthCode >= 1) {
-            // Bits 0 and 1 of byte 0 are 2 when the handbrake is active
-            _handbrakeStatus.handbrakeIsActive = (inData[0] & 0x03) == 0x02;
-            return true;
-        }
-        break;
-    default:
-        break;
+    namespace MirrorFoldStatusSignals {
+        // Byte 0 will be F7 when the mirrors are being folded
+        using State = CanSignal<0, 8>;
     }
 
-    return false;
-}
+    namespace IgnitionAndKeyLocationSignals {
+        // When the key is outside bytes 1 and 3 will be 0E/04 or 01/06 (door handle button is pushed)
+        using KeyLocation1 = CanSignal<8, 8>;
+        using KeyLocation2 = CanSignal<24, 8>;
+    }
 
-void CanCoder::Encode(uint32_t& outIdentifier, uint8_t& outDataLengthCode, uint8_t* outData) {
-    outIdentifier = (uint32_t)_identifier;
-    switch (_identifier) {
-    case Identifier::iDriveControler:
-        // The stick direction is encoded in byte 0
+    namespace VehicleSpeedSignals {
+        // The vehicle speed is in the first 12 bits of bytes 0 and 1
+        // The unit is 0.1 km/h, _vehicleSpeed.speed holds the raw value
+        using Speed = CanSignal<0, 12>;
+    }
+
+    namespace IDriveControllerSignals {
+        // The stick direction is encoded in bits 0-3 of byte 0
         // Each direction has a value rather than using seperate bits
-        if (_iDriveController.stickUp) {
-            outData[0] = 0x00;
+        using StickDirection = CanSignal<0, 4>;
+        // The buttons are encoded in bits 0, 2 and 4 of byte 1
+        using StickPush = CanSignal<8, 1>;
+        using HomeButton = CanSignal<10, 1>;
+        using MenuButton = CanSignal<12, 1>;
+        // Bits 6 and 7 of byte 1 are always 1
+        using AlwaysSet = CanSignal<14, 2>;
+        // The dial value is encoded in bytes 2 and 3
+        using DialValue = CanSignal<16, 16>;
+    }
+
+    namespace GearShifterPositionSignals {
+        // The automatic gear shifter position is encoded in bits 0-3 of byte 0
+        // Bits 0-3 respectively represent P-R-N-D
+        using Position = CanSignal<0, 4>;
+        // Bits 4-7 are an inverted version of bits 0-3
+        using InvertedPosition = CanSignal<4, 4>;
+    }
+
+    namespace RemoteControlAndDoorHandleInputSignals {
+        // Bits 0 and 1 of byte 1 are zero when the input comes from the remote control
+        // They are 3 when it comes from the door handle
+        using Source = CanSignal<8, 2>;
+        // Bit 0 of byte 2 represents the unlock button
+        using UnlockButton = CanSignal<16, 1>;
+        // Bit 2 of byte 2 represents the lock button
+        using LockButton = CanSignal<18, 1>;
+    }
+
+    namespace WindowRoofAndMirrorControlSignals {
+        // Closing action for the windows and roof is encoded with 0x1b in bytes 0 and 2
+        using CloseWindows = CanSignal<0, 8>;
+        using CloseRoof = CanSignal<16, 8>;
+        // Folding action for the mirrors is encoded with 0x1b in byte 1
+        using FoldMirrors = CanSignal<8, 8>;
+        // Byte 3 is 0x52 when any action is performed, 0x50 for no action
+        using Action = CanSignal<24, 8>;
+    }
+
+    namespace DoorLockControlSignals {
+        // Door locking action is encoded in bytes 0-3 as 33 33 38 00
+        using Action = CanSignal<0, 32>;
+        constexpr uint32_t lockDoors = 0x00383333;
+    }
+
+    namespace DateTimeSignals {
+        // The hour is in byte 0
+        using Hour = CanSignal<0, 8>;
+        // The minute is in byte 1
+        using Minute = CanSignal<8, 8>;
+        // The second is in byte 2
+        using Second = CanSignal<16, 8>;
+        // The day is in byte 3
+        using Day = CanSignal<24, 8>;
+        // Bits 0-3 of byte 4 are set to 1 when encoding
+        using Filler = CanSignal<32, 4>;
+        // The month is in bits 4-7 of byte 4
+        using Month = CanSignal<36, 4>;
+        // The year is in byte 5 and 6
+        using Year = CanSignal<40, 16>;
+    }
+
+    namespace PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusSignals {
+        // The seatbelt status is in bit 0 of byte 1
+        using SeatbeltFastened = CanSignal<8, 1>;
+        // When bits 2, 5 and 6 of byte 1 are 1 the seat is occupied
+        using Occupancy = CanSignal<8, 8>;
+        constexpr uint32_t occupied = 0x64;
+    }
+
+    namespace DoorOpenStatusesSignals {
+        // The door open statuses are in bits 0, 2, 4 and 6 of byte 1
+        using FrontDriverSideDoorIsOpen = CanSignal<8, 1>;
+        using FrontPassengerSideDoorIsOpen = CanSignal<10, 1>;
+        using RearDriverSideDoorIsOpen = CanSignal<12, 1>;
+        using RearPassengerSideDoorIsOpen = CanSignal<14, 1>;
+        // The boot and bonnet open statuses are in bits 0 and 2 of byte 2
+        using BootIsOpen = CanSignal<16, 1>;
+        using BonnetIsOpen = CanSignal<18, 1>;
+    }
+
+    namespace HandbrakeStatusSignals {
+        // Bits 0 and 1 of byte 0 are 2 when the handbrake is active
+        using State = CanSignal<0, 2>;
+    }
+
+    // Decoders
+    // They are only called when the data length is at least the minimum of the message
+    // The data length is in bytes, for CAN FD messages it can be more than 8
+    // Decoders that keep no additional data leave the data length unnamed
+
+    void DecodeFrontPassengerSideDoorStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._frontPassengerSideDoorStatus.open = DoorStatusSignals::Open::Extract(inData) != 0;
+        coder._frontPassengerSideDoorStatus.locked = DoorStatusSignals::Lock::Extract(inData) != 0x01;
+    }
+
+    void DecodeRearPassengerSideDoorStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._rearPassengerSideDoorStatus.open = DoorStatusSignals::Open::Extract(inData) != 0;
+        coder._rearPassengerSideDoorStatus.locked = DoorStatusSignals::Lock::Extract(inData) != 0x01;
+    }
+
+    void DecodeFrontDriverSideDoorStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._frontDriverSideDoorStatus.open = DoorStatusSignals::Open::Extract(inData) != 0;
+        coder._frontDriverSideDoorStatus.locked = DoorStatusSignals::Lock::Extract(inData) != 0x01;
+    }
+
+    void DecodeRearDriverSideDoorStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._rearDriverSideDoorStatus.open = DoorStatusSignals::Open::Extract(inData) != 0;
+        coder._rearDriverSideDoorStatus.locked = DoorStatusSignals::Lock::Extract(inData) != 0x01;
+    }
+
+    void DecodeMirrorFoldStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._mirrorFoldStatus.folded = MirrorFoldStatusSignals::State::Extract(inData) == 0xF7;
+    }
+
+    void DecodeIgnitionAndKeyLocation(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        uint32_t keyLocation1 = IgnitionAndKeyLocationSignals::KeyLocation1::Extract(inData);
+        uint32_t keyLocation2 = IgnitionAndKeyLocationSignals::KeyLocation2::Extract(inData);
+        coder._ignitionAndKeyLocation.keyIsOutside =
+            (keyLocation1 == 0x0E && keyLocation2 == 0x04) ||
+            (keyLocation1 == 0x01 && keyLocation2 == 0x06);
+    }
+
+    void DecodeVehicleSpeed(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._vehicleSpeed.speed = VehicleSpeedSignals::Speed::Extract(inData);
+    }
+
+    void DecodeIDriveController(CanCoder& coder, uint8_t inDataLength, const uint8_t* inData) {
+        uint32_t stickDirection = IDriveControllerSignals::StickDirection::Extract(inData);
+        coder._iDriveController.stickUp = stickDirection == 0x00;
+        coder._iDriveController.stickRight = stickDirection == 0x02;
+        coder._iDriveController.stickDown = stickDirection == 0x04;
+        coder._iDriveController.stickLeft = stickDirection == 0x06;
+        coder._iDriveController.stickPush = IDriveControllerSignals::StickPush::Extract(inData) != 0;
+        coder._iDriveController.homeButton = IDriveControllerSignals::HomeButton::Extract(inData) != 0;
+        coder._iDriveController.menuButton = IDriveControllerSignals::MenuButton::Extract(inData) != 0;
+        coder._iDriveController.dialValue = IDriveControllerSignals::DialValue::Extract(inData);
+        coder._iDriveController.additionalData.dataLengthCode = inDataLength;
+        if (inDataLength > 4) {
+            memcpy(coder._iDriveController.additionalData.uncodedData, &inData[4], inDataLength - 4);
         }
-        else if (_iDriveController.stickRight) {
-            outData[0] = 0x02;
+    }
+
+    void DecodeGearShifterPosition(CanCoder& coder, uint8_t inDataLength, const uint8_t* inData) {
+        // Bits 0-3 respectively represent P-R-N-D
+        uint32_t position = GearShifterPositionSignals::Position::Extract(inData);
+        if ((position & 0x01) != 0)
+        {
+            coder._gearShifterPosition.position = 'P';
+        }
+        else if ((position & 0x02) != 0)
+        {
+            coder._gearShifterPosition.position = 'R';
         }
-        else if (_iDriveController.stickDown) {
-            outData[0] = 0x04;
+        else if ((position & 0x04) != 0)
+        {
+            coder._gearShifterPosition.position = 'N';
         }
-        else if (_iDriveController.stickLeft) {
-            outData[0] = 0x06;
+        else if ((position & 0x08) != 0)
+        {
+            coder._gearShifterPosition.position = 'D';
+        }
+        coder._gearShifterPosition.additionalData.dataLengthCode = inDataLength;
+        if (inDataLength > 1) {
+            memcpy(coder._gearShifterPosition.additionalData.uncodedData, &inData[1], inDataLength - 1);
+        }
+    }
+
+    void DecodeRemoteControlAndDoorHandleInput(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        bool comingFromRemoteControl = RemoteControlAndDoorHandleInputSignals::Source::Extract(inData) == 0;
+        bool unlockButton = RemoteControlAndDoorHandleInputSignals::UnlockButton::Extract(inData) != 0;
+        if (comingFromRemoteControl) {
+            coder._remoteControlAndDoorHandleInput.remoteControlUnlockButton = unlockButton;
         }
         else {
-            outData[0] = 0x0f;
+            coder._remoteControlAndDoorHandleInput.doorHandleUnlockButton = unlockButton;
         }
-        // The buttons are encoded in bits 0, 2 and 4 of byte 1
-        // Bits 6 and 7 are always 1
-        outData[1] =
-            (_iDriveController.stickPush ? 0x01 : 0) |
-            (_iDriveController.homeButton ? 0x04 : 0) |
-            (_iDriveController.menuButton ? 0x10 : 0) |
-            0xc0;
-        // The dial value is encode in bytes 2 and 3
-        outData[2] = _iDriveController.dialValue & 0xff;
-        outData[3] = (_iDriveController.dialValue >> 8) & 0xff;
-        outDataLengthCode = _iDriveController.additionalData.dataLengthCode;
-        if (outDataLengthCode < 4) {
-            outDataLengthCode = 4;
-        }
-        for (int index = 4; index < _iDriveController.additionalData.dataLengthCode; index++) {
-            outData[index] = _iDriveController.additionalData.uncodedData[index - 4];
-        }
-        break;
-    case Identifier::gearShifterPosition:
+        bool lockButton = RemoteControlAndDoorHandleInputSignals::LockButton::Extract(inData) != 0;
+        if (comingFromRemoteControl) {
+            coder._remoteControlAndDoorHandleInput.remoteControlLockButton = lockButton;
+        }
+        else {
+            coder._remoteControlAndDoorHandleInput.doorHandleLockButton = lockButton;
+        }
+    }
+
+    void DecodeWindowRoofAndMirrorControl(CanCoder& coder, uint8_t inDataLength, const uint8_t* inData) {
+        bool action = WindowRoofAndMirrorControlSignals::Action::Extract(inData) == 0x52;
+        coder._windowRoofAndMirrorControl.closeWindowsAndRoof =
+            WindowRoofAndMirrorControlSignals::CloseWindows::Extract(inData) == 0x1b &&
+            WindowRoofAndMirrorControlSignals::CloseRoof::Extract(inData) == 0x1b &&
+            action;
+        coder._windowRoofAndMirrorControl.foldMirrors = WindowRoofAndMirrorControlSignals::FoldMirrors::Extract(inData) == 0x1b && action;
+        coder._windowRoofAndMirrorControl.additionalData.dataLengthCode = inDataLength;
+        if (inDataLength > 4) {
+            memcpy(coder._windowRoofAndMirrorControl.additionalData.uncodedData, &inData[4], inDataLength - 4);
+        }
+    }
+
+    void DecodeDoorLockControl(CanCoder& coder, uint8_t inDataLength, const uint8_t* inData) {
+        coder._doorLockControl.lockDoors = DoorLockControlSignals::Action::Extract(inData) == DoorLockControlSignals::lockDoors;
+        coder._doorLockControl.additionalData.dataLengthCode = inDataLength;
+        if (inDataLength > 4) {
+            memcpy(coder._doorLockControl.additionalData.uncodedData, &inData[4], inDataLength - 4);
+        }
+    }
+
+    void DecodeDateTime(CanCoder& coder, uint8_t inDataLength, const uint8_t* inData) {
+        coder._dateTime.year = DateTimeSignals::Year::Extract(inData);
+        coder._dateTime.month = DateTimeSignals::Month::Extract(inData);
+        coder._dateTime.day = DateTimeSignals::Day::Extract(inData);
+        coder._dateTime.hour = DateTimeSignals::Hour::Extract(inData);
+        coder._dateTime.minute = DateTimeSignals::Minute::Extract(inData);
+        coder._dateTime.second = DateTimeSignals::Second::Extract(inData);
+        coder._dateTime.additionalData.dataLengthCode = inDataLength;
+        if (inDataLength > 7) {
+            memcpy(coder._dateTime.additionalData.uncodedData, &inData[7], inDataLength - 7);
+        }
+    }
+
+    void DecodePassengerSideFrontSeatSeatbeltAndSeatOccupancyStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.seatbeltFastened =
+            PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusSignals::SeatbeltFastened::Extract(inData) != 0;
+        coder._passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.occupied =
+            (PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusSignals::Occupancy::Extract(inData) & PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusSignals::occupied) ==
+            PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusSignals::occupied;
+    }
+
+    void DecodeDoorOpenStatuses(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._doorOpenStatuses.frontDriverSideDoorIsOpen = DoorOpenStatusesSignals::FrontDriverSideDoorIsOpen::Extract(inData) != 0;
+        coder._doorOpenStatuses.frontPassengerSideDoorIsOpen = DoorOpenStatusesSignals::FrontPassengerSideDoorIsOpen::Extract(inData) != 0;
+        coder._doorOpenStatuses.rearDriverSideDoorIsOpen = DoorOpenStatusesSignals::RearDriverSideDoorIsOpen::Extract(inData) != 0;
+        coder._doorOpenStatuses.rearPassengerSideDoorIsOpen = DoorOpenStatusesSignals::RearPassengerSideDoorIsOpen::Extract(inData) != 0;
+        coder._doorOpenStatuses.bootIsOpen = DoorOpenStatusesSignals::BootIsOpen::Extract(inData) != 0;
+        coder._doorOpenStatuses.bonnetIsOpen = DoorOpenStatusesSignals::BonnetIsOpen::Extract(inData) != 0;
+    }
+
+    void DecodeHandbrakeStatus(CanCoder& coder, uint8_t, const uint8_t* inData) {
+        coder._handbrakeStatus.handbrakeIsActive = HandbrakeStatusSignals::State::Extract(inData) == 0x02;
+    }
+
+    // Encoders
+
+    void EncodeIDriveController(CanCoder& coder, uint8_t& outDataLength, uint8_t* outData) {
+        // Bits that are not part of a signal are 0
+        outData[0] = 0;
+        outData[1] = 0;
+        if (coder._iDriveController.stickUp) {
+            IDriveControllerSignals::StickDirection::Insert(outData, 0x00);
+        }
+        else if (coder._iDriveController.stickRight) {
+            IDriveControllerSignals::StickDirection::Insert(outData, 0x02);
+        }
+        else if (coder._iDriveController.stickDown) {
+            IDriveControllerSignals::StickDirection::Insert(outData, 0x04);
+        }
+        else if (coder._iDriveController.stickLeft) {
+            IDriveControllerSignals::StickDirection::Insert(outData, 0x06);
+        }
+        else {
+            IDriveControllerSignals::StickDirection::Insert(outData, 0x0f);
+        }
+        IDriveControllerSignals::StickPush::Insert(outData, coder._iDriveController.stickPush);
+        IDriveControllerSignals::HomeButton::Insert(outData, coder._iDriveController.homeButton);
+        IDriveControllerSignals::MenuButton::Insert(outData, coder._iDriveController.menuButton);
+        IDriveControllerSignals::AlwaysSet::Insert(outData, 0x03);
+        IDriveControllerSignals::DialValue::Insert(outData, coder._iDriveController.dialValue);
+        outDataLength = coder._iDriveController.additionalData.dataLengthCode;
+        if (outDataLength < 4) {
+            outDataLength = 4;
+        }
+        if (coder._iDriveController.additionalData.dataLengthCode > 4) {
+            memcpy(&outData[4], coder._iDriveController.additionalData.uncodedData, coder._iDriveController.additionalData.dataLengthCode - 4);
+        }
+    }
+
+    void EncodeGearShifterPosition(CanCoder& coder, uint8_t& outDataLength, uint8_t* outData) {
         // It seems crazy to encode this. The only reason is to be able to trigger another device
         //
-        // The automatic gear shifter position is encoded in bits 0-3 of byte 0
         // Bits 0-3 respectively represent P-R-N-D
-        // Bits 4-7 are an inverted version of bits 0-3
-        switch (_gearShifterPosition.position) {
+        uint32_t position = 0;
+        switch (coder._gearShifterPosition.position) {
         case 'P':
-            outData[0] = 0xe1;
+            position = 0x01;
             break;
         case 'R':
-            outData[0] = 0xd2;
+            position = 0x02;
             break;
         case 'N':
-            outData[0] = 0xb4;
+            position = 0x04;
             break;
         case 'D':
-            outData[0] = 0x78;
+            position = 0x08;
             break;
         }
-        outDataLengthCode = _gearShifterPosition.additionalData.dataLengthCode;
-        if (outDataLengthCode < 1) {
-            outDataLengthCode = 1;
+        if (position != 0) {
+            GearShifterPositionSignals::Position::Insert(outData, position);
+            GearShifterPositionSignals::InvertedPosition::Insert(outData, ~position);
+        }
+        outDataLength = coder._gearShifterPosition.additionalData.dataLengthCode;
+        if (outDataLength < 1) {
+            outDataLength = 1;
         }
-        if (_gearShifterPosition.additionalData.dataLengthCode >= 4) {
+        if (coder._gearShifterPosition.additionalData.dataLengthCode >= 4) {
             // Byte 3 is a counter incrementing with 0x10 wrapping around above 0xf0
             // Set this counter to the next value
             // Alter the uncoded data so the counter keeps incrementing for consecutive encodes
             // In the uncoded data it is at position 2
-            _gearShifterPosition.additionalData.uncodedData[2] += 0x10;
-            _gearShifterPosition.additionalData.uncodedData[2] %= 0xf0;
+            coder._gearShifterPosition.additionalData.uncodedData[2] += 0x10;
+            coder._gearShifterPosition.additionalData.uncodedData[2] %= 0xf0;
         }
-        for (int index = 1; index < _gearShifterPosition.additionalData.dataLengthCode; index++) {
-            outData[index] = _gearShifterPosition.additionalData.uncodedData[index - 1];
+        if (coder._gearShifterPosition.additionalData.dataLengthCode > 1) {
+            memcpy(&outData[1], coder._gearShifterPosition.additionalData.uncodedData, coder._gearShifterPosition.additionalData.dataLengthCode - 1);
         }
-        break;
-    case Identifier::windowRoofAndMirrorControl:
-        if (_windowRoofAndMirrorControl.closeWindowsAndRoof) {
-            // Closing action for the windows and roof is encode with 0x1b in bytes 0 and 2
-            outData[0] = 0x1b;
-            outData[2] = 0x1b;
+    }
+
+    void EncodeWindowRoofAndMirrorControl(CanCoder& coder, uint8_t& outDataLength, uint8_t* outData) {
+        if (coder._windowRoofAndMirrorControl.closeWindowsAndRoof) {
+            WindowRoofAndMirrorControlSignals::CloseWindows::Insert(outData, 0x1b);
+            WindowRoofAndMirrorControlSignals::CloseRoof::Insert(outData, 0x1b);
         }
         else {
-            outData[0] = 0;
-            outData[2] = 0;
+            WindowRoofAndMirrorControlSignals::CloseWindows::Insert(outData, 0);
+            WindowRoofAndMirrorControlSignals::CloseRoof::Insert(outData, 0);
         }
-        if (_windowRoofAndMirrorControl.foldMirrors) {
-            // Folding action for the mirrors is encode with 0x1b in byte 1
-            outData[1] = 0x1b;
+        if (coder._windowRoofAndMirrorControl.foldMirrors) {
+            WindowRoofAndMirrorControlSignals::FoldMirrors::Insert(outData, 0x1b);
         }
         else {
-            outData[1] = 0;
+            WindowRoofAndMirrorControlSignals::FoldMirrors::Insert(outData, 0);
         }
-        // If any action is to be performed byte 3 should be 0x52
-        // For no action (stopping current action) it should be 0x50
-        if (_windowRoofAndMirrorControl.closeWindowsAndRoof || _windowRoofAndMirrorControl.foldMirrors) {
-            outData[3] = 0x52;
+        // For no action (stopping current action) byte 3 should be 0x50
+        if (coder._windowRoofAndMirrorControl.closeWindowsAndRoof || coder._windowRoofAndMirrorControl.foldMirrors) {
+            WindowRoofAndMirrorControlSignals::Action::Insert(outData, 0x52);
         }
         else {
-            outData[3] = 0x50;
+            WindowRoofAndMirrorControlSignals::Action::Insert(outData, 0x50);
         }
-        outDataLengthCode = _windowRoofAndMirrorControl.additionalData.dataLengthCode;
-        if (outDataLengthCode < 4) {
-            outDataLengthCode = 4;
+        outDataLength = coder._windowRoofAndMirrorControl.additionalData.dataLengthCode;
+        if (outDataLength < 4) {
+            outDataLength = 4;
         }
-        for (int index = 4; index < _windowRoofAndMirrorControl.additionalData.dataLengthCode; index++) {
-            outData[index] = _windowRoofAndMirrorControl.additionalData.uncodedData[index - 4];
+        if (coder._windowRoofAndMirrorControl.additionalData.dataLengthCode > 4) {
+            memcpy(&outData[4], coder._windowRoofAndMirrorControl.additionalData.uncodedData, coder._windowRoofAndMirrorControl.additionalData.dataLengthCode - 4);
         }
-        break;
-    case Identifier::doorLockControl:
+    }
+
+    void EncodeDoorLockControl(CanCoder& coder, uint8_t& outDataLength, uint8_t* outData) {
         // As we can only encode a locking action for this identifier, the lockDoors bool is not checked
-        // Door locking action is encoded in bytes 0-3
-        outData[0] = 0x33;
-        outData[1] = 0x33;
-        outData[2] = 0x38;
-        outData[3] = 0x00;
-        outDataLengthCode = _doorLockControl.additionalData.dataLengthCode;
-        if (outDataLengthCode < 4) {
-            outDataLengthCode = 4;
-        }
-        for (int index = 4; index < _doorLockControl.additionalData.dataLengthCode; index++) {
-            outData[index] = _doorLockControl.additionalData.uncodedData[index - 4];
-        }
-        break;
-    case Identifier::setDateTime:
-        // The year is in byte 5 and 6
-        outData[5] = _dateTime.year & 0xff;
-        outData[6] = (_dateTime.year >> 8) & 0xff;
-        // The month is in bits 4-7 of byte 4
-        // Bits 0-3 are set to 1
-        outData[4] = (_dateTime.month << 4) | 0x0f;
-        // The day is in byte 3
-        outData[3] = _dateTime.day;
-        // The hour is in byte 0
-        outData[0] = _dateTime.hour;
-        // The minute is in byte 1
-        outData[1] = _dateTime.minute;
-        // The second is in byte 2
-        outData[2] = _dateTime.second;
-        outDataLengthCode = _dateTime.additionalData.dataLengthCode;
-        if (outDataLengthCode < 7) {
-            outDataLengthCode = 7;
+        DoorLockControlSignals::Action::Insert(outData, DoorLockControlSignals::lockDoors);
+        outDataLength = coder._doorLockControl.additionalData.dataLengthCode;
+        if (outDataLength < 4) {
+            outDataLength = 4;
         }
-        if (_dateTime.additionalData.dataLengthCode == 8) {
-            outData[7] = _dateTime.additionalData.uncodedDataByte7;
+        if (coder._doorLockControl.additionalData.dataLengthCode > 4) {
+            memcpy(&outData[4], coder._doorLockControl.additionalData.uncodedData, coder._doorLockControl.additionalData.dataLengthCode - 4);
         }
-        break;
-    default:
-        break;
     }
-}
 
-std::string CanCoder::RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, uint8_t* data) {
-    std::stringstream rawMessageString;
-    rawMessageString << std::setfill('0') << std::setw(3) << std::uppercase << std::hex << identifier << ":";
-    for (int index = 0; index < dataLengthCode; index++) {
-        rawMessageString << " " << std::setfill('0') << std::setw(2) << std::uppercase << std::hex << (uint32_t)data[index];
+    void EncodeSetDateTime(CanCoder& coder, uint8_t& outDataLength, uint8_t* outData) {
+        DateTimeSignals::Year::Insert(outData, coder._dateTime.year);
+        DateTimeSignals::Month::Insert(outData, coder._dateTime.month);
+        DateTimeSignals::Filler::Insert(outData, 0x0f);
+        DateTimeSignals::Day::Insert(outData, coder._dateTime.day);
+        DateTimeSignals::Hour::Insert(outData, coder._dateTime.hour);
+        DateTimeSignals::Minute::Insert(outData, coder._dateTime.minute);
+        DateTimeSignals::Second::Insert(outData, coder._dateTime.second);
+        outDataLength = coder._dateTime.additionalData.dataLengthCode;
+        if (outDataLength < 7) {
+            outDataLength = 7;
+        }
+        if (coder._dateTime.additionalData.dataLengthCode > 7) {
+            memcpy(&outData[7], coder._dateTime.additionalData.uncodedData, coder._dateTime.additionalData.dataLengthCode - 7);
+        }
     }
-    return rawMessageString.str();
-}
 
-std::string CanCoder::ToString() {
-    std::stringstream messageString;
-    switch (_identifier) {
-    case Identifier::frontPassengerSideDoorStatus:
-        messageString << "ID:FrontPassengerSideDoorStatus" << " open:" << _frontPassengerSideDoorStatus.open << " locked:" << _frontPassengerSideDoorStatus.locked;
-        break;
-    case Identifier::rearPassengerSideDoorStatus:
-        messageString << "ID:RearPassengerSideDoorStatus" << " open:" << _rearPassengerSideDoorStatus.open << " locked:" << _rearPassengerSideDoorStatus.locked;
-        break;
-    case Identifier::frontDriverSideDoorStatus:
-        messageString << "ID:FrontDriverSideDoorStatus" << " open:" << _frontDriverSideDoorStatus.open << " locked:" << _frontDriverSideDoorStatus.locked;
-        break;
-    case Identifier::rearDriverSideDoorStatus:
-        messageString << "ID:RearDriverSideDoorStatus" << " open:" << _rearDriverSideDoorStatus.open << " locked:" << _rearDriverSideDoorStatus.locked;
-        break;
-    case Identifier::mirrorFoldStatus:
-        messageString << "ID:MirrorFoldStatus" << " folded:" << _mirrorFoldStatus.folded;
-        break;
-    case Identifier::ignitionAndKeyLocation:
-        messageString << "ID:IgnitionAndKeyLocation" << " keyIsOutside:" << _ignitionAndKeyLocation.keyIsOutside;
-        break;
-    case Identifier::vehicleSpeed:
-        messageString << "ID:VehicleSpeed" << " speed:" << _vehicleSpeed.speed;
-        break;
-    case Identifier::iDriveControler:
+    // Formatting
+
+    // Number that is padded with zeros to a minimum width, like std::setfill('0') << std::setw(width)
+    struct ZeroPadded {
+        int value;
+        int width;
+    };
+
+    // Hexadecimal number with upper case digits that is padded with zeros to a minimum width
+    struct Hexadecimal {
+        uint32_t value;
+        int width;
+    };
+
+    // Writes text to a buffer without allocating memory
+    // The output is the same as that of a std::stringstream with default formatting
+    // Text that does not fit in the buffer is counted but not written, like snprintf does
+    class TextWriter {
+    public:
+        TextWriter(char* buffer, size_t size) : _position(buffer), _end(size > 0 ? buffer + size - 1 : buffer), _terminated(size > 0) {}
+
+        // Zero terminate the text and get the length it would have without truncation
+        size_t Finish() {
+            if (_terminated) {
+                *_position = '\0';
+            }
+            return _length;
+        }
+
+        TextWriter& operator<<(const char* text) {
+            Write(text, strlen(text));
+            return *this;
+        }
+
+        TextWriter& operator<<(char character) {
+            Write(&character, 1);
+            return *this;
+        }
+
+        TextWriter& operator<<(bool value) {
+            return *this << (value ? '1' : '0');
+        }
+
+        TextWriter& operator<<(int value) {
+            return *this << ZeroPadded{ value, 0 };
+        }
+
+        TextWriter& operator<<(unsigned short value) {
+            return *this << ZeroPadded{ value, 0 };
+        }
+
+        TextWriter& operator<<(ZeroPadded number) {
+            char digits[16];
+            char* digitsEnd = std::to_chars(digits, digits + sizeof(digits), number.value).ptr;
+            Pad(number.width - (int)(digitsEnd - digits));
+            Write(digits, digitsEnd - digits);
+            return *this;
+        }
+
+        TextWriter& operator<<(Hexadecimal number) {
+            static const char hexadecimalDigits[] = "0123456789ABCDEF";
+            char digits[8];
+            int digitCount = 0;
+            do {
+                digits[7 - digitCount++] = hexadecimalDigits[number.value & 0x0f];
+                number.value >>= 4;
+            } while (number.value != 0);
+            Pad(number.width - digitCount);
+            Write(digits + 8 - digitCount, digitCount);
+            return *this;
+        }
+
+    private:
+        void Write(const char* text, size_t length) {
+            size_t available = _end - _position;
+            size_t written = length < available ? length : available;
+            memcpy(_position, text, written);
+            _position += written;
+            _length += length;
+        }
+
+        void Pad(int count) {
+            for (; count > 0; count--) {
+                *this << '0';
+            }
+        }
+
+        char* _position;
+        // Position of the zero terminator when the buffer is full
+        char* _end;
+        // An empty buffer has no room for the zero terminator
+        bool _terminated;
+        size_t _length = 0;
+    };
+
+    // Formatters
+
+    void FrontPassengerSideDoorStatusToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:FrontPassengerSideDoorStatus" << " open:" << coder._frontPassengerSideDoorStatus.open << " locked:" << coder._frontPassengerSideDoorStatus.locked;
+    }
+
+    void RearPassengerSideDoorStatusToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:RearPassengerSideDoorStatus" << " open:" << coder._rearPassengerSideDoorStatus.open << " locked:" << coder._rearPassengerSideDoorStatus.locked;
+    }
+
+    void FrontDriverSideDoorStatusToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:FrontDriverSideDoorStatus" << " open:" << coder._frontDriverSideDoorStatus.open << " locked:" << coder._frontDriverSideDoorStatus.locked;
+    }
+
+    void RearDriverSideDoorStatusToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:RearDriverSideDoorStatus" << " open:" << coder._rearDriverSideDoorStatus.open << " locked:" << coder._rearDriverSideDoorStatus.locked;
+    }
+
+    void MirrorFoldStatusToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:MirrorFoldStatus" << " folded:" << coder._mirrorFoldStatus.folded;
+    }
+
+    void IgnitionAndKeyLocationToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:IgnitionAndKeyLocation" << " keyIsOutside:" << coder._ignitionAndKeyLocation.keyIsOutside;
+    }
+
+    void VehicleSpeedToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:VehicleSpeed" << " speed:" << coder._vehicleSpeed.speed;
+    }
+
+    void IDriveControllerToString(const CanCoder& coder, TextWriter& messageString) {
         messageString <<
             "ID:IDriveControler" <<
-            " stickUp:" << _iDriveController.stickUp << " stickRight:" << _iDriveController.stickRight <<
-            " stickDown:" << _iDriveController.stickDown << " stickLeft:" << _iDriveController.stickLeft <<
-            " stickPush:" << _iDriveController.stickPush << " homeButton:" << _iDriveController.homeButton <<
-            " menuButton:" << _iDriveController.menuButton << " dialValue:" << _iDriveController.dialValue;
-        break;
-    case Identifier::gearShifterPosition:
-        messageString << "ID:GearShifterPosition" << " position:" << _gearShifterPosition.position;
-        break;
-    case Identifier::remoteControlAndDoorHandleInput:
+            " stickUp:" << coder._iDriveController.stickUp << " stickRight:" << coder._iDriveController.stickRight <<
+            " stickDown:" << coder._iDriveController.stickDown << " stickLeft:" << coder._iDriveController.stickLeft <<
+            " stickPush:" << coder._iDriveController.stickPush << " homeButton:" << coder._iDriveController.homeButton <<
+            " menuButton:" << coder._iDriveController.menuButton << " dialValue:" << coder._iDriveController.dialValue;
+    }
+
+    void GearShifterPositionToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:GearShifterPosition" << " position:" << coder._gearShifterPosition.position;
+    }
+
+    void RemoteControlAndDoorHandleInputToString(const CanCoder& coder, TextWriter& messageString) {
         messageString <<
             "ID:RemoteControlAndDoorHandleInput" <<
-            " remoteControlUnlockButton:" << _remoteControlAndDoorHandleInput.remoteControlUnlockButton <<
-            " remoteControlLockButton:" << _remoteControlAndDoorHandleInput.remoteControlLockButton <<
-            " doorHandleUnlockButton:" << _remoteControlAndDoorHandleInput.doorHandleUnlockButton <<
-            " doorHandleLockButton:" << _remoteControlAndDoorHandleInput.doorHandleLockButton;
-        break;
-    case Identifier::windowRoofAndMirrorControl:
-        messageString << "ID:WindowRoofAndMirrorControl" << " closeWindowsAndRoof:" << _windowRoofAndMirrorControl.closeWindowsAndRoof << "foldMirrors:" << _windowRoofAndMirrorControl.foldMirrors;
-        break;
-    case Identifier::doorLockControl:
-        messageString << "ID:DoorLockControl" << " lockDoors:" << _doorLockControl.lockDoors;
-        break;
-    case Identifier::dateTime:
-    case Identifier::setDateTime:
-        messageString << (_identifier == Identifier::dateTime ? "ID:DateTime" : "ID:SetDateTime") <<
-            " " << _dateTime.year << "-" << std::setfill('0') << std::setw(2) << _dateTime.month << "-" << std::setfill('0') << std::setw(2) << _dateTime.day <<
-            " " << std::setfill('0') << std::setw(2) << _dateTime.hour << ":" << std::setfill('0') << std::setw(2) << _dateTime.minute << ":" << std::setfill('0') << std::setw(2) << _dateTime.second;
-        break;
-    case Identifier::passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus:
+            " remoteControlUnlockButton:" << coder._remoteControlAndDoorHandleInput.remoteControlUnlockButton <<
+            " remoteControlLockButton:" << coder._remoteControlAndDoorHandleInput.remoteControlLockButton <<
+            " doorHandleUnlockButton:" << coder._remoteControlAndDoorHandleInput.doorHandleUnlockButton <<
+            " doorHandleLockButton:" << coder._remoteControlAndDoorHandleInput.doorHandleLockButton;
+    }
+
+    void WindowRoofAndMirrorControlToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:WindowRoofAndMirrorControl" << " closeWindowsAndRoof:" << coder._windowRoofAndMirrorControl.closeWindowsAndRoof << "foldMirrors:" << coder._windowRoofAndMirrorControl.foldMirrors;
+    }
+
+    void DoorLockControlToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:DoorLockControl" << " lockDoors:" << coder._doorLockControl.lockDoors;
+    }
+
+    void DateTimeToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << (coder._identifier == CanCoder::Identifier::dateTime ? "ID:DateTime" : "ID:SetDateTime") <<
+            " " << coder._dateTime.year << "-" << ZeroPadded{ coder._dateTime.month, 2 } << "-" << ZeroPadded{ coder._dateTime.day, 2 } <<
+            " " << ZeroPadded{ coder._dateTime.hour, 2 } << ":" << ZeroPadded{ coder._dateTime.minute, 2 } << ":" << ZeroPadded{ coder._dateTime.second, 2 };
+    }
+
+    void PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusToString(const CanCoder& coder, TextWriter& messageString) {
         messageString <<
             "ID:PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatus" <<
-            " seatbeltFastened:" << _passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.seatbeltFastened <<
-            " occupied:" << _passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.occupied;
-        break;
-    case Identifier::doorOpenStatuses:
+            " seatbeltFastened:" << coder._passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.seatbeltFastened <<
+            " occupied:" << coder._passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus.occupied;
+    }
+
+    void DoorOpenStatusesToString(const CanCoder& coder, TextWriter& messageString) {
         messageString <<
             "ID:doorOpenStatuses" <<
-            " frontDriverSideDoorIsOpen:" << _doorOpenStatuses.frontDriverSideDoorIsOpen << " frontPassengerSideDoorIsOpen:" << _doorOpenStatuses.frontPassengerSideDoorIsOpen <<
-            " rearDriverSideDoorIsOpen:" << _doorOpenStatuses.rearDriverSideDoorIsOpen << " rearPassengerSideDoorIsOpen:" << _doorOpenStatuses.rearPassengerSideDoorIsOpen <<
-            " bootIsOpen:" << _doorOpenStatuses.bootIsOpen << " bonnetIsOpen:" << _doorOpenStatuses.bonnetIsOpen;
-        break;
-    case Identifier::handbrakeStatus:
-        messageString << "ID:handbrakeStatus" << " handbrakeIsActive:" << _handbrakeStatus.handbrakeIsActive;
-        break;
-   default:
-        break;
-    }
-    return messageString.str();
+            " frontDriverSideDoorIsOpen:" << coder._doorOpenStatuses.frontDriverSideDoorIsOpen << " frontPassengerSideDoorIsOpen:" << coder._doorOpenStatuses.frontPassengerSideDoorIsOpen <<
+            " rearDriverSideDoorIsOpen:" << coder._doorOpenStatuses.rearDriverSideDoorIsOpen << " rearPassengerSideDoorIsOpen:" << coder._doorOpenStatuses.rearPassengerSideDoorIsOpen <<
+            " bootIsOpen:" << coder._doorOpenStatuses.bootIsOpen << " bonnetIsOpen:" << coder._doorOpenStatuses.bonnetIsOpen;
+    }
+
+    void HandbrakeStatusToString(const CanCoder& coder, TextWriter& messageString) {
+        messageString << "ID:handbrakeStatus" << " handbrakeIsActive:" << coder._handbrakeStatus.handbrakeIsActive;
+    }
+
+    // Fields
+    // The order of the fields is the order of the bits of the changed fields of DecodeChanges
+
+#define CANCODER_FIELD(member, field, type) { #field, CanCoder::FieldType::type, (uint16_t)offsetof(CanCoder, member.field) }
+
+    constexpr CanCoder::Field frontPassengerSideDoorStatusFields[] = {
+        CANCODER_FIELD(_frontPassengerSideDoorStatus, open, boolean),
+        CANCODER_FIELD(_frontPassengerSideDoorStatus, locked, boolean)
+    };
+
+    constexpr CanCoder::Field rearPassengerSideDoorStatusFields[] = {
+        CANCODER_FIELD(_rearPassengerSideDoorStatus, open, boolean),
+        CANCODER_FIELD(_rearPassengerSideDoorStatus, locked, boolean)
+    };
+
+    constexpr CanCoder::Field frontDriverSideDoorStatusFields[] = {
+        CANCODER_FIELD(_frontDriverSideDoorStatus, open, boolean),
+        CANCODER_FIELD(_frontDriverSideDoorStatus, locked, boolean)
+    };
+
+    constexpr CanCoder::Field rearDriverSideDoorStatusFields[] = {
+        CANCODER_FIELD(_rearDriverSideDoorStatus, open, boolean),
+        CANCODER_FIELD(_rearDriverSideDoorStatus, locked, boolean)
+    };
+
+    constexpr CanCoder::Field mirrorFoldStatusFields[] = {
+        CANCODER_FIELD(_mirrorFoldStatus, folded, boolean)
+    };
+
+    constexpr CanCoder::Field ignitionAndKeyLocationFields[] = {
+        CANCODER_FIELD(_ignitionAndKeyLocation, keyIsOutside, boolean)
+    };
+
+    constexpr CanCoder::Field vehicleSpeedFields[] = {
+        CANCODER_FIELD(_vehicleSpeed, speed, integer)
+    };
+
+    constexpr CanCoder::Field iDriveControllerFields[] = {
+        CANCODER_FIELD(_iDriveController, dialValue, unsignedShort),
+        CANCODER_FIELD(_iDriveController, homeButton, boolean),
+        CANCODER_FIELD(_iDriveController, menuButton, boolean),
+        CANCODER_FIELD(_iDriveController, stickUp, boolean),
+        CANCODER_FIELD(_iDriveController, stickRight, boolean),
+        CANCODER_FIELD(_iDriveController, stickDown, boolean),
+        CANCODER_FIELD(_iDriveController, stickLeft, boolean),
+        CANCODER_FIELD(_iDriveController, stickPush, boolean)
+    };
+
+    constexpr CanCoder::Field gearShifterPositionFields[] = {
+        CANCODER_FIELD(_gearShifterPosition, position, character)
+    };
+
+    constexpr CanCoder::Field remoteControlAndDoorHandleInputFields[] = {
+        CANCODER_FIELD(_remoteControlAndDoorHandleInput, remoteControlUnlockButton, boolean),
+        CANCODER_FIELD(_remoteControlAndDoorHandleInput, remoteControlLockButton, boolean),
+        CANCODER_FIELD(_remoteControlAndDoorHandleInput, doorHandleUnlockButton, boolean),
+        CANCODER_FIELD(_remoteControlAndDoorHandleInput, doorHandleLockButton, boolean)
+    };
+
+    constexpr CanCoder::Field windowRoofAndMirrorControlFields[] = {
+        CANCODER_FIELD(_windowRoofAndMirrorControl, closeWindowsAndRoof, boolean),
+        CANCODER_FIELD(_windowRoofAndMirrorControl, foldMirrors, boolean)
+    };
+
+    constexpr CanCoder::Field doorLockControlFields[] = {
+        CANCODER_FIELD(_doorLockControl, lockDoors, boolean)
+    };
+
+    constexpr CanCoder::Field dateTimeFields[] = {
+        CANCODER_FIELD(_dateTime, year, integer),
+        CANCODER_FIELD(_dateTime, month, integer),
+        CANCODER_FIELD(_dateTime, day, integer),
+        CANCODER_FIELD(_dateTime, hour, integer),
+        CANCODER_FIELD(_dateTime, minute, integer),
+        CANCODER_FIELD(_dateTime, second, integer)
+    };
+
+    constexpr CanCoder::Field passengerSideFrontSeatSeatbeltAndSeatOccupancyStatusFields[] = {
+        CANCODER_FIELD(_passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, seatbeltFastened, boolean),
+        CANCODER_FIELD(_passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, occupied, boolean)
+    };
+
+    constexpr CanCoder::Field doorOpenStatusesFields[] = {
+        CANCODER_FIELD(_doorOpenStatuses, frontDriverSideDoorIsOpen, boolean),
+        CANCODER_FIELD(_doorOpenStatuses, frontPassengerSideDoorIsOpen, boolean),
+        CANCODER_FIELD(_doorOpenStatuses, rearDriverSideDoorIsOpen, boolean),
+        CANCODER_FIELD(_doorOpenStatuses, rearPassengerSideDoorIsOpen, boolean),
+        CANCODER_FIELD(_doorOpenStatuses, bootIsOpen, boolean),
+        CANCODER_FIELD(_doorOpenStatuses, bonnetIsOpen, boolean)
+    };
+
+    constexpr CanCoder::Field handbrakeStatusFields[] = {
+        CANCODER_FIELD(_handbrakeStatus, handbrakeIsActive, boolean)
+    };
+
+#undef CANCODER_FIELD
+
+    constexpr uint8_t fieldSizes[] = { sizeof(bool), sizeof(char), sizeof(int), sizeof(unsigned short) };
+
+    struct FieldList {
+        const CanCoder::Field* fields;
+        uint8_t count;
+
+        template <size_t Count>
+        constexpr FieldList(const CanCoder::Field (&inFields)[Count]) : fields(inFields), count((uint8_t)Count) {}
+    };
+
+    // Dispatching
+
+    struct MessageHandler {
+        CanCoder::Identifier identifier;
+        // Messages with less data are rejected, encoders produce at least this length
+        uint8_t minimumDataLength;
+        void (*decode)(CanCoder& coder, uint8_t inDataLength, const uint8_t* inData);
+        // nullptr for messages that can not be encoded
+        void (*encode)(CanCoder& coder, uint8_t& outDataLength, uint8_t* outData);
+        // Offset within CanCoder of the data length code of the additional data, 0 for messages without it
+        uint16_t dataLengthCodeOffset;
+        void (*toString)(const CanCoder& coder, TextWriter& messageString);
+        // Position in the last data of DecodeChanges, messages decoding into the same struct share it
+        uint8_t messageStruct;
+        FieldList fieldList;
+    };
+
+#define CANCODER_DATA_LENGTH_CODE_OFFSET(member) (uint16_t)offsetof(CanCoder, member.additionalData.dataLengthCode)
+
+    // To support a new message, add it here
+    constexpr MessageHandler messageHandlers[] = {
+        { CanCoder::Identifier::frontPassengerSideDoorStatus, 4, DecodeFrontPassengerSideDoorStatus, nullptr, 0, FrontPassengerSideDoorStatusToString, 0, frontPassengerSideDoorStatusFields },
+        { CanCoder::Identifier::rearPassengerSideDoorStatus, 4, DecodeRearPassengerSideDoorStatus, nullptr, 0, RearPassengerSideDoorStatusToString, 1, rearPassengerSideDoorStatusFields },
+        { CanCoder::Identifier::frontDriverSideDoorStatus, 4, DecodeFrontDriverSideDoorStatus, nullptr, 0, FrontDriverSideDoorStatusToString, 2, frontDriverSideDoorStatusFields },
+        { CanCoder::Identifier::rearDriverSideDoorStatus, 4, DecodeRearDriverSideDoorStatus, nullptr, 0, RearDriverSideDoorStatusToString, 3, rearDriverSideDoorStatusFields },
+        { CanCoder::Identifier::mirrorFoldStatus, 1, DecodeMirrorFoldStatus, nullptr, 0, MirrorFoldStatusToString, 4, mirrorFoldStatusFields },
+        { CanCoder::Identifier::ignitionAndKeyLocation, 4, DecodeIgnitionAndKeyLocation, nullptr, 0, IgnitionAndKeyLocationToString, 5, ignitionAndKeyLocationFields },
+        { CanCoder::Identifier::vehicleSpeed, 2, DecodeVehicleSpeed, nullptr, 0, VehicleSpeedToString, 6, vehicleSpeedFields },
+        { CanCoder::Identifier::iDriveControler, 4, DecodeIDriveController, EncodeIDriveController, CANCODER_DATA_LENGTH_CODE_OFFSET(_iDriveController), IDriveControllerToString, 7, iDriveControllerFields },
+        { CanCoder::Identifier::gearShifterPosition, 1, DecodeGearShifterPosition, EncodeGearShifterPosition, CANCODER_DATA_LENGTH_CODE_OFFSET(_gearShifterPosition), GearShifterPositionToString, 8, gearShifterPositionFields },
+        { CanCoder::Identifier::remoteControlAndDoorHandleInput, 3, DecodeRemoteControlAndDoorHandleInput, nullptr, 0, RemoteControlAndDoorHandleInputToString, 9, remoteControlAndDoorHandleInputFields },
+        { CanCoder::Identifier::windowRoofAndMirrorControl, 4, DecodeWindowRoofAndMirrorControl, EncodeWindowRoofAndMirrorControl, CANCODER_DATA_LENGTH_CODE_OFFSET(_windowRoofAndMirrorControl), WindowRoofAndMirrorControlToString, 10, windowRoofAndMirrorControlFields },
+        { CanCoder::Identifier::doorLockControl, 4, DecodeDoorLockControl, EncodeDoorLockControl, CANCODER_DATA_LENGTH_CODE_OFFSET(_doorLockControl), DoorLockControlToString, 11, doorLockControlFields },
+        { CanCoder::Identifier::dateTime, 7, DecodeDateTime, nullptr, 0, DateTimeToString, 12, dateTimeFields },
+        { CanCoder::Identifier::passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, 2, DecodePassengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, nullptr, 0, PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatusToString, 13, passengerSideFrontSeatSeatbeltAndSeatOccupancyStatusFields },
+        { CanCoder::Identifier::doorOpenStatuses, 3, DecodeDoorOpenStatuses, nullptr, 0, DoorOpenStatusesToString, 14, doorOpenStatusesFields },
+        { CanCoder::Identifier::handbrakeStatus, 1, DecodeHandbrakeStatus, nullptr, 0, HandbrakeStatusToString, 15, handbrakeStatusFields },
+        { CanCoder::Identifier::setDateTime, 7, DecodeDateTime, EncodeSetDateTime, CANCODER_DATA_LENGTH_CODE_OFFSET(_dateTime), DateTimeToString, 12, dateTimeFields }
+    };
+
+#undef CANCODER_DATA_LENGTH_CODE_OFFSET
+    constexpr size_t messageHandlerCount = sizeof(messageHandlers) / sizeof(messageHandlers[0]);
+    static_assert(messageHandlerCount == CanCoder::messageCount, "CanCoder::messageCount must match the message handlers");
+
+    constexpr bool CheckMessageHandlers() {
+        for (const MessageHandler& messageHandler : messageHandlers) {
+            if (messageHandler.messageStruct >= CanCoder::messageStructCount || messageHandler.fieldList.count > 32 ||
+                (messageHandler.encode != nullptr && messageHandler.dataLengthCodeOffset == 0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(CheckMessageHandlers(), "Message struct out of range, more fields than bits in the changed fields or an encodable message without additional data");
+
+    // Largest total size of the fields of a message
+    constexpr size_t maximumFieldsSize = 6 * sizeof(int);
+
+    constexpr size_t GetFieldsSize(const FieldList& fieldList) {
+        size_t fieldsSize = 0;
+        for (uint8_t index = 0; index < fieldList.count; index++) {
+            fieldsSize += fieldSizes[(size_t)fieldList.fields[index].type];
+        }
+        return fieldsSize;
+    }
+
+    constexpr bool CheckFieldsSizes() {
+        for (const MessageHandler& messageHandler : messageHandlers) {
+            if (GetFieldsSize(messageHandler.fieldList) > maximumFieldsSize) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(CheckFieldsSizes(), "Fields do not fit maximumFieldsSize");
+
+    // Standard CAN identifiers are 11 bits
+    constexpr uint32_t identifierCount = 0x800;
+
+    // Dense table holding for each identifier its position in messageHandlers plus 1
+    // Zero means the identifier is not supported
+    struct DispatchTable {
+        uint8_t handlerNumber[identifierCount];
+    };
+
+    constexpr DispatchTable CreateDispatchTable() {
+        DispatchTable dispatchTable = {};
+        for (size_t index = 0; index < messageHandlerCount; index++) {
+            dispatchTable.handlerNumber[(uint32_t)messageHandlers[index].identifier] = (uint8_t)(index + 1);
+        }
+        return dispatchTable;
+    }
+
+    constexpr DispatchTable dispatchTable = CreateDispatchTable();
+
+    // Length of the data Encode produces, known before encoding
+    // Encoders write only within this length
+    size_t GetEncodedLength(const CanCoder& coder, const MessageHandler& messageHandler) {
+        uint8_t dataLength = *((const uint8_t*)&coder + messageHandler.dataLengthCodeOffset);
+        return dataLength > messageHandler.minimumDataLength ? dataLength : messageHandler.minimumDataLength;
+    }
+
+    const MessageHandler* FindMessageHandler(uint32_t identifier) {
+        if (identifier >= identifierCount) {
+            return nullptr;
+        }
+        uint8_t handlerNumber = dispatchTable.handlerNumber[identifier];
+        if (handlerNumber == 0) {
+            return nullptr;
+        }
+        return &messageHandlers[handlerNumber - 1];
+    }
+
+    // Statistics
+
+#if CANCODER_STATISTICS
+#define CANCODER_COUNT(counter) (_statistics.counter++)
+#define CANCODER_COUNT_MESSAGE(counter, messageHandler) (_statistics.counter[(messageHandler) - messageHandlers]++)
+#else
+#define CANCODER_COUNT(counter) ((void)0)
+#define CANCODER_COUNT_MESSAGE(counter, messageHandler) ((void)0)
+#endif
+
+#if CANCODER_STATISTICS && CANCODER_LATENCY_SAMPLE_INTERVAL > 0
+    uint64_t ReadTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Measures the duration of every n-th decode from its construction to its destruction
+    class LatencySample {
+    public:
+        explicit LatencySample(CanCoder::Statistics& statistics) : _statistics(statistics) {
+            if (++_statistics.sampleCounter % CANCODER_LATENCY_SAMPLE_INTERVAL == 0) {
+                _start = ReadTicks();
+                _sampling = true;
+            }
+        }
+        ~LatencySample() {
+            if (_sampling) {
+                uint64_t ticks = ReadTicks() - _start;
+                size_t bucket = 0;
+                while (ticks != 0 && bucket < CanCoder::latencyBucketCount - 1) {
+                    ticks >>= 1;
+                    bucket++;
+                }
+                _statistics.latencyHistogram[bucket]++;
+            }
+        }
+
+    private:
+        CanCoder::Statistics& _statistics;
+        uint64_t _start = 0;
+        bool _sampling = false;
+    };
+#endif
+}
+
+bool CanCoder::Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData) {
+    _identifier = (Identifier)inIdentifier;
+    return DecodeData(inIdentifier, inDataLengthCode, inData);
+}
+
+bool CanCoder::Decode(uint32_t inIdentifier, std::span<const uint8_t> inData) {
+#if CANCODER_STATISTICS && CANCODER_LATENCY_SAMPLE_INTERVAL > 0
+    LatencySample latencySample(_statistics);
+#endif
+    _identifier = (Identifier)inIdentifier;
+    if (inData.size() > maximumDataLength || DataLengthCodeToLength(LengthToDataLengthCode(inData.size())) != inData.size()) {
+        CANCODER_COUNT(tooLongCount);
+        return false;
+    }
+    const MessageHandler* messageHandler = FindMessageHandler(inIdentifier);
+    if (messageHandler == nullptr) {
+        CANCODER_COUNT(unknownIdentifierCount);
+        return false;
+    }
+    if (inData.size() < messageHandler->minimumDataLength) {
+        CANCODER_COUNT(tooShortCount);
+        return false;
+    }
+    messageHandler->decode(*this, (uint8_t)inData.size(), inData.data());
+    CANCODER_COUNT_MESSAGE(decodedCount, messageHandler);
+    _lastDataLengthCode[messageHandler->messageStruct] = 0;
+    return true;
+}
+
+size_t CanCoder::DecodeBatch(const Frame* inFrames, size_t inFrameCount, uint32_t* outResults) {
+    size_t decodedCount = 0;
+    uint32_t results = 0;
+    for (size_t index = 0; index < inFrameCount; index++) {
+        const Frame& frame = inFrames[index];
+        if (DecodeData(frame.identifier, frame.dataLengthCode, frame.data)) {
+            results |= 1u << (index % 32);
+            decodedCount++;
+        }
+        // Only store complete words, this keeps the results in a register
+        if (index % 32 == 31 || index == inFrameCount - 1) {
+            if (outResults != nullptr) {
+                outResults[index / 32] = results;
+            }
+            results = 0;
+        }
+    }
+    // The identifier is only needed for the last message
+    if (inFrameCount > 0) {
+        _identifier = (Identifier)inFrames[inFrameCount - 1].identifier;
+    }
+    return decodedCount;
+}
+
+bool CanCoder::DecodeData(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData) {
+#if CANCODER_STATISTICS && CANCODER_LATENCY_SAMPLE_INTERVAL > 0
+    LatencySample latencySample(_statistics);
+#endif
+    if (inDataLengthCode > 8) {
+        CANCODER_COUNT(tooLongCount);
+        return false;
+    }
+
+    const MessageHandler* messageHandler = FindMessageHandler(inIdentifier);
+    if (messageHandler == nullptr) {
+        CANCODER_COUNT(unknownIdentifierCount);
+        return false;
+    }
+    if (inDataLengthCode < messageHandler->minimumDataLength) {
+        CANCODER_COUNT(tooShortCount);
+        return false;
+    }
+    messageHandler->decode(*this, inDataLengthCode, inData);
+    CANCODER_COUNT_MESSAGE(decodedCount, messageHandler);
+    _lastDataLengthCode[messageHandler->messageStruct] = 0;
+    return true;
+}
+
+bool CanCoder::DecodeChanges(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData, uint32_t& outChangedFields) {
+#if CANCODER_STATISTICS && CANCODER_LATENCY_SAMPLE_INTERVAL > 0
+    LatencySample latencySample(_statistics);
+#endif
+    outChangedFields = 0;
+    _identifier = (Identifier)inIdentifier;
+    if (inDataLengthCode > 8) {
+        CANCODER_COUNT(tooLongCount);
+        return false;
+    }
+
+    const MessageHandler* messageHandler = FindMessageHandler(inIdentifier);
+    if (messageHandler == nullptr) {
+        CANCODER_COUNT(unknownIdentifierCount);
+        return false;
+    }
+    if (inDataLengthCode < messageHandler->minimumDataLength) {
+        CANCODER_COUNT(tooShortCount);
+        return false;
+    }
+    CANCODER_COUNT_MESSAGE(decodedCount, messageHandler);
+
+    // Bytes beyond the data length code are not part of the message, they are left zero
+    uint64_t data = 0;
+    memcpy(&data, inData, inDataLengthCode);
+    uint8_t messageStruct = messageHandler->messageStruct;
+    if (_lastDataLengthCode[messageStruct] == inDataLengthCode + 1 && _lastData[messageStruct] == data) {
+        return true;
+    }
+
+    // Keep the fields to compare them after decoding
+    const FieldList& fieldList = messageHandler->fieldList;
+    uint8_t* coder = (uint8_t*)this;
+    uint8_t previousFields[maximumFieldsSize];
+    size_t position = 0;
+    for (uint8_t index = 0; index < fieldList.count; index++) {
+        const Field& field = fieldList.fields[index];
+        memcpy(&previousFields[position], coder + field.offset, fieldSizes[(size_t)field.type]);
+        position += fieldSizes[(size_t)field.type];
+    }
+
+    messageHandler->decode(*this, inDataLengthCode, inData);
+    _lastData[messageStruct] = data;
+    _lastDataLengthCode[messageStruct] = inDataLengthCode + 1;
+
+    uint32_t changedFields = 0;
+    position = 0;
+    for (uint8_t index = 0; index < fieldList.count; index++) {
+        const Field& field = fieldList.fields[index];
+        if (memcmp(&previousFields[position], coder + field.offset, fieldSizes[(size_t)field.type]) != 0) {
+            changedFields |= 1u << index;
+        }
+        position += fieldSizes[(size_t)field.type];
+    }
+    outChangedFields = changedFields;
+    return true;
+}
+
+void CanCoder::Encode(uint32_t& outIdentifier, uint8_t& outDataLengthCode, uint8_t* outData) {
+    outIdentifier = (uint32_t)_identifier;
+    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)_identifier);
+    if (messageHandler != nullptr && messageHandler->encode != nullptr) {
+        if (maximumDataLength == 8 || GetEncodedLength(*this, *messageHandler) <= 8) {
+            messageHandler->encode(*this, outDataLengthCode, outData);
+        }
+        else {
+            // The message was decoded from a CAN FD frame, which does not fit outData
+            // Encoders leave bits that are not part of a signal untouched, so they start from outData
+            uint8_t data[maximumDataLength];
+            memcpy(data, outData, 8);
+            uint8_t dataLength;
+            messageHandler->encode(*this, dataLength, data);
+            outDataLengthCode = 8;
+            memcpy(outData, data, 8);
+        }
+        // Encoding can change the additional data, so the last data no longer matches the message struct
+        _lastDataLengthCode[messageHandler->messageStruct] = 0;
+        CANCODER_COUNT_MESSAGE(encodedCount, messageHandler);
+    }
+}
+
+void CanCoder::ResetChanges() {
+    memset(_lastDataLengthCode, 0, sizeof(_lastDataLengthCode));
+}
+
+size_t CanCoder::Encode(uint32_t& outIdentifier, std::span<uint8_t> outData) {
+    outIdentifier = (uint32_t)_identifier;
+    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)_identifier);
+    if (messageHandler == nullptr || messageHandler->encode == nullptr) {
+        return 0;
+    }
+    // Checked before encoding, as encoding changes the state, for example the counter of the gear shifter position
+    if (GetEncodedLength(*this, *messageHandler) > outData.size()) {
+        return 0;
+    }
+    uint8_t dataLength;
+    messageHandler->encode(*this, dataLength, outData.data());
+    _lastDataLengthCode[messageHandler->messageStruct] = 0;
+    CANCODER_COUNT_MESSAGE(encodedCount, messageHandler);
+    return dataLength;
+}
+
+bool CanCoder::IsDecodable(Identifier identifier) {
+    return FindMessageHandler((uint32_t)identifier) != nullptr;
+}
+
+bool CanCoder::IsEncodable(Identifier identifier) {
+    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)identifier);
+    return messageHandler != nullptr && messageHandler->encode != nullptr;
+}
+
+int32_t CanCoder::GetFieldValue(const Field& field) const {
+    const uint8_t* value = (const uint8_t*)this + field.offset;
+    switch (field.type) {
+    case FieldType::boolean: {
+        bool booleanValue;
+        memcpy(&booleanValue, value, sizeof(booleanValue));
+        return booleanValue ? 1 : 0;
+    }
+    case FieldType::character: {
+        char characterValue;
+        memcpy(&characterValue, value, sizeof(characterValue));
+        return characterValue;
+    }
+    case FieldType::integer: {
+        int integerValue;
+        memcpy(&integerValue, value, sizeof(integerValue));
+        return integerValue;
+    }
+    case FieldType::unsignedShort: {
+        unsigned short unsignedShortValue;
+        memcpy(&unsignedShortValue, value, sizeof(unsignedShortValue));
+        return unsignedShortValue;
+    }
+    }
+    return 0;
+}
+
+bool CanCoder::GetStatistics(Statistics& outStatistics) const {
+#if CANCODER_STATISTICS
+    outStatistics = _statistics;
+    return true;
+#else
+    outStatistics = {};
+    return false;
+#endif
+}
+
+void CanCoder::ResetStatistics() {
+#if CANCODER_STATISTICS
+    _statistics = {};
+#endif
+}
+
+size_t CanCoder::GetIdentifiers(Identifier* outIdentifiers, size_t inMaximumCount) {
+    if (outIdentifiers != nullptr) {
+        for (size_t index = 0; index < messageHandlerCount && index < inMaximumCount; index++) {
+            outIdentifiers[index] = messageHandlers[index].identifier;
+        }
+    }
+    return messageHandlerCount;
+}
+
+size_t CanCoder::GetMessageIndex(Identifier identifier) {
+    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)identifier);
+    return messageHandler == nullptr ? messageCount : (size_t)(messageHandler - messageHandlers);
+}
+
+size_t CanCoder::GetFields(Identifier identifier, const Field*& outFields) {
+    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)identifier);
+    if (messageHandler == nullptr) {
+        outFields = nullptr;
+        return 0;
+    }
+    outFields = messageHandler->fieldList.fields;
+    return messageHandler->fieldList.count;
+}
+
+uint32_t CanCoder::GetFieldMask(Identifier identifier, const char* fieldName) {
+    const Field* fields;
+    size_t fieldCount = GetFields(identifier, fields);
+    for (size_t index = 0; index < fieldCount; index++) {
+        if (strcmp(fields[index].name, fieldName) == 0) {
+            return 1u << index;
+        }
+    }
+    return 0;
+}
+
+std::string CanCoder::RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, uint8_t* data) {
+    std::string rawMessageString;
+    RawMessageToString(identifier, dataLengthCode, data, rawMessageString);
+    return rawMessageString;
+}
+
+size_t CanCoder::RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, const uint8_t* data, char* outBuffer, size_t inBufferSize) {
+    TextWriter rawMessageString(outBuffer, inBufferSize);
+    rawMessageString << Hexadecimal{ identifier, 3 } << ":";
+    for (int index = 0; index < dataLengthCode; index++) {
+        rawMessageString << " " << Hexadecimal{ data[index], 2 };
+    }
+    return rawMessageString.Finish();
+}
+
+void CanCoder::RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, const uint8_t* data, std::string& outString) {
+    // The data length code is not limited here, so the string can be longer than stringBufferSize
+    outString.resize(3 * (size_t)dataLengthCode + 16);
+    size_t length = RawMessageToString(identifier, dataLengthCode, data, &outString[0], outString.size() + 1);
+    outString.resize(length);
+}
+
+std::string CanCoder::ToString() {
+    std::string messageString;
+    ToString(messageString);
+    return messageString;
+}
+
+size_t CanCoder::ToString(char* outBuffer, size_t inBufferSize) const {
+    TextWriter messageString(outBuffer, inBufferSize);
+    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)_identifier);
+    if (messageHandler != nullptr) {
+        messageHandler->toString(*this, messageString);
+    }
+    return messageString.Finish();
+}
+
+void CanCoder::ToString(std::string& outString) const {
+    char buffer[stringBufferSize];
+    size_t length = ToString(buffer, sizeof(buffer));
+    outString.assign(buffer, length);
 }
@@ -25,30 +25,138 @@
  * 4 and 5 that were not decoded will now still be included, resulting in a complete
  * message.
  *
+ * CAN FD messages of up to CANCODER_MAXIMUM_DATA_LENGTH bytes are decoded and encoded
+ * with the std::span functions. For those messages the dataLengthCode member of
+ * AdditionalData holds the length of the data in bytes rather than the data length code.
+ * The functions taking a data length code, Frame and DecodeChanges are for CAN messages
+ * of up to 8 bytes. Encoding a message decoded from a CAN FD frame with those functions
+ * produces its first 8 bytes.
+ * CANCODER_MAXIMUM_DATA_LENGTH is 8 by default, so CAN FD messages are rejected. Define
+ * it as 64 to support them, at the cost of larger additional data in every CanCoder.
+ *
  *
  * File history:
  * Version 1: initial
+ * Version 2: batch decode
+ * Version 3: table driven dispatch of identifiers
+ * Version 4: logging without memory allocation
+ * Version 5: change detection
+ * Version 6: query of encodable messages
+ * Version 7: list of supported identifiers
+ * Version 8: CAN FD
+ * Version 9: statistics
+ * Version 10: reading fields by their description
+ * Version 11: DateTime::AdditionalData::uncodedDataByte7 is available again, it is uncodedData[0]
+ * Version 12: extendedIdentifierFlag, IsDecodable, GetMessageIndex
  *
  */
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+#include <span>
 #include <string>
 
+// Maximum length of message data in bytes, 8 for CAN
+// Define it as 64 to decode and encode CAN FD messages, this makes the additional data of the messages larger
+#ifndef CANCODER_MAXIMUM_DATA_LENGTH
+#define CANCODER_MAXIMUM_DATA_LENGTH 8
+#endif
+
+// Define as 1 to count decoded, encoded and rejected messages, see GetStatistics
+// Without it the counting compiles to nothing
+#ifndef CANCODER_STATISTICS
+#define CANCODER_STATISTICS 0
+#endif
+
+// Define as n to measure the duration of every n-th decode, requires CANCODER_STATISTICS
+// The duration is in processor timestamp counter ticks on x86, in nanoseconds otherwise
+#ifndef CANCODER_LATENCY_SAMPLE_INTERVAL
+#define CANCODER_LATENCY_SAMPLE_INTERVAL 0
+#endif
+
 class CanCoder {
 public:
+    /// @brief Maximum length of message data in bytes
+    static constexpr size_t maximumDataLength = CANCODER_MAXIMUM_DATA_LENGTH;
+    static_assert(maximumDataLength >= 8 && maximumDataLength <= 64, "CANCODER_MAXIMUM_DATA_LENGTH must be 8-64");
+
     /// @brief Decode a CAN message
     /// @param inIdentifier CAN message identifier
     /// @param inDataLengthCode CAN message data length code
     /// @param inData CAN message data
     /// @return true on success, false on failure
     bool Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData);
+    /// @brief Decode a CAN or CAN FD message
+    /// @param inIdentifier CAN message identifier
+    /// @param inData CAN message data, its size must be a valid length: 0-8, 12, 16, 20, 24, 32, 48 or 64 bytes,
+    /// at most maximumDataLength
+    /// @return true on success, false on failure
+    bool Decode(uint32_t inIdentifier, std::span<const uint8_t> inData);
+    /// @brief Flag set in Frame::identifier for extended (29 bit) identifiers
+    static constexpr uint32_t extendedIdentifierFlag = 0x80000000;
+    /// @brief A CAN message as received from the bus, used for decoding multiple messages in one call
+    struct Frame {
+        uint32_t identifier;
+        uint8_t dataLengthCode;
+        uint8_t data[8];
+        uint64_t timestamp;
+    };
+    /// @brief Decode an array of CAN messages
+    ///
+    /// The messages are decoded in order, the result is the same as calling Decode for each message
+    /// @param inFrames CAN messages
+    /// @param inFrameCount Number of CAN messages
+    /// @param outResults Bitmap receiving the result for each message, bit (n % 32) of word (n / 32) is set when message n was decoded
+    /// Must be able to hold (inFrameCount + 31) / 32 words, may be nullptr
+    /// @return The number of messages that were decoded
+    size_t DecodeBatch(const Frame* inFrames, size_t inFrameCount, uint32_t* outResults);
+    /// @brief Decode a CAN message, reporting which fields changed
+    ///
+    /// The data is compared with the data of the last message decoded by DecodeChanges into the same
+    /// message struct. When it is identical the message is not decoded at all.
+    /// Decode, DecodeBatch and Encode make the next DecodeChanges for the message struct decode again.
+    /// Fields written directly are not noticed, call ResetChanges after writing them.
+    /// @param inIdentifier CAN message identifier
+    /// @param inDataLengthCode CAN message data length code
+    /// @param inData CAN message data
+    /// @param outChangedFields Bitmask of the fields that changed, bit n is set when field n of GetFields changed
+    /// @return true on success, also when nothing changed, false on failure
+    bool DecodeChanges(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData, uint32_t& outChangedFields);
+    /// @brief Make the next DecodeChanges of every message decode again, for example after writing fields for an encode
+    void ResetChanges();
     /// @brief Encode a CAN message
     /// @param outIdentifier CAN message identifier
     /// @param outDataLengthCode CAN message data length code
     /// @param outData CAN message data, must be able to hold 8 bytes
     void Encode(uint32_t& outIdentifier, uint8_t& outDataLengthCode, uint8_t* outData);
+    /// @brief Encode a CAN or CAN FD message
+    /// @param outIdentifier CAN message identifier
+    /// @param outData Buffer receiving the CAN message data
+    /// @return The length of the data in bytes, 0 when the message can not be encoded or does not fit outData,
+    /// the state is not changed then
+    size_t Encode(uint32_t& outIdentifier, std::span<uint8_t> outData);
+    /// @brief Get the length of the data in bytes for a data length code
+    ///
+    /// Data length codes 9-15 are 12, 16, 20, 24, 32, 48 and 64 bytes for CAN FD
+    static constexpr size_t DataLengthCodeToLength(uint8_t dataLengthCode) {
+        constexpr uint8_t lengths[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+        return lengths[dataLengthCode & 0x0f];
+    }
+    /// @brief Get the data length code for a length of data in bytes
+    ///
+    /// Lengths that are not a valid CAN FD length are rounded up to the next valid length
+    static constexpr uint8_t LengthToDataLengthCode(size_t length) {
+        if (length <= 8) {
+            return (uint8_t)length;
+        }
+        uint8_t dataLengthCode = 9;
+        while (dataLengthCode < 15 && DataLengthCodeToLength(dataLengthCode) < length) {
+            dataLengthCode++;
+        }
+        return dataLengthCode;
+    }
     /// @brief Create a string for logging, showing the raw CAN message in hexadecimal format
     ///
     /// This function is static as it requires no state
@@ -57,9 +165,42 @@ public:
     /// @param data CAN message data
     /// @return A string you can use for logging
     static std::string RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, uint8_t* data);
+    /// @brief Create a string for logging in a buffer, showing the raw CAN message in hexadecimal format
+    ///
+    /// The string is the same as the one returned by RawMessageToString(identifier, dataLengthCode, data),
+    /// but no memory is allocated
+    /// @param identifier CAN message identifier
+    /// @param dataLengthCode CAN message data length code
+    /// @param data CAN message data
+    /// @param outBuffer Buffer receiving the string, it is zero terminated unless inBufferSize is 0
+    /// @param inBufferSize Size of the buffer, stringBufferSize always fits
+    /// @return The length of the string, when this is inBufferSize or more the string was truncated
+    static size_t RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, const uint8_t* data, char* outBuffer, size_t inBufferSize);
+    /// @brief Create a string for logging in an existing string, showing the raw CAN message in hexadecimal format
+    ///
+    /// The capacity of the string is reused, so no memory is allocated once it is large enough
+    /// @param identifier CAN message identifier
+    /// @param dataLengthCode CAN message data length code
+    /// @param data CAN message data
+    /// @param outString String receiving the result
+    static void RawMessageToString(uint32_t identifier, uint8_t dataLengthCode, const uint8_t* data, std::string& outString);
     /// @brief Create a string for logging, showing the contents of the CAN message stored in this CanCoder instance
     /// @return A string you can use for logging
     std::string ToString();
+    /// @brief Create a string for logging in a buffer, showing the contents of the CAN message stored in this CanCoder instance
+    ///
+    /// The string is the same as the one returned by ToString(), but no memory is allocated
+    /// @param outBuffer Buffer receiving the string, it is zero terminated unless inBufferSize is 0
+    /// @param inBufferSize Size of the buffer, stringBufferSize always fits
+    /// @return The length of the string, when this is inBufferSize or more the string was truncated
+    size_t ToString(char* outBuffer, size_t inBufferSize) const;
+    /// @brief Create a string for logging in an existing string, showing the contents of the CAN message stored in this CanCoder instance
+    ///
+    /// The capacity of the string is reused, so no memory is allocated once it is large enough
+    /// @param outString String receiving the result
+    void ToString(std::string& outString) const;
+    /// @brief Buffer size that fits every string created by the ToString functions
+    static constexpr size_t stringBufferSize = 256;
 
     // CAN IDs
     enum class Identifier
@@ -118,14 +259,14 @@ public:
         bool stickPush;
         struct AdditionalData {
             uint8_t dataLengthCode = 6;
-            uint8_t uncodedData[4] = { 0x14, 0x10 };
+            uint8_t uncodedData[maximumDataLength - 4] = { 0x14, 0x10 };
         } additionalData;
     } _iDriveController = {};
     struct GearShifterPosition {
         char position;
         struct AdditionalData {
             uint8_t dataLengthCode = 6;
-            uint8_t uncodedData[7] = { 0x0f, 0xf0, 0x0c, 0xf0, 0xff };
+            uint8_t uncodedData[maximumDataLength - 1] = { 0x0f, 0xf0, 0x0c, 0xf0, 0xff };
         } additionalData;
     } _gearShifterPosition = {};
     struct RemoteControlAndDoorHandleInput {
@@ -139,14 +280,14 @@ public:
         bool foldMirrors;
         struct AdditionalData {
             uint8_t dataLengthCode = 8;
-            uint8_t uncodedData[4] = { 0xff, 0xff, 0xff, 0xff };
+            uint8_t uncodedData[maximumDataLength - 4] = { 0xff, 0xff, 0xff, 0xff };
         } additionalData;
     } _windowRoofAndMirrorControl = {};
     struct DoorLockControl {
         bool lockDoors;
         struct AdditionalData {
             uint8_t dataLengthCode = 8;
-            uint8_t uncodedData[4] = {};
+            uint8_t uncodedData[maximumDataLength - 4] = {};
         } additionalData;
     } _doorLockControl = {};
     struct DateTime {
@@ -158,7 +299,11 @@ public:
         int second;
         struct AdditionalData {
             uint8_t dataLengthCode = 8;
-            uint8_t uncodedDataByte7 = 0;
+            union {
+                uint8_t uncodedData[maximumDataLength - 7] = {};
+                // Byte 7, its name before CAN FD support
+                uint8_t uncodedDataByte7;
+            };
         } additionalData;
     } _dateTime = {};
     struct PassengerSideFrontSeatSeatbeltAndSeatOccupancyStatus {
@@ -176,4 +321,97 @@ public:
     struct HandbrakeStatus {
         bool handbrakeIsActive;
     } _handbrakeStatus = {};
+
+    /// @brief Check whether a message can be decoded
+    /// @param identifier CAN message identifier
+    /// @return true when Decode accepts messages with this identifier
+    static bool IsDecodable(Identifier identifier);
+    /// @brief Check whether a message can be encoded
+    /// @param identifier CAN message identifier
+    /// @return true when Encode produces a message for this identifier
+    static bool IsEncodable(Identifier identifier);
+    /// @brief Get the identifiers of all supported messages
+    /// @param outIdentifiers Receives the identifiers, may be nullptr
+    /// @param inMaximumCount Maximum number of identifiers to store in outIdentifiers
+    /// @return The number of supported messages, which can be more than inMaximumCount
+    static size_t GetIdentifiers(Identifier* outIdentifiers, size_t inMaximumCount);
+    /// @brief Get the position of a message in the order of GetIdentifiers
+    ///
+    /// Components keeping data per message can index an array of messageCount entries with it
+    /// @param identifier CAN message identifier
+    /// @return The position, messageCount when the message is not supported
+    static size_t GetMessageIndex(Identifier identifier);
+
+    /// @brief Type of a decoded field
+    enum class FieldType : uint8_t {
+        boolean,
+        character,
+        integer,
+        unsignedShort
+    };
+    /// @brief Description of a decoded field of a message struct
+    struct Field {
+        const char* name;
+        FieldType type;
+        // Offset of the field within CanCoder
+        uint16_t offset;
+    };
+    /// @brief Get the decoded fields of a message
+    ///
+    /// Field n corresponds to bit n of the changed fields of DecodeChanges
+    /// @param identifier CAN message identifier
+    /// @param outFields The fields, nullptr for unsupported identifiers
+    /// @return The number of fields
+    static size_t GetFields(Identifier identifier, const Field*& outFields);
+    /// @brief Get the bit of a field in the changed fields of DecodeChanges
+    /// @param identifier CAN message identifier
+    /// @param fieldName Name of the field in its message struct, for example "bootIsOpen"
+    /// @return The bit of the field, 0 when the message has no such field
+    static uint32_t GetFieldMask(Identifier identifier, const char* fieldName);
+    /// @brief Get the value of a decoded field
+    /// @param field The field, from GetFields
+    /// @return The value, booleans are 0 or 1
+    int32_t GetFieldValue(const Field& field) const;
+
+    /// @brief Number of supported messages, see GetIdentifiers
+    static constexpr size_t messageCount = 17;
+    /// @brief Number of buckets of the latency histogram
+    static constexpr size_t latencyBucketCount = 32;
+    /// @brief Counters of the decode and encode paths
+    struct Statistics {
+        // Per supported message, in the order of GetIdentifiers, see GetMessageIndex
+        // DecodeChanges also counts the messages that did not change
+        uint64_t decodedCount[messageCount];
+        uint64_t encodedCount[messageCount];
+        // Messages with an identifier that is not supported
+        uint64_t unknownIdentifierCount;
+        // Messages with less data than the message needs
+        uint64_t tooShortCount;
+        // Messages with a data length code above 8 or an invalid CAN FD length
+        uint64_t tooLongCount;
+        // Bucket n counts sampled decodes that took 2^(n-1) up to 2^n ticks, bucket 0 those of 0 ticks
+        uint64_t latencyHistogram[latencyBucketCount];
+        uint64_t sampleCounter;
+    };
+    /// @brief Get a copy of the statistics
+    ///
+    /// The counters are plain members of this instance, updated by the thread that decodes.
+    /// Other threads can read them from a CanSnapshot of this instance.
+    /// @param outStatistics Receives the statistics, all zero without CANCODER_STATISTICS
+    /// @return true on success, false when compiled without CANCODER_STATISTICS
+    bool GetStatistics(Statistics& outStatistics) const;
+    /// @brief Set all statistics to zero
+    void ResetStatistics();
+#if CANCODER_STATISTICS
+    Statistics _statistics = {};
+#endif
+
+    // Data of the last message decoded by DecodeChanges for each message struct
+    // The data length code is stored plus 1, 0 means there is no last message
+    static constexpr size_t messageStructCount = 16;
+    uint64_t _lastData[messageStructCount] = {};
+    uint8_t _lastDataLengthCode[messageStructCount] = {};
+
+private:
+    bool DecodeData(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData);
 };
\ No newline at end of file
@@ -0,0 +1,354 @@
+#include "CanColumns.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace {
+    const char headerMagic[8] = { 'C', 'A', 'N', 'C', 'O', 'L', '0', '1' };
+
+    struct Header {
+        char magic[8];
+        uint32_t tableCount;
+        uint32_t columnCount;
+        uint64_t tableDirectoryPosition;
+        uint64_t columnDirectoryPosition;
+    };
+
+    struct TableEntry {
+        uint32_t identifier;
+        uint32_t reserved;
+        uint64_t rowCount;
+        uint64_t timestampsPosition;
+    };
+
+    struct ColumnEntry {
+        char name[48];
+        uint32_t identifier;
+        uint8_t type;
+        uint8_t encoding;
+        uint16_t reserved;
+        uint64_t rowCount;
+        uint64_t position;
+        uint64_t size;
+    };
+
+    CanColumnEncoding EncodingOf(CanCoder::FieldType type) {
+        switch (type) {
+        case CanCoder::FieldType::boolean:
+            return CanColumnEncoding::bitPacked;
+        case CanCoder::FieldType::character:
+            return CanColumnEncoding::runLength;
+        default:
+            return CanColumnEncoding::plain;
+        }
+    }
+
+    // Writes data at 8 byte aligned positions, keeping track of the position
+    class FileWriter {
+    public:
+        explicit FileWriter(FILE* file) : _file(file) {}
+
+        uint64_t Write(const void* data, size_t size) {
+            uint64_t position = _position;
+            _success &= size == 0 || fwrite(data, size, 1, _file) == 1;
+            _position += size;
+            static const uint8_t padding[8] = {};
+            size_t paddingSize = (8 - _position % 8) % 8;
+            _success &= paddingSize == 0 || fwrite(padding, paddingSize, 1, _file) == 1;
+            _position += paddingSize;
+            return position;
+        }
+
+        uint64_t GetPosition() const { return _position; }
+        bool GetSuccess() const { return _success; }
+
+    private:
+        FILE* _file;
+        uint64_t _position = 0;
+        bool _success = true;
+    };
+}
+
+CanColumnWriter::CanColumnWriter() {
+    CanCoder::Identifier identifiers[CanCoder::messageCount];
+    size_t identifierCount = CanCoder::GetIdentifiers(identifiers, CanCoder::messageCount);
+    for (size_t index = 0; index < identifierCount; index++) {
+        Table table;
+        table.identifier = (uint32_t)identifiers[index];
+        const CanCoder::Field* fields;
+        size_t fieldCount = CanCoder::GetFields(identifiers[index], fields);
+        for (size_t fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++) {
+            Column column;
+            column.field = fields[fieldIndex];
+            column.encoding = EncodingOf(fields[fieldIndex].type);
+            table.columns.push_back(std::move(column));
+        }
+        _tables.push_back(std::move(table));
+    }
+}
+
+bool CanColumnWriter::Add(const CanCoder::Frame& inFrame) {
+    if (!_coder.Decode(inFrame.identifier, inFrame.dataLengthCode, (uint8_t*)inFrame.data)) {
+        return false;
+    }
+    Append(_coder, inFrame.timestamp);
+    return true;
+}
+
+void CanColumnWriter::Append(const CanCoder& inCoder, uint64_t inTimestamp) {
+    size_t messageIndex = CanCoder::GetMessageIndex(inCoder._identifier);
+    if (messageIndex == CanCoder::messageCount) {
+        return;
+    }
+    Table& table = _tables[messageIndex];
+    uint64_t row = table.timestamps.size();
+    table.timestamps.push_back(inTimestamp);
+    for (Column& column : table.columns) {
+        int32_t value = inCoder.GetFieldValue(column.field);
+        switch (column.encoding) {
+        case CanColumnEncoding::bitPacked:
+            if (row % 64 == 0) {
+                column.bits.push_back(0);
+            }
+            column.bits.back() |= (uint64_t)(value != 0) << (row % 64);
+            break;
+        case CanColumnEncoding::runLength:
+            if (!column.runs.empty() && column.runs.back().value == value) {
+                column.runs.back().endRow = row + 1;
+            }
+            else {
+                column.runs.push_back({ row + 1, value, 0 });
+            }
+            break;
+        case CanColumnEncoding::plain:
+            if (column.field.type == CanCoder::FieldType::unsignedShort) {
+                column.unsignedShorts.push_back((uint16_t)value);
+            }
+            else {
+                column.integers.push_back(value);
+            }
+            break;
+        }
+    }
+}
+
+size_t CanColumnWriter::GetRowCount(uint32_t inIdentifier) const {
+    size_t messageIndex = CanCoder::GetMessageIndex((CanCoder::Identifier)inIdentifier);
+    if (messageIndex == CanCoder::messageCount) {
+        return 0;
+    }
+    return _tables[messageIndex].timestamps.size();
+}
+
+bool CanColumnWriter::Write(const char* inPath) const {
+    FILE* file = fopen(inPath, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    FileWriter writer(file);
+    Header header = {};
+    writer.Write(&header, sizeof(header));
+
+    // Only messages that were decoded are written
+    std::vector<TableEntry> tableEntries;
+    std::vector<ColumnEntry> columnEntries;
+    for (const Table& table : _tables) {
+        if (table.timestamps.empty()) {
+            continue;
+        }
+        TableEntry tableEntry = {};
+        tableEntry.identifier = table.identifier;
+        tableEntry.rowCount = table.timestamps.size();
+        tableEntry.timestampsPosition = writer.Write(table.timestamps.data(), table.timestamps.size() * sizeof(uint64_t));
+        tableEntries.push_back(tableEntry);
+        for (const Column& column : table.columns) {
+            ColumnEntry columnEntry = {};
+            strncpy(columnEntry.name, column.field.name, sizeof(columnEntry.name) - 1);
+            columnEntry.identifier = table.identifier;
+            columnEntry.type = (uint8_t)column.field.type;
+            columnEntry.encoding = (uint8_t)column.encoding;
+            columnEntry.rowCount = table.timestamps.size();
+            switch (column.encoding) {
+            case CanColumnEncoding::bitPacked:
+                columnEntry.size = column.bits.size() * sizeof(uint64_t);
+                columnEntry.position = writer.Write(column.bits.data(), columnEntry.size);
+                break;
+            case CanColumnEncoding::runLength:
+                columnEntry.size = column.runs.size() * sizeof(CanColumnRun);
+                columnEntry.position = writer.Write(column.runs.data(), columnEntry.size);
+                break;
+            case CanColumnEncoding::plain:
+                if (column.field.type == CanCoder::FieldType::unsignedShort) {
+                    columnEntry.size = column.unsignedShorts.size() * sizeof(uint16_t);
+                    columnEntry.position = writer.Write(column.unsignedShorts.data(), columnEntry.size);
+                }
+                else {
+                    columnEntry.size = column.integers.size() * sizeof(int32_t);
+                    columnEntry.position = writer.Write(column.integers.data(), columnEntry.size);
+                }
+                break;
+            }
+            columnEntries.push_back(columnEntry);
+        }
+    }
+
+    memcpy(header.magic, headerMagic, sizeof(header.magic));
+    header.tableCount = (uint32_t)tableEntries.size();
+    header.columnCount = (uint32_t)columnEntries.size();
+    header.tableDirectoryPosition = writer.Write(tableEntries.data(), tableEntries.size() * sizeof(TableEntry));
+    header.columnDirectoryPosition = writer.Write(columnEntries.data(), columnEntries.size() * sizeof(ColumnEntry));
+    bool success = writer.GetSuccess();
+    success &= fseek(file, 0, SEEK_SET) == 0;
+    success &= fwrite(&header, sizeof(header), 1, file) == 1;
+    success &= fclose(file) == 0;
+    return success;
+}
+
+void CanColumnWriter::Clear() {
+    for (Table& table : _tables) {
+        table.timestamps.clear();
+        for (Column& column : table.columns) {
+            column.bits.clear();
+            column.integers.clear();
+            column.unsignedShorts.clear();
+            column.runs.clear();
+        }
+    }
+}
+
+int32_t CanColumnReader::Column::GetValue(uint64_t inRow) const {
+    switch (encoding) {
+    case CanColumnEncoding::bitPacked:
+        return (int32_t)((((const uint64_t*)data)[inRow / 64] >> (inRow % 64)) & 1);
+    case CanColumnEncoding::runLength: {
+        const CanColumnRun* runs = (const CanColumnRun*)data;
+        const CanColumnRun* runsEnd = runs + size / sizeof(CanColumnRun);
+        const CanColumnRun* run = std::upper_bound(runs, runsEnd, inRow,
+            [](uint64_t row, const CanColumnRun& run) { return row < run.endRow; });
+        return run < runsEnd ? run->value : 0;
+    }
+    case CanColumnEncoding::plain:
+        if (type == CanCoder::FieldType::unsignedShort) {
+            return ((const uint16_t*)data)[inRow];
+        }
+        return ((const int32_t*)data)[inRow];
+    }
+    return 0;
+}
+
+CanColumnReader::~CanColumnReader() {
+    Close();
+}
+
+bool CanColumnReader::Open(const char* inPath) {
+    Close();
+    _fileDescriptor = open(inPath, O_RDONLY | O_CLOEXEC);
+    if (_fileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(_fileDescriptor, &fileStatus) != 0 || (size_t)fileStatus.st_size < sizeof(Header)) {
+        Close();
+        return false;
+    }
+    void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    _data = (const uint8_t*)data;
+    _size = fileStatus.st_size;
+
+    // Positions and counts come from the file, they are checked without sums that can overflow
+    Header header;
+    memcpy(&header, _data, sizeof(header));
+    if (memcmp(header.magic, headerMagic, sizeof(headerMagic)) != 0 ||
+        header.tableDirectoryPosition % 8 != 0 ||
+        header.columnDirectoryPosition % 8 != 0 ||
+        header.tableDirectoryPosition > _size ||
+        header.tableCount > (_size - header.tableDirectoryPosition) / sizeof(TableEntry) ||
+        header.columnDirectoryPosition > _size ||
+        header.columnCount > (_size - header.columnDirectoryPosition) / sizeof(ColumnEntry)) {
+        Close();
+        return false;
+    }
+    const TableEntry* tableEntries = (const TableEntry*)(_data + header.tableDirectoryPosition);
+    for (uint32_t index = 0; index < header.tableCount; index++) {
+        const TableEntry& entry = tableEntries[index];
+        if (entry.timestampsPosition % 8 != 0 || entry.timestampsPosition > _size ||
+            entry.rowCount > (_size - entry.timestampsPosition) / sizeof(uint64_t)) {
+            Close();
+            return false;
+        }
+        _tables.push_back({ entry.identifier, entry.rowCount, (const uint64_t*)(_data + entry.timestampsPosition) });
+    }
+    const ColumnEntry* columnEntries = (const ColumnEntry*)(_data + header.columnDirectoryPosition);
+    for (uint32_t index = 0; index < header.columnCount; index++) {
+        const ColumnEntry& entry = columnEntries[index];
+        CanCoder::FieldType type = (CanCoder::FieldType)entry.type;
+        CanColumnEncoding encoding = (CanColumnEncoding)entry.encoding;
+        // A column has a row for each timestamp of its table
+        auto table = std::find_if(_tables.begin(), _tables.end(), [&](const Table& table) { return table.identifier == entry.identifier; });
+        if (entry.position % 8 != 0 || entry.position > _size || entry.size > _size - entry.position ||
+            table == _tables.end() || entry.rowCount != table->rowCount ||
+            entry.type > (uint8_t)CanCoder::FieldType::unsignedShort || entry.encoding > (uint8_t)CanColumnEncoding::runLength ||
+            entry.name[sizeof(entry.name) - 1] != 0) {
+            Close();
+            return false;
+        }
+        // The data must hold all rows, except for run-length encoded columns which GetValue searches.
+        // The row count is at most the file size / 8, so these products do not overflow.
+        uint64_t requiredSize = entry.size;
+        if (encoding == CanColumnEncoding::bitPacked) {
+            requiredSize = (entry.rowCount + 63) / 64 * sizeof(uint64_t);
+        }
+        else if (encoding == CanColumnEncoding::plain) {
+            requiredSize = entry.rowCount * (type == CanCoder::FieldType::unsignedShort ? sizeof(uint16_t) : sizeof(int32_t));
+        }
+        if (entry.size < requiredSize) {
+            Close();
+            return false;
+        }
+        _columns.push_back({ entry.identifier, entry.name, type, encoding, entry.rowCount, _data + entry.position, entry.size });
+    }
+    return true;
+}
+
+void CanColumnReader::Close() {
+    if (_data != nullptr) {
+        munmap((void*)_data, _size);
+        _data = nullptr;
+        _size = 0;
+    }
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+    _tables.clear();
+    _columns.clear();
+}
+
+const CanColumnReader::Column* CanColumnReader::FindColumn(uint32_t inIdentifier, const char* inName) const {
+    for (const Column& column : _columns) {
+        if (column.identifier == inIdentifier && strcmp(column.name, inName) == 0) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+const uint64_t* CanColumnReader::GetTimestamps(uint32_t inIdentifier, uint64_t& outRowCount) const {
+    for (const Table& table : _tables) {
+        if (table.identifier == inIdentifier) {
+            outRowCount = table.rowCount;
+            return table.timestamps;
+        }
+    }
+    outRowCount = 0;
+    return nullptr;
+}
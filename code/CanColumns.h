@@ -0,0 +1,167 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanColumns
+ *
+ * Columnar storage of decoded fields for analytics
+ *
+ * CanColumnWriter decodes frames and appends every decoded field to a column of its
+ * own, instead of updating one CanCoder in place. Each message has a table of rows, one
+ * row per decoded frame, with a timestamp column shared by the columns of its fields.
+ * Scanning one field over millions of frames then reads only that column.
+ * The encoding of a column depends on the type of its field:
+ * booleans are bit-packed, 64 rows per word
+ * characters, such as the gear position, are run-length encoded
+ * integers and unsigned shorts are stored as plain arrays of int32_t and uint16_t
+ *
+ * The columns are written to a file that CanColumnReader memory maps, the columns are
+ * used in place without copying.
+ *
+ * File layout (little endian, all sections 8 byte aligned):
+ * Header        "CANCOL01", table count, column count, positions of the directories
+ * Column data   Timestamps of each table (uint64_t) and the data of each column
+ * Tables        For each message its identifier, row count, timestamps and columns
+ * Columns       For each column its name, type, encoding, position and size
+ *
+ * For example, the mean speed of a capture:
+ *     CanColumnWriter writer;
+ *     capture.ForEachFrame([&](const CanCoder::Frame& frame) { writer.Add(frame); });
+ *     writer.Write("drive.cancol");
+ *
+ *     CanColumnReader reader;
+ *     reader.Open("drive.cancol");
+ *     const CanColumnReader::Column* speed = reader.FindColumn((uint32_t)CanCoder::Identifier::vehicleSpeed, "speed");
+ *     const int32_t* speeds = (const int32_t*)speed->data;
+ *     // Sum speeds[0] to speeds[speed->rowCount - 1]
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum class CanColumnEncoding : uint8_t {
+    // Array of int32_t for integers, uint16_t for unsigned shorts
+    plain,
+    // Bit (row % 64) of uint64_t word (row / 64)
+    bitPacked,
+    // Array of CanColumnRun, in row order
+    runLength
+};
+
+/// @brief Run of equal values in a run-length encoded column
+struct CanColumnRun {
+    // Row after the last row of the run
+    uint64_t endRow;
+    int32_t value;
+    uint32_t reserved;
+};
+
+class CanColumnWriter {
+public:
+    CanColumnWriter();
+
+    /// @brief Decode a frame and append its fields when it was decoded
+    /// @param inFrame The frame
+    /// @return true when the frame was decoded, false otherwise
+    bool Add(const CanCoder::Frame& inFrame);
+    /// @brief Append the fields of the message last decoded by a coder
+    /// @param inCoder The coder, its _identifier selects the message
+    /// @param inTimestamp Timestamp of the message
+    void Append(const CanCoder& inCoder, uint64_t inTimestamp);
+    /// @brief Get the number of rows of a message
+    size_t GetRowCount(uint32_t inIdentifier) const;
+    /// @brief Write all columns to a file
+    /// @param inPath Path of the file
+    /// @return true on success, false on failure
+    bool Write(const char* inPath) const;
+    /// @brief Remove all rows
+    void Clear();
+
+private:
+    struct Column {
+        CanCoder::Field field;
+        CanColumnEncoding encoding;
+        // Used depending on the encoding
+        std::vector<uint64_t> bits;
+        std::vector<int32_t> integers;
+        std::vector<uint16_t> unsignedShorts;
+        std::vector<CanColumnRun> runs;
+    };
+    struct Table {
+        uint32_t identifier;
+        std::vector<uint64_t> timestamps;
+        std::vector<Column> columns;
+    };
+
+    CanCoder _coder;
+    // One table per supported message, by CanCoder::GetMessageIndex
+    std::vector<Table> _tables;
+};
+
+class CanColumnReader {
+public:
+    /// @brief A column in the file
+    struct Column {
+        uint32_t identifier;
+        const char* name;
+        CanCoder::FieldType type;
+        CanColumnEncoding encoding;
+        uint64_t rowCount;
+        // Data as described by the encoding, valid while the reader is open
+        const void* data;
+        uint64_t size;
+
+        /// @brief Get the value of a row, booleans are 0 or 1
+        /// @param inRow The row, must be less than rowCount
+        int32_t GetValue(uint64_t inRow) const;
+    };
+
+    CanColumnReader() = default;
+    CanColumnReader(const CanColumnReader&) = delete;
+    CanColumnReader& operator=(const CanColumnReader&) = delete;
+    ~CanColumnReader();
+
+    /// @brief Open and memory map a column file
+    /// @param inPath Path of the file
+    /// @return true on success, false when the file can not be mapped or is not a valid column file
+    bool Open(const char* inPath);
+    /// @brief Close the file
+    void Close();
+
+    /// @brief Get all columns
+    const std::vector<Column>& GetColumns() const { return _columns; }
+    /// @brief Find a column
+    /// @param inIdentifier CAN message identifier
+    /// @param inName Name of the field
+    /// @return The column, nullptr when it does not exist
+    const Column* FindColumn(uint32_t inIdentifier, const char* inName) const;
+    /// @brief Get the timestamps of the rows of a message
+    /// @param inIdentifier CAN message identifier
+    /// @param outRowCount Receives the number of rows
+    /// @return The timestamps, nullptr when the message is not in the file
+    const uint64_t* GetTimestamps(uint32_t inIdentifier, uint64_t& outRowCount) const;
+
+private:
+    struct Table {
+        uint32_t identifier;
+        uint64_t rowCount;
+        const uint64_t* timestamps;
+    };
+
+    int _fileDescriptor = -1;
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    std::vector<Table> _tables;
+    std::vector<Column> _columns;
+};
@@ -0,0 +1,51 @@
+#include "CanDispatcher.h"
+#include <algorithm>
+
+bool CanDispatcher::Subscribe(CanCoder::Identifier inIdentifier, uint32_t inFieldMask, Listener inListener, void* inContext) {
+    if (_subscriptionCount == maximumSubscriptionCount || inListener == nullptr) {
+        return false;
+    }
+    uint32_t identifier = (uint32_t)inIdentifier;
+    Subscription* end = _subscriptions + _subscriptionCount;
+    Subscription* position = std::upper_bound(_subscriptions, end, identifier,
+        [](uint32_t identifier, const Subscription& subscription) { return identifier < subscription.identifier; });
+    std::move_backward(position, end, end + 1);
+    *position = { identifier, inFieldMask, inListener, inContext };
+    _subscriptionCount++;
+    return true;
+}
+
+bool CanDispatcher::Subscribe(CanCoder::Identifier inIdentifier, const char* inFieldName, Listener inListener, void* inContext) {
+    uint32_t fieldMask = CanCoder::GetFieldMask(inIdentifier, inFieldName);
+    if (fieldMask == 0) {
+        return false;
+    }
+    return Subscribe(inIdentifier, fieldMask, inListener, inContext);
+}
+
+size_t CanDispatcher::Unsubscribe(Listener inListener, void* inContext) {
+    Subscription* end = std::remove_if(_subscriptions, _subscriptions + _subscriptionCount,
+        [&](const Subscription& subscription) { return subscription.listener == inListener && subscription.context == inContext; });
+    size_t removedCount = _subscriptions + _subscriptionCount - end;
+    _subscriptionCount -= removedCount;
+    return removedCount;
+}
+
+bool CanDispatcher::Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData) {
+    uint32_t changedFields;
+    if (!_coder.DecodeChanges(inIdentifier, inDataLengthCode, inData, changedFields)) {
+        return false;
+    }
+    if (changedFields == 0) {
+        return true;
+    }
+    const Subscription* end = _subscriptions + _subscriptionCount;
+    const Subscription* subscription = std::lower_bound((const Subscription*)_subscriptions, end, inIdentifier,
+        [](const Subscription& subscription, uint32_t identifier) { return subscription.identifier < identifier; });
+    for (; subscription < end && subscription->identifier == inIdentifier; subscription++) {
+        if ((subscription->fieldMask & changedFields) != 0) {
+            subscription->listener(subscription->context, _coder, changedFields);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanDispatcher
+ *
+ * Calling listeners when decoded fields change
+ *
+ * Instead of inspecting the message structs of CanCoder after every decode, listeners
+ * subscribe to fields of a message. The dispatcher decodes with CanCoder::DecodeChanges
+ * and calls the listeners of the changed fields directly from the decode path.
+ * Listeners are plain function pointers with a context pointer, there are no virtual
+ * calls and no memory is allocated. Member functions can be subscribed as well, the
+ * function pointer calling them is generated at compile time.
+ *
+ * For example, folding the mirrors when the doors are locked:
+ *     class Mirrors {
+ *     public:
+ *         void OnDoorHandleInput(const CanCoder& coder, uint32_t changedFields) {
+ *             if (coder._remoteControlAndDoorHandleInput.remoteControlLockButton) {
+ *                 ...
+ *             }
+ *         }
+ *     };
+ *     CanCoder coder;
+ *     CanDispatcher dispatcher(coder);
+ *     Mirrors mirrors;
+ *     dispatcher.Subscribe<&Mirrors::OnDoorHandleInput>(CanCoder::Identifier::remoteControlAndDoorHandleInput,
+ *         CanCoder::GetFieldMask(CanCoder::Identifier::remoteControlAndDoorHandleInput, "remoteControlLockButton"), mirrors);
+ *     dispatcher.Decode(identifier, dataLengthCode, data);
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class CanDispatcher {
+public:
+    /// @brief Function called when subscribed fields changed
+    /// @param inContext The context passed when subscribing
+    /// @param inCoder The coder holding the decoded message
+    /// @param inChangedFields Bitmask of all fields of the message that changed, see CanCoder::GetFields
+    using Listener = void (*)(void* inContext, const CanCoder& inCoder, uint32_t inChangedFields);
+
+    /// @brief Field mask subscribing to all fields of a message
+    static constexpr uint32_t allFields = 0xffffffff;
+    /// @brief Maximum number of subscriptions
+    static constexpr size_t maximumSubscriptionCount = 64;
+
+    /// @param inCoder The coder to decode with, it must outlive the dispatcher
+    explicit CanDispatcher(CanCoder& inCoder) : _coder(inCoder) {}
+
+    /// @brief Subscribe a listener to fields of a message
+    /// @param inIdentifier CAN message identifier
+    /// @param inFieldMask The fields, see CanCoder::GetFieldMask, or allFields
+    /// @param inListener Function called when one of the fields changed
+    /// @param inContext Passed to the listener
+    /// @return true on success, false when there are maximumSubscriptionCount subscriptions
+    bool Subscribe(CanCoder::Identifier inIdentifier, uint32_t inFieldMask, Listener inListener, void* inContext);
+    /// @brief Subscribe a listener to one field of a message
+    /// @param inIdentifier CAN message identifier
+    /// @param inFieldName Name of the field in its message struct, for example "bootIsOpen"
+    /// @param inListener Function called when the field changed
+    /// @param inContext Passed to the listener
+    /// @return true on success, false when the field does not exist or there are maximumSubscriptionCount subscriptions
+    bool Subscribe(CanCoder::Identifier inIdentifier, const char* inFieldName, Listener inListener, void* inContext);
+    /// @brief Subscribe a member function to fields of a message
+    /// @tparam Method Member function called as (inObject.*Method)(const CanCoder& coder, uint32_t changedFields)
+    /// @param inIdentifier CAN message identifier
+    /// @param inFieldMask The fields, see CanCoder::GetFieldMask, or allFields
+    /// @param inObject Object to call the member function on, it must outlive the subscription
+    /// @return true on success, false when there are maximumSubscriptionCount subscriptions
+    template <auto Method, typename Object>
+    bool Subscribe(CanCoder::Identifier inIdentifier, uint32_t inFieldMask, Object& inObject) {
+        return Subscribe(inIdentifier, inFieldMask, &CallMethod<Method, Object>, &inObject);
+    }
+    /// @brief Remove all subscriptions of a listener with a context
+    /// @param inListener The listener
+    /// @param inContext The context
+    /// @return The number of subscriptions removed
+    size_t Unsubscribe(Listener inListener, void* inContext);
+    /// @brief Remove all subscriptions of a member function of an object
+    template <auto Method, typename Object>
+    size_t Unsubscribe(Object& inObject) {
+        return Unsubscribe(&CallMethod<Method, Object>, &inObject);
+    }
+
+    /// @brief Decode a CAN message and call the listeners of the fields that changed
+    /// @param inIdentifier CAN message identifier
+    /// @param inDataLengthCode CAN message data length code
+    /// @param inData CAN message data
+    /// @return true on success, false on failure
+    bool Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData);
+
+private:
+    struct Subscription {
+        uint32_t identifier;
+        uint32_t fieldMask;
+        Listener listener;
+        void* context;
+    };
+
+    template <auto Method, typename Object>
+    static void CallMethod(void* inContext, const CanCoder& inCoder, uint32_t inChangedFields) {
+        (((Object*)inContext)->*Method)(inCoder, inChangedFields);
+    }
+
+    CanCoder& _coder;
+    // Sorted by identifier, subscriptions of the same identifier keep the order of subscribing
+    Subscription _subscriptions[maximumSubscriptionCount];
+    size_t _subscriptionCount = 0;
+};
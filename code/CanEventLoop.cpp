@@ -0,0 +1,140 @@
+#include "CanEventLoop.h"
+
+CanEventLoop::~CanEventLoop() {
+    for (Waiter*& bucket : _buckets) {
+        while (bucket != nullptr) {
+            std::coroutine_handle<> handle = bucket->_handle;
+            // The waiter is part of the coroutine frame, unlink it before destroying the frame
+            Remove(*bucket);
+            handle.destroy();
+        }
+    }
+}
+
+void CanEventLoop::Spawn(CanTask&& inTask) {
+    std::coroutine_handle<> handle = std::exchange(inTask._handle, nullptr);
+    if (handle) {
+        Resume(handle);
+    }
+}
+
+void CanEventLoop::Resume(std::coroutine_handle<> inHandle) {
+    inHandle.resume();
+    if (inHandle.done()) {
+        inHandle.destroy();
+    }
+}
+
+void CanEventLoop::Add(Waiter& inWaiter) {
+    Waiter*& bucket = _buckets[inWaiter._identifier == Waiter::noIdentifier ? bucketCount : GetBucket(inWaiter._identifier)];
+    inWaiter._previous = nullptr;
+    inWaiter._next = bucket;
+    if (bucket != nullptr) {
+        bucket->_previous = &inWaiter;
+    }
+    bucket = &inWaiter;
+    inWaiter._sequence = _waitCount++;
+    if (inWaiter._deadline < _nextDeadline) {
+        _nextDeadline = inWaiter._deadline;
+    }
+    _waitingCount++;
+}
+
+void CanEventLoop::Remove(Waiter& inWaiter) {
+    if (inWaiter._previous != nullptr) {
+        inWaiter._previous->_next = inWaiter._next;
+    }
+    else {
+        _buckets[inWaiter._identifier == Waiter::noIdentifier ? bucketCount : GetBucket(inWaiter._identifier)] = inWaiter._next;
+    }
+    if (inWaiter._next != nullptr) {
+        inWaiter._next->_previous = inWaiter._previous;
+    }
+    inWaiter._previous = nullptr;
+    inWaiter._next = nullptr;
+    _waitingCount--;
+}
+
+bool CanEventLoop::Decode(const CanCoder::Frame& inFrame) {
+    Poll(inFrame.timestamp);
+    if (!_coder.Decode(inFrame.identifier, inFrame.dataLengthCode, (uint8_t*)inFrame.data)) {
+        return false;
+    }
+    uint32_t identifier = (uint32_t)_coder._identifier;
+    if (identifier < 0x800) {
+        _decodedIdentifiers[identifier / 64] |= 1ull << (identifier % 64);
+    }
+    // The waits that are over are moved to a list of their own first, so coroutines
+    // waiting again for the same identifier wait for the next frame
+    Waiter* ready = nullptr;
+    Waiter* waiter = _buckets[GetBucket(identifier)];
+    while (waiter != nullptr) {
+        Waiter* next = waiter->_next;
+        if (waiter->_identifier == identifier && (waiter->_check == nullptr || waiter->_check(*waiter, _coder))) {
+            Remove(*waiter);
+            waiter->_result = true;
+            waiter->_next = ready;
+            ready = waiter;
+        }
+        waiter = next;
+    }
+    // Resumed in the order the coroutines started waiting
+    while (ready != nullptr) {
+        Waiter* next = ready->_next;
+        Resume(ready->_handle);
+        ready = next;
+    }
+    return true;
+}
+
+void CanEventLoop::Poll(uint64_t inNow) {
+    if (inNow > _now) {
+        _now = inNow;
+    }
+    if (_nextDeadline > _now) {
+        return;
+    }
+    Waiter* ready = nullptr;
+    _nextDeadline = never;
+    for (Waiter* bucket : _buckets) {
+        Waiter* waiter = bucket;
+        while (waiter != nullptr) {
+            Waiter* next = waiter->_next;
+            if (waiter->_deadline <= _now) {
+                Remove(*waiter);
+                waiter->_result = waiter->_timeoutResult;
+                // Sorted by deadline and then by the start of the wait, few waits time out at once
+                Waiter** position = &ready;
+                while (*position != nullptr && ((*position)->_deadline < waiter->_deadline ||
+                        ((*position)->_deadline == waiter->_deadline && (*position)->_sequence < waiter->_sequence))) {
+                    position = &(*position)->_next;
+                }
+                waiter->_next = *position;
+                *position = waiter;
+            }
+            else if (waiter->_deadline < _nextDeadline) {
+                _nextDeadline = waiter->_deadline;
+            }
+            waiter = next;
+        }
+    }
+    while (ready != nullptr) {
+        Waiter* next = ready->_next;
+        Resume(ready->_handle);
+        ready = next;
+    }
+}
+
+bool CanEventLoop::Transmit(CanCoder::Identifier inIdentifier) {
+    if (!CanCoder::IsEncodable(inIdentifier)) {
+        return false;
+    }
+    // Encode uses the identifier of the coder, the identifier of the last decode is restored afterwards
+    CanCoder::Frame frame = {};
+    CanCoder::Identifier identifier = _coder._identifier;
+    _coder._identifier = inIdentifier;
+    _coder.Encode(frame.identifier, frame.dataLengthCode, frame.data);
+    _coder._identifier = identifier;
+    frame.timestamp = _now;
+    return _sink(_context, frame);
+}
@@ -0,0 +1,286 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanEventLoop
+ *
+ * Reaction sequences written as C++20 coroutines
+ *
+ * Control logic is often a sequence of waits: after the lock button, wait until the
+ * mirrors are folded, then send a message. Written as a state machine that polls
+ * CanCoder, every step needs its own state and timeout handling. With the event loop each
+ * sequence is a coroutine returning CanTask that awaits what it needs:
+ * NextFrame    the next decoded message with an identifier
+ * WaitUntil    a predicate on the decoded fields of a message, with a timeout; it holds
+ *              right away when the last decoded message already satisfies it
+ * Delay        a time
+ * The loop is fed the received frames with Decode and the time with Poll, and resumes
+ * the coroutines whose wait is over, all on one thread. A waiting coroutine costs only
+ * its coroutine frame: the wait is linked into the loop from the awaiter inside the
+ * frame, no memory is allocated per wait. The waits are kept by identifier, so a frame
+ * only checks the waits for its own identifier.
+ * Times are in microseconds, the timestamps of the frames and the time passed to Poll
+ * must be from the same clock.
+ *
+ * Coroutines must only await the awaitables of their loop. The loop owns the coroutines
+ * spawned on it, coroutines still waiting are destroyed with the loop.
+ * The loop is not thread safe, it must be used on the thread that owns the coder.
+ *
+ * For example, closing the windows and roof once the mirrors folded after locking:
+ *     CanTask CloseOnLock(CanEventLoop& loop, CanCoder& coder) {
+ *         while (true) {
+ *             co_await loop.NextFrame(CanCoder::Identifier::remoteControlAndDoorHandleInput);
+ *             if (!coder._remoteControlAndDoorHandleInput.remoteControlLockButton) {
+ *                 continue;
+ *             }
+ *             if (co_await loop.WaitUntil(CanCoder::Identifier::mirrorFoldStatus,
+ *                     [](const CanCoder& coder) { return coder._mirrorFoldStatus.folded; }, 2000000)) {
+ *                 coder._windowRoofAndMirrorControl.closeWindowsAndRoof = true;
+ *                 loop.Transmit(CanCoder::Identifier::windowRoofAndMirrorControl);
+ *             }
+ *         }
+ *     }
+ *     CanEventLoop loop(coder, Send, nullptr);
+ *     loop.Spawn(CloseOnLock(loop, coder));
+ *     while (running) {
+ *         // Receive a frame, waiting at most until loop.NextDueTime()
+ *         loop.Decode(frame);
+ *         loop.Poll(now);
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: timed out waits are resumed in the order of their deadlines
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+class CanEventLoop;
+
+/// @brief Coroutine run by CanEventLoop
+class CanTask {
+public:
+    struct promise_type {
+        CanTask get_return_object() { return CanTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        // The coroutine starts when it is spawned on a loop
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        // The loop destroys the coroutine when it is done
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    CanTask(CanTask&& inTask) noexcept : _handle(std::exchange(inTask._handle, nullptr)) {}
+    CanTask(const CanTask&) = delete;
+    CanTask& operator=(const CanTask&) = delete;
+    ~CanTask() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+private:
+    friend class CanEventLoop;
+
+    explicit CanTask(std::coroutine_handle<promise_type> inHandle) : _handle(inHandle) {}
+
+    std::coroutine_handle<promise_type> _handle;
+};
+
+class CanEventLoop {
+public:
+    /// @brief Function transmitting a frame
+    /// @param inContext The context passed to the loop
+    /// @param inFrame The frame, its timestamp is the time of the loop
+    /// @return true on success, false on failure
+    using Sink = bool (*)(void* inContext, const CanCoder::Frame& inFrame);
+
+    /// @brief Timeout of waits without a timeout, and due time returned by NextDueTime when nothing is due
+    static constexpr uint64_t never = UINT64_MAX;
+
+    /// @brief A coroutine waiting in the loop, part of the awaiters
+    class Waiter {
+    public:
+        void await_suspend(std::coroutine_handle<> inHandle) {
+            _handle = inHandle;
+            _loop->Add(*this);
+        }
+        /// @return true when the wait is over, false when it timed out
+        bool await_resume() const { return _result; }
+
+    protected:
+        friend class CanEventLoop;
+
+        // Checks the decoded message, nullptr to accept every message of the identifier
+        using Check = bool (*)(const Waiter& inWaiter, const CanCoder& inCoder);
+        static constexpr uint32_t noIdentifier = 0xffffffff;
+
+        Waiter(CanEventLoop& inLoop, uint32_t inIdentifier, Check inCheck, uint64_t inTimeout, bool inTimeoutResult) :
+            _loop(&inLoop),
+            _identifier(inIdentifier),
+            _check(inCheck),
+            _deadline(inTimeout == never || inLoop._now > never - inTimeout ? never : inLoop._now + inTimeout),
+            _timeoutResult(inTimeoutResult) {}
+
+        CanEventLoop* _loop;
+        uint32_t _identifier;
+        Check _check;
+        uint64_t _deadline;
+        bool _timeoutResult;
+        bool _result = false;
+        // Order in which the waits started
+        uint64_t _sequence = 0;
+        std::coroutine_handle<> _handle;
+        Waiter* _previous = nullptr;
+        Waiter* _next = nullptr;
+    };
+
+    /// @brief Awaiter of NextFrame
+    class FrameAwaiter : public Waiter {
+    public:
+        bool await_ready() const { return false; }
+
+    private:
+        friend class CanEventLoop;
+
+        FrameAwaiter(CanEventLoop& inLoop, uint32_t inIdentifier, uint64_t inTimeout) :
+            Waiter(inLoop, inIdentifier, nullptr, inTimeout, false) {}
+    };
+
+    /// @brief Awaiter of WaitUntil
+    template <typename Predicate>
+    class PredicateAwaiter : public Waiter {
+    public:
+        bool await_ready() {
+            // The predicate may already hold for the last decoded message
+            _result = _loop->IsDecoded(_identifier) && _predicate(std::as_const(_loop->_coder));
+            return _result;
+        }
+
+    private:
+        friend class CanEventLoop;
+
+        PredicateAwaiter(CanEventLoop& inLoop, uint32_t inIdentifier, Predicate&& inPredicate, uint64_t inTimeout) :
+            Waiter(inLoop, inIdentifier, &CheckPredicate, inTimeout, false),
+            _predicate(std::forward<Predicate>(inPredicate)) {}
+
+        static bool CheckPredicate(const Waiter& inWaiter, const CanCoder& inCoder) {
+            return static_cast<const PredicateAwaiter&>(inWaiter)._predicate(inCoder);
+        }
+
+        Predicate _predicate;
+    };
+
+    /// @brief Awaiter of Delay
+    class DelayAwaiter : public Waiter {
+    public:
+        bool await_ready() const { return _deadline <= _loop->_now; }
+
+    private:
+        friend class CanEventLoop;
+
+        DelayAwaiter(CanEventLoop& inLoop, uint64_t inDuration) :
+            Waiter(inLoop, noIdentifier, nullptr, inDuration, true) {
+            _result = true;
+        }
+    };
+
+    /// @param inCoder The coder to decode and encode with, it must outlive the loop
+    /// @param inSink Function transmitting the frames of Transmit
+    /// @param inContext Passed to the sink
+    CanEventLoop(CanCoder& inCoder, Sink inSink, void* inContext) : _coder(inCoder), _sink(inSink), _context(inContext) {}
+    CanEventLoop(const CanEventLoop&) = delete;
+    CanEventLoop& operator=(const CanEventLoop&) = delete;
+    /// @brief Destroys the coroutines that are still waiting
+    ~CanEventLoop();
+
+    /// @brief Start a coroutine, it runs until its first wait
+    /// @param inTask The coroutine, the loop takes ownership
+    void Spawn(CanTask&& inTask);
+
+    /// @brief Wait for the next decoded message with an identifier
+    /// @param inIdentifier CAN message identifier
+    /// @param inTimeout Maximum time to wait in microseconds, never to wait forever
+    /// @return Awaitable resulting in true when the message was decoded, false on timeout
+    FrameAwaiter NextFrame(CanCoder::Identifier inIdentifier, uint64_t inTimeout = never) {
+        return FrameAwaiter(*this, (uint32_t)inIdentifier, inTimeout);
+    }
+    /// @brief Wait until a predicate holds for a decoded message
+    ///
+    /// The predicate is checked right away when the message was decoded before, and then
+    /// after each decode of the message.
+    /// @param inIdentifier CAN message identifier
+    /// @param inPredicate Called as bool inPredicate(const CanCoder& coder)
+    /// @param inTimeout Maximum time to wait in microseconds, never to wait forever
+    /// @return Awaitable resulting in true when the predicate held, false on timeout
+    template <typename Predicate>
+    PredicateAwaiter<Predicate> WaitUntil(CanCoder::Identifier inIdentifier, Predicate&& inPredicate, uint64_t inTimeout = never) {
+        return PredicateAwaiter<Predicate>(*this, (uint32_t)inIdentifier, std::forward<Predicate>(inPredicate), inTimeout);
+    }
+    /// @brief Wait for a time
+    /// @param inDuration Time to wait in microseconds
+    /// @return Awaitable resulting in true
+    DelayAwaiter Delay(uint64_t inDuration) { return DelayAwaiter(*this, inDuration); }
+
+    /// @brief Decode a frame and resume the coroutines waiting for it
+    ///
+    /// The time of the loop advances to the timestamp of the frame first, resuming the
+    /// coroutines whose wait timed out before the frame.
+    /// @param inFrame The frame
+    /// @return true when the frame was decoded, false otherwise
+    bool Decode(const CanCoder::Frame& inFrame);
+    /// @brief Advance the time of the loop and resume the coroutines whose wait timed out
+    ///
+    /// The coroutines are resumed in the order of their deadlines, those with the same deadline
+    /// in the order they started waiting.
+    /// @param inNow The current time, earlier times are ignored
+    void Poll(uint64_t inNow);
+    /// @brief Get the time at which Poll should be called next, never when no wait has a timeout
+    ///
+    /// The time can be earlier than needed after waits ended, Poll then resumes nothing.
+    uint64_t NextDueTime() const { return _nextDeadline; }
+    /// @brief Encode a message with the current state of the coder and pass it to the sink
+    /// @param inIdentifier CAN message identifier, the message must be encodable
+    /// @return true on success, false when the message is not encodable or the sink failed
+    bool Transmit(CanCoder::Identifier inIdentifier);
+
+    /// @brief Get the time of the loop
+    uint64_t GetTime() const { return _now; }
+    /// @brief Get the number of coroutines waiting
+    size_t GetWaitingCount() const { return _waitingCount; }
+
+private:
+    static constexpr size_t bucketCount = 64;
+
+    static size_t GetBucket(uint32_t inIdentifier) { return inIdentifier % bucketCount; }
+
+    bool IsDecoded(uint32_t inIdentifier) const {
+        return inIdentifier < 0x800 && ((_decodedIdentifiers[inIdentifier / 64] >> (inIdentifier % 64)) & 1) != 0;
+    }
+    void Add(Waiter& inWaiter);
+    void Remove(Waiter& inWaiter);
+    static void Resume(std::coroutine_handle<> inHandle);
+
+    CanCoder& _coder;
+    Sink _sink;
+    void* _context;
+    uint64_t _now = 0;
+    uint64_t _nextDeadline = never;
+    size_t _waitingCount = 0;
+    uint64_t _waitCount = 0;
+    // Waits by identifier, Delay waits in the last bucket
+    Waiter* _buckets[bucketCount + 1] = {};
+    // Bit for each standard identifier decoded by the loop
+    uint64_t _decodedIdentifiers[0x800 / 64] = {};
+};
@@ -0,0 +1,178 @@
+#include "CanFilter.h"
+#include <string.h>
+#include <bit>
+
+namespace {
+    using FieldLoader = int32_t (*)(const uint8_t* value);
+
+    template <typename Type>
+    int32_t LoadField(const uint8_t* value) {
+        Type typedValue;
+        memcpy(&typedValue, value, sizeof(typedValue));
+        return (int32_t)typedValue;
+    }
+
+    FieldLoader GetFieldLoader(CanCoder::FieldType type) {
+        switch (type) {
+        case CanCoder::FieldType::boolean:
+            return LoadField<bool>;
+        case CanCoder::FieldType::character:
+            return LoadField<char>;
+        case CanCoder::FieldType::integer:
+            return LoadField<int>;
+        case CanCoder::FieldType::unsignedShort:
+            return LoadField<unsigned short>;
+        }
+        return nullptr;
+    }
+}
+
+CanFilter::Slot* CanFilter::FindSlot(CanCoder::Identifier inIdentifier) {
+    size_t messageIndex = CanCoder::GetMessageIndex(inIdentifier);
+    if (messageIndex == CanCoder::messageCount) {
+        return nullptr;
+    }
+    return &_slots[messageIndex];
+}
+
+bool CanFilter::SetRateLimit(CanCoder::Identifier inIdentifier, uint64_t inMinimumInterval) {
+    Slot* slot = FindSlot(inIdentifier);
+    if (slot == nullptr) {
+        return false;
+    }
+    slot->minimumInterval = inMinimumInterval;
+    return true;
+}
+
+bool CanFilter::AddRule(CanCoder::Identifier inIdentifier, size_t inFieldIndex, uint32_t inDeadband) {
+    Slot* slot = FindSlot(inIdentifier);
+    const CanCoder::Field* fields;
+    size_t fieldCount = CanCoder::GetFields(inIdentifier, fields);
+    if (slot == nullptr || inFieldIndex >= fieldCount) {
+        return false;
+    }
+    Rule* rule = slot->rules;
+    while (rule < slot->rules + slot->ruleCount && rule->fieldIndex != inFieldIndex) {
+        rule++;
+    }
+    if (rule == slot->rules + maximumRuleCount) {
+        return false;
+    }
+    if (rule == slot->rules + slot->ruleCount) {
+        slot->ruleCount++;
+    }
+    rule->load = GetFieldLoader(fields[inFieldIndex].type);
+    rule->offset = fields[inFieldIndex].offset;
+    rule->fieldIndex = (uint8_t)inFieldIndex;
+    rule->deadband = inDeadband;
+    rule->lastValue = 0;
+    // The next message compares against its own values
+    slot->forwarded = false;
+    return true;
+}
+
+bool CanFilter::AddDeadband(CanCoder::Identifier inIdentifier, const char* inFieldName, uint32_t inDeadband) {
+    uint32_t fieldMask = CanCoder::GetFieldMask(inIdentifier, inFieldName);
+    if (fieldMask == 0) {
+        return false;
+    }
+    return AddRule(inIdentifier, std::countr_zero(fieldMask), inDeadband);
+}
+
+bool CanFilter::AddOnChange(CanCoder::Identifier inIdentifier, uint32_t inFieldMask) {
+    Slot* slot = FindSlot(inIdentifier);
+    const CanCoder::Field* fields;
+    size_t fieldCount = CanCoder::GetFields(inIdentifier, fields);
+    if (slot == nullptr || fieldCount == 0) {
+        return false;
+    }
+    uint32_t existingFields = fieldCount >= 32 ? allFields : (1u << fieldCount) - 1;
+    if (inFieldMask == allFields) {
+        inFieldMask = existingFields;
+    }
+    if (inFieldMask == 0 || (inFieldMask & ~existingFields) != 0) {
+        return false;
+    }
+    // Check that the rules fit before adding any, fields that have a rule already reuse it
+    uint32_t newFields = inFieldMask;
+    for (const Rule* rule = slot->rules; rule < slot->rules + slot->ruleCount; rule++) {
+        newFields &= ~(1u << rule->fieldIndex);
+    }
+    if (slot->ruleCount + (size_t)std::popcount(newFields) > maximumRuleCount) {
+        return false;
+    }
+    for (size_t fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++) {
+        if ((inFieldMask & (1u << fieldIndex)) != 0) {
+            AddRule(inIdentifier, fieldIndex, 0);
+        }
+    }
+    return true;
+}
+
+void CanFilter::Clear() {
+    for (Slot& slot : _slots) {
+        slot = {};
+    }
+}
+
+void CanFilter::Reset() {
+    for (Slot& slot : _slots) {
+        slot.forwarded = false;
+    }
+}
+
+bool CanFilter::Accept(const CanCoder& inCoder, uint64_t inTimestamp) {
+    Slot* slot = FindSlot(inCoder._identifier);
+    if (slot == nullptr) {
+        return true;
+    }
+    // Each field is loaded once, for the compare and to remember it when forwarded
+    const uint8_t* coder = (const uint8_t*)&inCoder;
+    int32_t values[maximumRuleCount];
+    for (size_t index = 0; index < slot->ruleCount; index++) {
+        values[index] = slot->rules[index].load(coder + slot->rules[index].offset);
+    }
+    if (slot->forwarded) {
+        bool passed;
+        if (inTimestamp < slot->lastTimestamp) {
+            // Time went back, the interval restarts here
+            passed = slot->minimumInterval == 0;
+            if (!passed) {
+                slot->lastTimestamp = inTimestamp;
+            }
+        }
+        else {
+            passed = inTimestamp - slot->lastTimestamp >= slot->minimumInterval;
+        }
+        if (passed && slot->ruleCount > 0) {
+            passed = false;
+            for (size_t index = 0; index < slot->ruleCount; index++) {
+                int64_t change = (int64_t)values[index] - slot->rules[index].lastValue;
+                if ((uint64_t)(change < 0 ? -change : change) > slot->rules[index].deadband) {
+                    passed = true;
+                    break;
+                }
+            }
+        }
+        if (!passed) {
+            slot->statistics.droppedCount++;
+            return false;
+        }
+    }
+    // Deadbands are relative to the last forwarded values, so slow drifts are forwarded as well
+    for (size_t index = 0; index < slot->ruleCount; index++) {
+        slot->rules[index].lastValue = values[index];
+    }
+    slot->lastTimestamp = inTimestamp;
+    slot->forwarded = true;
+    slot->statistics.forwardedCount++;
+    return true;
+}
+
+CanFilter::Statistics CanFilter::GetStatistics(CanCoder::Identifier inIdentifier) const {
+    size_t messageIndex = CanCoder::GetMessageIndex(inIdentifier);
+    if (messageIndex == CanCoder::messageCount) {
+        return {};
+    }
+    return _slots[messageIndex].statistics;
+}
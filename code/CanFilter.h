@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanFilter
+ *
+ * Filtering and downsampling of decoded messages before they are forwarded
+ *
+ * Most messages on the bus are cyclic and repeat the same values, a telemetry link
+ * only needs the messages that carry news. The filter sits after the decode and decides
+ * per message whether to forward it, based on rules per identifier:
+ * Rate limit    forward at most one message per interval
+ * Deadband      forward when a numeric field moved more than the deadband since the
+ *               last forwarded message, for example the vehicle speed
+ * On change     forward when a field differs from the last forwarded message, for
+ *               example the open and locked statuses of the doors
+ * A message passes when its rate limit allows it and, when it has deadband or on change
+ * rules, one of them triggers. Messages without rules are always forwarded. The first
+ * message of an identifier is always forwarded.
+ *
+ * Rules are compiled when they are added: the offset of the field in CanCoder and a load
+ * function for its type are looked up once, evaluating a message loads each field of its
+ * rules once with that function and compares it. No memory is allocated.
+ *
+ * A timestamp before the last forwarded message of its identifier, for example after a
+ * clock reset, restarts the rate limit interval at that timestamp and the message is dropped.
+ *
+ * For example, forwarding the speed when it moved by more than 2, at most 10 times per second,
+ * and the door statuses when they change:
+ *     CanFilter filter;
+ *     filter.SetRateLimit(CanCoder::Identifier::vehicleSpeed, 100000);
+ *     filter.AddDeadband(CanCoder::Identifier::vehicleSpeed, "speed", 2);
+ *     filter.AddOnChange(CanCoder::Identifier::frontDriverSideDoorStatus, CanFilter::allFields);
+ *     if (coder.Decode(frame.identifier, frame.dataLengthCode, frame.data) && filter.Accept(coder, frame.timestamp)) {
+ *         uplink.Send(frame);
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: fields are loaded through CanCoder::GetFieldValue, AddOnChange adds all rules or none
+ * Version 3: fields are loaded by a function picked per rule, timestamps going back restart the rate limit
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class CanFilter {
+public:
+    /// @brief Field mask selecting all fields of a message
+    static constexpr uint32_t allFields = 0xffffffff;
+    /// @brief Maximum number of deadband and on change rules of a message
+    static constexpr size_t maximumRuleCount = 16;
+
+    /// @brief Counters of a message
+    struct Statistics {
+        uint64_t forwardedCount;
+        uint64_t droppedCount;
+    };
+
+    /// @brief Limit the rate at which a message is forwarded
+    /// @param inIdentifier CAN message identifier
+    /// @param inMinimumInterval Minimum time between forwarded messages, in the unit of the timestamps, 0 for no limit
+    /// @return true on success, false for unsupported identifiers
+    bool SetRateLimit(CanCoder::Identifier inIdentifier, uint64_t inMinimumInterval);
+    /// @brief Forward a message when a field moved more than a deadband since the last forwarded message
+    ///
+    /// A rule for a field replaces an earlier rule for the same field.
+    /// @param inIdentifier CAN message identifier
+    /// @param inFieldName Name of the field in its message struct, for example "speed"
+    /// @param inDeadband Largest change that is not forwarded
+    /// @return true on success, false when the field does not exist or the message has maximumRuleCount rules
+    bool AddDeadband(CanCoder::Identifier inIdentifier, const char* inFieldName, uint32_t inDeadband);
+    /// @brief Forward a message when one of the fields changed since the last forwarded message
+    ///
+    /// Either all fields get a rule or, on failure, none.
+    /// @param inIdentifier CAN message identifier
+    /// @param inFieldMask The fields, see CanCoder::GetFieldMask, or allFields
+    /// @return true on success, false when the mask selects no fields or fields the message does not have,
+    /// or when the rules do not fit in maximumRuleCount
+    bool AddOnChange(CanCoder::Identifier inIdentifier, uint32_t inFieldMask);
+    /// @brief Remove all rules of all messages and reset the counters
+    void Clear();
+    /// @brief Forward the next message of each identifier regardless of the rules
+    void Reset();
+
+    /// @brief Decide whether to forward the message last decoded by a coder
+    /// @param inCoder The coder, its _identifier selects the rules
+    /// @param inTimestamp Timestamp of the message
+    /// @return true when the message is forwarded, false when it is dropped
+    bool Accept(const CanCoder& inCoder, uint64_t inTimestamp);
+    /// @brief Get the counters of a message
+    Statistics GetStatistics(CanCoder::Identifier inIdentifier) const;
+
+private:
+    struct Rule {
+        // Loads the field for its type, value points to the field in the CanCoder
+        int32_t (*load)(const uint8_t* value);
+        // Offset of the field within CanCoder
+        uint16_t offset;
+        uint8_t fieldIndex;
+        uint32_t deadband;
+        int32_t lastValue;
+    };
+    struct Slot {
+        uint64_t minimumInterval;
+        uint64_t lastTimestamp;
+        bool forwarded;
+        uint8_t ruleCount;
+        Rule rules[maximumRuleCount];
+        Statistics statistics;
+    };
+
+    Slot* FindSlot(CanCoder::Identifier inIdentifier);
+    bool AddRule(CanCoder::Identifier inIdentifier, size_t inFieldIndex, uint32_t inDeadband);
+
+    // By CanCoder::GetMessageIndex
+    Slot _slots[CanCoder::messageCount] = {};
+};
@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanFrameQueue
+ *
+ * Lock free queue handing frames from the thread reading the bus to the decoding thread
+ *
+ * The queue is a bounded ring of CanCoder::Frame for one producer and one consumer.
+ * Neither side ever blocks or takes a mutex. The positions of the producer and the
+ * consumer are on their own cache lines, and each side keeps a cached copy of the
+ * position of the other side, so the cache line of the other side is only read when
+ * the ring appears full or empty.
+ * When the ring is full a pushed frame is dropped and counted, the producer never waits.
+ *
+ * For example:
+ *     CanFrameQueue<1024> queue;
+ *
+ *     // Reading thread
+ *     queue.Push(frame);
+ *
+ *     // Decoding thread
+ *     CanCoder::Frame frames[64];
+ *     size_t frameCount = queue.PopBatch(frames, 64);
+ *     coder.DecodeBatch(frames, frameCount, nullptr);
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+
+/// @brief Single producer, single consumer queue of frames
+/// @tparam Capacity Number of frames the queue can hold, must be a power of 2
+template <size_t Capacity>
+class CanFrameQueue {
+public:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "The capacity must be a power of 2");
+
+    CanFrameQueue() = default;
+    CanFrameQueue(const CanFrameQueue&) = delete;
+    CanFrameQueue& operator=(const CanFrameQueue&) = delete;
+
+    /// @brief Add a frame, only to be called by the producer
+    /// @param inFrame The frame
+    /// @return true on success, false when the queue is full and the frame was dropped
+    bool Push(const CanCoder::Frame& inFrame) {
+        return PushBatch(&inFrame, 1) == 1;
+    }
+    /// @brief Add multiple frames, only to be called by the producer
+    /// @param inFrames The frames
+    /// @param inFrameCount Number of frames
+    /// @return The number of frames added, the remaining frames were dropped
+    size_t PushBatch(const CanCoder::Frame* inFrames, size_t inFrameCount) {
+        size_t writePosition = _producer.position.load(std::memory_order_relaxed);
+        if (writePosition - _producer.otherPosition + inFrameCount > Capacity) {
+            _producer.otherPosition = _consumer.position.load(std::memory_order_acquire);
+        }
+        size_t frameCount = std::min(inFrameCount, Capacity - (writePosition - _producer.otherPosition));
+        for (size_t index = 0; index < frameCount; index++) {
+            _frames[(writePosition + index) & mask] = inFrames[index];
+        }
+        _producer.position.store(writePosition + frameCount, std::memory_order_release);
+        if (frameCount < inFrameCount) {
+            _producer.droppedCount.fetch_add(inFrameCount - frameCount, std::memory_order_relaxed);
+        }
+        return frameCount;
+    }
+
+    /// @brief Take a frame, only to be called by the consumer
+    /// @param outFrame Receives the frame
+    /// @return true on success, false when the queue is empty
+    bool Pop(CanCoder::Frame& outFrame) {
+        return PopBatch(&outFrame, 1) == 1;
+    }
+    /// @brief Take multiple frames, only to be called by the consumer
+    /// @param outFrames Receives the frames, must be able to hold inMaximumFrameCount frames
+    /// @param inMaximumFrameCount Maximum number of frames
+    /// @return The number of frames taken
+    size_t PopBatch(CanCoder::Frame* outFrames, size_t inMaximumFrameCount) {
+        size_t readPosition = _consumer.position.load(std::memory_order_relaxed);
+        if (_consumer.otherPosition - readPosition < inMaximumFrameCount) {
+            _consumer.otherPosition = _producer.position.load(std::memory_order_acquire);
+        }
+        size_t frameCount = std::min(inMaximumFrameCount, _consumer.otherPosition - readPosition);
+        for (size_t index = 0; index < frameCount; index++) {
+            outFrames[index] = _frames[(readPosition + index) & mask];
+        }
+        _consumer.position.store(readPosition + frameCount, std::memory_order_release);
+        return frameCount;
+    }
+
+    /// @brief Get the number of frames in the queue, exact only when called by the producer or the consumer
+    size_t GetSize() const {
+        return _producer.position.load(std::memory_order_acquire) - _consumer.position.load(std::memory_order_acquire);
+    }
+    /// @brief Get the number of frames dropped because the queue was full
+    uint64_t GetDroppedCount() const {
+        return _producer.droppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t mask = Capacity - 1;
+
+    // Positions only increase, the index in the ring is the position modulo Capacity
+    struct alignas(64) Side {
+        std::atomic<size_t> position{ 0 };
+        // Last seen position of the other side, only accessed by this side
+        size_t otherPosition = 0;
+        // Only used by the producer
+        std::atomic<uint64_t> droppedCount{ 0 };
+    };
+
+    Side _producer;
+    Side _consumer;
+    alignas(64) CanCoder::Frame _frames[Capacity];
+};
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanHistory
+ *
+ * History of decoded values with time window queries
+ *
+ * CanCoder only holds the latest decoded value of each message. A CanHistory keeps the
+ * last Capacity values of one field with their timestamps in a preallocated ring buffer,
+ * the oldest value being overwritten when it is full. No memory is allocated after
+ * construction.
+ * Values must be added in time order. Time windows are then found with a binary search,
+ * in O(log n), after which the statistics of a window are computed over its values only.
+ * Timestamps are in microseconds, like CanCoder::Frame::timestamp.
+ *
+ * For example, the vehicle speed over the last 2 seconds:
+ *     CanHistory<int, 256> speedHistory;
+ *
+ *     // After decoding a vehicleSpeed message
+ *     speedHistory.Add(frame.timestamp, coder._vehicleSpeed.speed);
+ *
+ *     CanHistory<int, 256>::Statistics statistics;
+ *     if (speedHistory.GetStatistics(now - 2000000, now, statistics)) {
+ *         double meanSpeed = statistics.mean;
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: the rate is that of the values in the window, also for windows with an end
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Ring buffer of timestamped values
+/// @tparam Value Type of the values, must be arithmetic for GetStatistics
+/// @tparam Capacity Maximum number of values
+template <typename Value, size_t Capacity>
+class CanHistory {
+public:
+    static_assert(Capacity > 0, "The capacity must be at least 1");
+
+    struct Entry {
+        uint64_t timestamp;
+        Value value;
+    };
+    /// @brief Statistics of the values in a time window
+    struct Statistics {
+        size_t count;
+        Value minimum;
+        Value maximum;
+        double mean;
+        // Values per second between the first and the last value in the window,
+        // (count - 1) / (last.timestamp - first.timestamp), 0 when they have the same timestamp
+        // It does not depend on the bounds of the window, so windows with and without an end
+        // (UINT64_MAX) holding the same values have the same rate
+        double rate;
+        // The first and the last entry in the window
+        Entry first;
+        Entry last;
+    };
+
+    /// @brief Add a value, overwriting the oldest value when the history is full
+    /// @param inTimestamp Timestamp of the value, not earlier than the timestamp of the previous value
+    /// @param inValue The value
+    void Add(uint64_t inTimestamp, const Value& inValue) {
+        _entries[(_start + _size) % Capacity] = { inTimestamp, inValue };
+        if (_size < Capacity) {
+            _size++;
+        }
+        else {
+            _start = (_start + 1) % Capacity;
+        }
+    }
+    /// @brief Remove all values
+    void Clear() {
+        _start = 0;
+        _size = 0;
+    }
+
+    /// @brief Get the number of values
+    size_t GetSize() const { return _size; }
+    /// @brief Get a value, 0 being the oldest
+    /// @param inPosition Position of the value, must be less than GetSize()
+    const Entry& operator[](size_t inPosition) const { return _entries[(_start + inPosition) % Capacity]; }
+    /// @brief Get the latest value, only when GetSize() is not 0
+    const Entry& GetLatest() const { return (*this)[_size - 1]; }
+
+    /// @brief Find the values within a time window
+    /// @param inBeginTimestamp First timestamp of the window
+    /// @param inEndTimestamp Last timestamp of the window
+    /// @param outFirst Position of the first value in the window
+    /// @return The number of values in the window
+    size_t FindWindow(uint64_t inBeginTimestamp, uint64_t inEndTimestamp, size_t& outFirst) const {
+        outFirst = LowerBound(inBeginTimestamp);
+        if (inEndTimestamp < inBeginTimestamp) {
+            return 0;
+        }
+        size_t end = inEndTimestamp == UINT64_MAX ? _size : LowerBound(inEndTimestamp + 1);
+        return end - outFirst;
+    }
+
+    /// @brief Call a function for each value within a time window, oldest first
+    /// @param inBeginTimestamp First timestamp of the window
+    /// @param inEndTimestamp Last timestamp of the window
+    /// @param inCallback Function called as inCallback(const Entry& entry)
+    /// @return The number of values in the window
+    template <typename Callback>
+    size_t ForEach(uint64_t inBeginTimestamp, uint64_t inEndTimestamp, Callback&& inCallback) const {
+        size_t first;
+        size_t count = FindWindow(inBeginTimestamp, inEndTimestamp, first);
+        for (size_t position = first; position < first + count; position++) {
+            inCallback((*this)[position]);
+        }
+        return count;
+    }
+
+    /// @brief Get the statistics of the values within a time window
+    /// @param inBeginTimestamp First timestamp of the window
+    /// @param inEndTimestamp Last timestamp of the window
+    /// @param outStatistics The statistics, only valid on success
+    /// @return true on success, false when there are no values in the window
+    bool GetStatistics(uint64_t inBeginTimestamp, uint64_t inEndTimestamp, Statistics& outStatistics) const {
+        size_t first;
+        size_t count = FindWindow(inBeginTimestamp, inEndTimestamp, first);
+        if (count == 0) {
+            return false;
+        }
+        outStatistics.count = count;
+        outStatistics.first = (*this)[first];
+        outStatistics.last = (*this)[first + count - 1];
+        outStatistics.minimum = outStatistics.first.value;
+        outStatistics.maximum = outStatistics.first.value;
+        double sum = 0;
+        for (size_t position = first; position < first + count; position++) {
+            const Value& value = (*this)[position].value;
+            if (value < outStatistics.minimum) {
+                outStatistics.minimum = value;
+            }
+            if (outStatistics.maximum < value) {
+                outStatistics.maximum = value;
+            }
+            sum += (double)value;
+        }
+        outStatistics.mean = sum / (double)count;
+        uint64_t duration = outStatistics.last.timestamp - outStatistics.first.timestamp;
+        outStatistics.rate = duration == 0 ? 0 : (double)(count - 1) * 1000000 / (double)duration;
+        return true;
+    }
+
+private:
+    // Position of the first value with a timestamp of at least inTimestamp
+    size_t LowerBound(uint64_t inTimestamp) const {
+        size_t begin = 0;
+        size_t end = _size;
+        while (begin < end) {
+            size_t middle = begin + (end - begin) / 2;
+            if ((*this)[middle].timestamp < inTimestamp) {
+                begin = middle + 1;
+            }
+            else {
+                end = middle;
+            }
+        }
+        return begin;
+    }
+
+    Entry _entries[Capacity] = {};
+    size_t _start = 0;
+    size_t _size = 0;
+};
@@ -0,0 +1,262 @@
+#include "CanLogReplay.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char* SkipSpaces(const char* position, const char* end) {
+        while (position < end && (*position == ' ' || *position == '\t')) {
+            position++;
+        }
+        return position;
+    }
+
+    const char* SkipToken(const char* position, const char* end) {
+        while (position < end && *position != ' ' && *position != '\t' && *position != '\r') {
+            position++;
+        }
+        return position;
+    }
+
+    int HexDigit(char character) {
+        if (character >= '0' && character <= '9') {
+            return character - '0';
+        }
+        if (character >= 'A' && character <= 'F') {
+            return character - 'A' + 10;
+        }
+        if (character >= 'a' && character <= 'f') {
+            return character - 'a' + 10;
+        }
+        return -1;
+    }
+
+    // Parse a hexadecimal or decimal number, returns the number of digits
+    int ParseNumber(const char*& position, const char* end, uint32_t base, uint32_t& outValue) {
+        int digitCount = 0;
+        outValue = 0;
+        while (position < end) {
+            int digit = HexDigit(*position);
+            if (digit < 0 || (uint32_t)digit >= base) {
+                break;
+            }
+            outValue = outValue * base + digit;
+            position++;
+            digitCount++;
+        }
+        return digitCount;
+    }
+
+    // Parse a time in seconds like "1436509052.249713" to microseconds
+    bool ParseTimestamp(const char*& position, const char* end, uint64_t& outTimestamp) {
+        uint64_t seconds = 0;
+        int digitCount = 0;
+        while (position < end && *position >= '0' && *position <= '9') {
+            seconds = seconds * 10 + (*position++ - '0');
+            digitCount++;
+        }
+        if (digitCount == 0) {
+            return false;
+        }
+        uint64_t microseconds = 0;
+        int fractionDigitCount = 0;
+        if (position < end && *position == '.') {
+            position++;
+            while (position < end && *position >= '0' && *position <= '9') {
+                // Digits beyond microseconds are ignored
+                if (fractionDigitCount < 6) {
+                    microseconds = microseconds * 10 + (*position - '0');
+                    fractionDigitCount++;
+                }
+                position++;
+            }
+        }
+        for (; fractionDigitCount < 6; fractionDigitCount++) {
+            microseconds *= 10;
+        }
+        outTimestamp = seconds * 1000000 + microseconds;
+        return true;
+    }
+}
+
+CanLogReplay::~CanLogReplay() {
+    Close();
+}
+
+bool CanLogReplay::Open(const char* inPath) {
+    Close();
+    _fileDescriptor = open(inPath, O_RDONLY | O_CLOEXEC);
+    if (_fileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(_fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+        Close();
+        return false;
+    }
+    void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    madvise(data, fileStatus.st_size, MADV_SEQUENTIAL);
+    _data = (const char*)data;
+    _size = fileStatus.st_size;
+
+    // Detect the format from the first lines
+    // candump lines start with "(timestamp)", ASC logs start with a header like "date ..." and "base hex ..."
+    const char* line = _data;
+    const char* end = _data + _size;
+    for (int lineCount = 0; lineCount < 20 && line < end && _format == Format::unknown; lineCount++) {
+        const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
+        const char* position = SkipSpaces(line, lineEnd);
+        if (position < lineEnd && *position == '(') {
+            _format = Format::candump;
+        }
+        else if (lineEnd - position >= 4 && (memcmp(position, "date", 4) == 0 || memcmp(position, "base", 4) == 0)) {
+            _format = Format::asc;
+        }
+        line = lineEnd + 1;
+    }
+    if (_format == Format::asc) {
+        // The base line looks like "base hex  timestamps absolute"
+        const char* base = (const char*)memmem(_data, std::min(_size, (size_t)4096), "base dec", 8);
+        _ascHexadecimal = base == nullptr;
+    }
+    if (_format == Format::unknown) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CanLogReplay::Close() {
+    if (_data != nullptr) {
+        munmap((void*)_data, _size);
+        _data = nullptr;
+        _size = 0;
+    }
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+    _format = Format::unknown;
+    _ascHexadecimal = true;
+}
+
+std::vector<CanLogReplay::Chunk> CanLogReplay::Split(unsigned inChunkCount) const {
+    std::vector<Chunk> chunks;
+    const char* end = _data + _size;
+    const char* chunkBegin = _data;
+    for (unsigned chunk = 1; chunk <= inChunkCount && chunkBegin < end; chunk++) {
+        const char* chunkEnd = chunk == inChunkCount ? end : _data + _size / inChunkCount * chunk;
+        if (chunkEnd < chunkBegin) {
+            chunkEnd = chunkBegin;
+        }
+        // Move the end of the chunk to the start of the next line
+        const char* lineEnd = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+        chunkEnd = lineEnd == nullptr ? end : lineEnd + 1;
+        chunks.push_back({ chunkBegin, chunkEnd });
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+bool CanLogReplay::ParseLine(const char* inLine, const char* inLineEnd, CanCoder::Frame& outFrame) const {
+    if (_format == Format::candump) {
+        return ParseCandumpLine(inLine, inLineEnd, outFrame);
+    }
+    return ParseAscLine(inLine, inLineEnd, outFrame);
+}
+
+bool CanLogReplay::ParseCandumpLine(const char* inLine, const char* inLineEnd, CanCoder::Frame& outFrame) const {
+    // (1436509052.249713) can0 1B4#2A366C2A
+    const char* position = SkipSpaces(inLine, inLineEnd);
+    if (position >= inLineEnd || *position++ != '(') {
+        return false;
+    }
+    if (!ParseTimestamp(position, inLineEnd, outFrame.timestamp) || position >= inLineEnd || *position++ != ')') {
+        return false;
+    }
+    // Interface name
+    position = SkipToken(SkipSpaces(position, inLineEnd), inLineEnd);
+    position = SkipSpaces(position, inLineEnd);
+    uint32_t identifier;
+    int digitCount = ParseNumber(position, inLineEnd, 16, identifier);
+    if (digitCount == 0 || position >= inLineEnd || *position++ != '#') {
+        return false;
+    }
+    // Identifiers with 8 digits are extended identifiers
+    outFrame.identifier = digitCount == 8 ? (identifier | CanCoder::extendedIdentifierFlag) : identifier;
+    // Remote frames are "#R", CAN FD frames are "##"
+    if (position < inLineEnd && (*position == 'R' || *position == '#')) {
+        return false;
+    }
+    outFrame.dataLengthCode = 0;
+    while (position + 1 < inLineEnd && outFrame.dataLengthCode < 8) {
+        int highNibble = HexDigit(position[0]);
+        int lowNibble = HexDigit(position[1]);
+        if (highNibble < 0 || lowNibble < 0) {
+            break;
+        }
+        outFrame.data[outFrame.dataLengthCode++] = (uint8_t)((highNibble << 4) | lowNibble);
+        position += 2;
+    }
+    // A frame with more than 8 bytes of data is not a CAN frame, it is skipped rather than truncated
+    if (position + 1 < inLineEnd && HexDigit(position[0]) >= 0 && HexDigit(position[1]) >= 0) {
+        return false;
+    }
+    return true;
+}
+
+bool CanLogReplay::ParseAscLine(const char* inLine, const char* inLineEnd, CanCoder::Frame& outFrame) const {
+    //    0.009943 1  1B4             Rx   d 8 11 22 33 44 55 66 77 88
+    const char* position = SkipSpaces(inLine, inLineEnd);
+    if (!ParseTimestamp(position, inLineEnd, outFrame.timestamp)) {
+        return false;
+    }
+    // Channel, this also rejects other lines starting with a time like "CANFD" and "ErrorFrame" lines
+    position = SkipSpaces(position, inLineEnd);
+    uint32_t channel;
+    if (ParseNumber(position, inLineEnd, 10, channel) == 0) {
+        return false;
+    }
+    position = SkipSpaces(position, inLineEnd);
+    uint32_t base = _ascHexadecimal ? 16 : 10;
+    uint32_t identifier;
+    if (ParseNumber(position, inLineEnd, base, identifier) == 0) {
+        return false;
+    }
+    // Extended identifiers end with 'x'
+    outFrame.identifier = identifier;
+    if (position < inLineEnd && *position == 'x') {
+        outFrame.identifier |= CanCoder::extendedIdentifierFlag;
+        position++;
+    }
+    // Direction
+    position = SkipToken(SkipSpaces(position, inLineEnd), inLineEnd);
+    position = SkipSpaces(position, inLineEnd);
+    // Data frames are marked with 'd', remote frames with 'r'
+    if (position >= inLineEnd || *position++ != 'd') {
+        return false;
+    }
+    position = SkipSpaces(position, inLineEnd);
+    uint32_t dataLengthCode;
+    if (ParseNumber(position, inLineEnd, 16, dataLengthCode) == 0 || dataLengthCode > 8) {
+        return false;
+    }
+    for (uint32_t index = 0; index < dataLengthCode; index++) {
+        position = SkipSpaces(position, inLineEnd);
+        uint32_t value;
+        if (ParseNumber(position, inLineEnd, base, value) == 0) {
+            return false;
+        }
+        outFrame.data[index] = (uint8_t)value;
+    }
+    outFrame.dataLengthCode = (uint8_t)dataLengthCode;
+    return true;
+}
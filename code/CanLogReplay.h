@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanLogReplay
+ *
+ * Replaying of CAN bus logs into CanCoder
+ *
+ * Supported are the log format of candump (candump -l) and Vector ASC logs.
+ * The log file is memory mapped and parsed in place, no data is copied before it
+ * ends up in a CanCoder::Frame. Frame timestamps are in microseconds.
+ * Extended identifiers are marked by bit 31 (CanCoder::extendedIdentifierFlag), so they can never
+ * be mistaken for a standard identifier. Remote frames, error frames, CAN FD frames
+ * and frames with more than 8 bytes of data are skipped.
+ *
+ * Large logs can be decoded on all cores with ReplayParallel. The log is split into
+ * chunks at line boundaries and each chunk is decoded with its own CanCoder instance.
+ * Note that a CanCoder for a chunk starts without the state of the preceding chunks.
+ * The results of the chunks are merged in time order.
+ *
+ * For example, collecting the vehicle speed from a log:
+ *     struct Speed {
+ *         uint64_t timestamp;
+ *         int speed;
+ *     };
+ *     CanLogReplay replay;
+ *     replay.Open("drive.log");
+ *     std::vector<Speed> speeds = replay.ReplayParallel<Speed>(
+ *         [](CanCoder& coder, const CanCoder::Frame& frame, Speed& result) {
+ *             if (!coder.Decode(frame.identifier, frame.dataLengthCode, (uint8_t*)frame.data) ||
+ *                 coder._identifier != CanCoder::Identifier::vehicleSpeed) {
+ *                 return false;
+ *             }
+ *             result = { frame.timestamp, coder._vehicleSpeed.speed };
+ *             return true;
+ *         });
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class CanLogReplay {
+public:
+    enum class Format {
+        unknown,
+        candump,
+        asc
+    };
+
+    CanLogReplay() = default;
+    CanLogReplay(const CanLogReplay&) = delete;
+    CanLogReplay& operator=(const CanLogReplay&) = delete;
+    ~CanLogReplay();
+
+    /// @brief Open and memory map a log file, detecting its format
+    /// @param inPath Path of the log file
+    /// @return true on success, false when the file can not be mapped or the format is unknown
+    bool Open(const char* inPath);
+    /// @brief Close the log file
+    void Close();
+    /// @brief Get the format of the opened log file
+    Format GetFormat() const { return _format; }
+
+    /// @brief Call a function for each frame in the log
+    /// @param inCallback Function called as inCallback(const CanCoder::Frame& frame)
+    /// @return The number of frames
+    template <typename Callback>
+    size_t ForEachFrame(Callback&& inCallback) const {
+        return Parse(_data, _data + _size, inCallback);
+    }
+
+    /// @brief Decode each frame in the log
+    /// @param inCoder The coder to decode with
+    /// @param inCallback Function called after each decode as inCallback(const CanCoder::Frame& frame, bool decoded)
+    /// @return The number of frames
+    template <typename Callback>
+    size_t Replay(CanCoder& inCoder, Callback&& inCallback) const {
+        return ForEachFrame([&](const CanCoder::Frame& frame) {
+            bool decoded = inCoder.Decode(frame.identifier, frame.dataLengthCode, (uint8_t*)frame.data);
+            inCallback(frame, decoded);
+        });
+    }
+
+    /// @brief Decode the log on multiple threads, each thread decoding a chunk with its own CanCoder
+    /// @tparam Result Type of the results, must have a uint64_t timestamp member
+    /// @param inDecoder Function called for each frame as bool inDecoder(CanCoder& coder, const CanCoder::Frame& frame, Result& outResult)
+    /// It must return true when it produced a result. It is called concurrently for different chunks
+    /// @param inThreadCount Number of threads, 0 for one thread per core
+    /// @return The results of all chunks, merged in time order
+    template <typename Result, typename Decoder>
+    std::vector<Result> ReplayParallel(Decoder&& inDecoder, unsigned inThreadCount = 0) const {
+        if (inThreadCount == 0) {
+            inThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::vector<Chunk> chunks = Split(inThreadCount);
+        std::vector<std::vector<Result>> chunkResults(chunks.size());
+        std::vector<std::thread> threads;
+        for (size_t index = 0; index < chunks.size(); index++) {
+            threads.emplace_back([&, index]() {
+                CanCoder coder;
+                Result result;
+                Parse(chunks[index].begin, chunks[index].end, [&](const CanCoder::Frame& frame) {
+                    if (inDecoder(coder, frame, result)) {
+                        chunkResults[index].push_back(result);
+                    }
+                });
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return Merge(chunkResults);
+    }
+
+private:
+    struct Chunk {
+        const char* begin;
+        const char* end;
+    };
+
+    template <typename Callback>
+    size_t Parse(const char* inBegin, const char* inEnd, Callback&& inCallback) const {
+        size_t frameCount = 0;
+        CanCoder::Frame frame;
+        const char* line = inBegin;
+        while (line < inEnd) {
+            const char* lineEnd = (const char*)memchr(line, '\n', inEnd - line);
+            if (lineEnd == nullptr) {
+                lineEnd = inEnd;
+            }
+            if (ParseLine(line, lineEnd, frame)) {
+                inCallback(frame);
+                frameCount++;
+            }
+            line = lineEnd + 1;
+        }
+        return frameCount;
+    }
+
+    // Merge the results of the chunks in time order
+    // Results with the same timestamp keep the order of the chunks
+    template <typename Result>
+    static std::vector<Result> Merge(std::vector<std::vector<Result>>& inChunkResults) {
+        size_t resultCount = 0;
+        for (const std::vector<Result>& results : inChunkResults) {
+            resultCount += results.size();
+        }
+        std::vector<Result> mergedResults;
+        mergedResults.reserve(resultCount);
+        if (inChunkResults.size() == 1) {
+            mergedResults.swap(inChunkResults[0]);
+            return mergedResults;
+        }
+        // Cursors are chunk and position within the chunk
+        using Cursor = std::pair<size_t, size_t>;
+        auto later = [&](const Cursor& cursor1, const Cursor& cursor2) {
+            uint64_t timestamp1 = inChunkResults[cursor1.first][cursor1.second].timestamp;
+            uint64_t timestamp2 = inChunkResults[cursor2.first][cursor2.second].timestamp;
+            return timestamp1 != timestamp2 ? timestamp1 > timestamp2 : cursor1.first > cursor2.first;
+        };
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> cursors(later);
+        for (size_t chunk = 0; chunk < inChunkResults.size(); chunk++) {
+            if (!inChunkResults[chunk].empty()) {
+                cursors.push({ chunk, 0 });
+            }
+        }
+        while (!cursors.empty()) {
+            Cursor cursor = cursors.top();
+            cursors.pop();
+            mergedResults.push_back(inChunkResults[cursor.first][cursor.second]);
+            if (++cursor.second < inChunkResults[cursor.first].size()) {
+                cursors.push(cursor);
+            }
+        }
+        return mergedResults;
+    }
+
+    std::vector<Chunk> Split(unsigned inChunkCount) const;
+    bool ParseLine(const char* inLine, const char* inLineEnd, CanCoder::Frame& outFrame) const;
+    bool ParseCandumpLine(const char* inLine, const char* inLineEnd, CanCoder::Frame& outFrame) const;
+    bool ParseAscLine(const char* inLine, const char* inLineEnd, CanCoder::Frame& outFrame) const;
+
+    int _fileDescriptor = -1;
+    const char* _data = nullptr;
+    size_t _size = 0;
+    Format _format = Format::unknown;
+    // ASC logs can have identifiers and data in decimal ("base dec")
+    bool _ascHexadecimal = true;
+};
@@ -0,0 +1,343 @@
+#include "CanPackedState.h"
+#include <string.h>
+
+namespace {
+    enum class Kind : uint8_t {
+        // bool stored as a bit of Values::flags
+        flag,
+        // char stored as char
+        character,
+        // int stored as uint8_t
+        byte,
+        // int stored as uint16_t
+        shortFromInteger,
+        // unsigned short stored as uint16_t
+        unsignedShort,
+        // Additional data copied as is
+        additionalData
+    };
+
+    // Where a CanCoder member is stored in the packed state
+    struct PackedField {
+        uint16_t coderOffset;
+        Kind kind;
+        uint8_t size;
+        // Flag for flags, offset within Values or AdditionalData otherwise
+        uint16_t packedOffset;
+    };
+
+#define CANPACKED_FLAG(member, field, flagName) \
+    { (uint16_t)offsetof(CanCoder, member.field), Kind::flag, 1, (uint16_t)CanPackedState::Flag::flagName }
+#define CANPACKED_VALUE(member, field, kindName, value) \
+    { (uint16_t)offsetof(CanCoder, member.field), Kind::kindName, sizeof(CanPackedState::Values::value), (uint16_t)offsetof(CanPackedState::Values, value) }
+#define CANPACKED_ADDITIONAL_DATA(member, packedMember) \
+    { (uint16_t)offsetof(CanCoder, member.additionalData), Kind::additionalData, sizeof(CanCoder::member.additionalData), (uint16_t)offsetof(CanPackedState::AdditionalData, packedMember) }
+
+    constexpr PackedField frontPassengerSideDoorStatusFields[] = {
+        CANPACKED_FLAG(_frontPassengerSideDoorStatus, open, frontPassengerSideDoorOpen),
+        CANPACKED_FLAG(_frontPassengerSideDoorStatus, locked, frontPassengerSideDoorLocked)
+    };
+
+    constexpr PackedField rearPassengerSideDoorStatusFields[] = {
+        CANPACKED_FLAG(_rearPassengerSideDoorStatus, open, rearPassengerSideDoorOpen),
+        CANPACKED_FLAG(_rearPassengerSideDoorStatus, locked, rearPassengerSideDoorLocked)
+    };
+
+    constexpr PackedField frontDriverSideDoorStatusFields[] = {
+        CANPACKED_FLAG(_frontDriverSideDoorStatus, open, frontDriverSideDoorOpen),
+        CANPACKED_FLAG(_frontDriverSideDoorStatus, locked, frontDriverSideDoorLocked)
+    };
+
+    constexpr PackedField rearDriverSideDoorStatusFields[] = {
+        CANPACKED_FLAG(_rearDriverSideDoorStatus, open, rearDriverSideDoorOpen),
+        CANPACKED_FLAG(_rearDriverSideDoorStatus, locked, rearDriverSideDoorLocked)
+    };
+
+    constexpr PackedField mirrorFoldStatusFields[] = {
+        CANPACKED_FLAG(_mirrorFoldStatus, folded, mirrorsFolded)
+    };
+
+    constexpr PackedField ignitionAndKeyLocationFields[] = {
+        CANPACKED_FLAG(_ignitionAndKeyLocation, keyIsOutside, keyIsOutside)
+    };
+
+    constexpr PackedField vehicleSpeedFields[] = {
+        CANPACKED_VALUE(_vehicleSpeed, speed, shortFromInteger, speed)
+    };
+
+    constexpr PackedField iDriveControllerFields[] = {
+        CANPACKED_VALUE(_iDriveController, dialValue, unsignedShort, dialValue),
+        CANPACKED_FLAG(_iDriveController, homeButton, homeButton),
+        CANPACKED_FLAG(_iDriveController, menuButton, menuButton),
+        CANPACKED_FLAG(_iDriveController, stickUp, stickUp),
+        CANPACKED_FLAG(_iDriveController, stickRight, stickRight),
+        CANPACKED_FLAG(_iDriveController, stickDown, stickDown),
+        CANPACKED_FLAG(_iDriveController, stickLeft, stickLeft),
+        CANPACKED_FLAG(_iDriveController, stickPush, stickPush),
+        CANPACKED_ADDITIONAL_DATA(_iDriveController, iDriveController)
+    };
+
+    constexpr PackedField gearShifterPositionFields[] = {
+        CANPACKED_VALUE(_gearShifterPosition, position, character, gearPosition),
+        CANPACKED_ADDITIONAL_DATA(_gearShifterPosition, gearShifterPosition)
+    };
+
+    constexpr PackedField remoteControlAndDoorHandleInputFields[] = {
+        CANPACKED_FLAG(_remoteControlAndDoorHandleInput, remoteControlUnlockButton, remoteControlUnlockButton),
+        CANPACKED_FLAG(_remoteControlAndDoorHandleInput, remoteControlLockButton, remoteControlLockButton),
+        CANPACKED_FLAG(_remoteControlAndDoorHandleInput, doorHandleUnlockButton, doorHandleUnlockButton),
+        CANPACKED_FLAG(_remoteControlAndDoorHandleInput, doorHandleLockButton, doorHandleLockButton)
+    };
+
+    constexpr PackedField windowRoofAndMirrorControlFields[] = {
+        CANPACKED_FLAG(_windowRoofAndMirrorControl, closeWindowsAndRoof, closeWindowsAndRoof),
+        CANPACKED_FLAG(_windowRoofAndMirrorControl, foldMirrors, foldMirrors),
+        CANPACKED_ADDITIONAL_DATA(_windowRoofAndMirrorControl, windowRoofAndMirrorControl)
+    };
+
+    constexpr PackedField doorLockControlFields[] = {
+        CANPACKED_FLAG(_doorLockControl, lockDoors, lockDoors),
+        CANPACKED_ADDITIONAL_DATA(_doorLockControl, doorLockControl)
+    };
+
+    constexpr PackedField dateTimeFields[] = {
+        CANPACKED_VALUE(_dateTime, year, shortFromInteger, year),
+        CANPACKED_VALUE(_dateTime, month, byte, month),
+        CANPACKED_VALUE(_dateTime, day, byte, day),
+        CANPACKED_VALUE(_dateTime, hour, byte, hour),
+        CANPACKED_VALUE(_dateTime, minute, byte, minute),
+        CANPACKED_VALUE(_dateTime, second, byte, second),
+        CANPACKED_ADDITIONAL_DATA(_dateTime, dateTime)
+    };
+
+    constexpr PackedField passengerSideFrontSeatSeatbeltAndSeatOccupancyStatusFields[] = {
+        CANPACKED_FLAG(_passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, seatbeltFastened, seatbeltFastened),
+        CANPACKED_FLAG(_passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, occupied, occupied)
+    };
+
+    constexpr PackedField doorOpenStatusesFields[] = {
+        CANPACKED_FLAG(_doorOpenStatuses, frontDriverSideDoorIsOpen, frontDriverSideDoorIsOpen),
+        CANPACKED_FLAG(_doorOpenStatuses, frontPassengerSideDoorIsOpen, frontPassengerSideDoorIsOpen),
+        CANPACKED_FLAG(_doorOpenStatuses, rearDriverSideDoorIsOpen, rearDriverSideDoorIsOpen),
+        CANPACKED_FLAG(_doorOpenStatuses, rearPassengerSideDoorIsOpen, rearPassengerSideDoorIsOpen),
+        CANPACKED_FLAG(_doorOpenStatuses, bootIsOpen, bootIsOpen),
+        CANPACKED_FLAG(_doorOpenStatuses, bonnetIsOpen, bonnetIsOpen)
+    };
+
+    constexpr PackedField handbrakeStatusFields[] = {
+        CANPACKED_FLAG(_handbrakeStatus, handbrakeIsActive, handbrakeIsActive)
+    };
+
+#undef CANPACKED_FLAG
+#undef CANPACKED_VALUE
+#undef CANPACKED_ADDITIONAL_DATA
+
+    struct PackedMessage {
+        CanCoder::Identifier identifier;
+        const PackedField* fields;
+        uint8_t count;
+    };
+
+#define CANPACKED_MESSAGE(name, identifier) { CanCoder::Identifier::identifier, name##Fields, sizeof(name##Fields) / sizeof(PackedField) }
+
+    // The messages sharing a struct, such as setDateTime, store it once
+    constexpr PackedMessage packedMessages[] = {
+        CANPACKED_MESSAGE(frontPassengerSideDoorStatus, frontPassengerSideDoorStatus),
+        CANPACKED_MESSAGE(rearPassengerSideDoorStatus, rearPassengerSideDoorStatus),
+        CANPACKED_MESSAGE(frontDriverSideDoorStatus, frontDriverSideDoorStatus),
+        CANPACKED_MESSAGE(rearDriverSideDoorStatus, rearDriverSideDoorStatus),
+        CANPACKED_MESSAGE(mirrorFoldStatus, mirrorFoldStatus),
+        CANPACKED_MESSAGE(ignitionAndKeyLocation, ignitionAndKeyLocation),
+        CANPACKED_MESSAGE(vehicleSpeed, vehicleSpeed),
+        CANPACKED_MESSAGE(iDriveController, iDriveControler),
+        CANPACKED_MESSAGE(gearShifterPosition, gearShifterPosition),
+        CANPACKED_MESSAGE(remoteControlAndDoorHandleInput, remoteControlAndDoorHandleInput),
+        CANPACKED_MESSAGE(windowRoofAndMirrorControl, windowRoofAndMirrorControl),
+        CANPACKED_MESSAGE(doorLockControl, doorLockControl),
+        CANPACKED_MESSAGE(dateTime, dateTime),
+        CANPACKED_MESSAGE(passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus, passengerSideFrontSeatSeatbeltAndSeatOccupancyStatus),
+        CANPACKED_MESSAGE(doorOpenStatuses, doorOpenStatuses),
+        CANPACKED_MESSAGE(handbrakeStatus, handbrakeStatus)
+    };
+
+#undef CANPACKED_MESSAGE
+
+    constexpr size_t packedMessageCount = sizeof(packedMessages) / sizeof(PackedMessage);
+    static_assert(packedMessageCount == CanCoder::messageStructCount, "Every message struct must be packed");
+    static_assert((size_t)CanPackedState::Flag::count <= 64, "The flags must fit Values::flags");
+    static_assert(sizeof(CanPackedState::Values) == 24, "Values must stay small");
+    static_assert(CanCoder::maximumDataLength > 8 || sizeof(CanPackedState::AdditionalData) == 25, "AdditionalData must stay small for classic CAN");
+
+    struct LookupTable {
+        // Packed field of each decoded field by its offset in CanCoder, nullptr for other offsets
+        const PackedField* fieldAtOffset[sizeof(CanCoder)];
+    };
+
+    constexpr LookupTable CreateLookupTable() {
+        LookupTable lookupTable = {};
+        for (const PackedMessage& message : packedMessages) {
+            for (const PackedField* field = message.fields; field < message.fields + message.count; field++) {
+                if (field->kind != Kind::additionalData) {
+                    lookupTable.fieldAtOffset[field->coderOffset] = field;
+                }
+            }
+        }
+        return lookupTable;
+    }
+
+    constexpr LookupTable lookupTable = CreateLookupTable();
+
+    // Position in packedMessages plus 1 for each message by CanCoder::GetMessageIndex
+    // The order of the messages is only known to CanCoder.cpp, so this is filled when starting
+    const auto messageNumbers = []() {
+        struct {
+            uint8_t entries[CanCoder::messageCount];
+        } table = {};
+        CanCoder::Identifier identifiers[CanCoder::messageCount];
+        CanCoder::GetIdentifiers(identifiers, CanCoder::messageCount);
+        for (size_t messageIndex = 0; messageIndex < CanCoder::messageCount; messageIndex++) {
+            // setDateTime is decoded into the struct of dateTime
+            CanCoder::Identifier identifier = identifiers[messageIndex] == CanCoder::Identifier::setDateTime ? CanCoder::Identifier::dateTime : identifiers[messageIndex];
+            for (size_t index = 0; index < packedMessageCount; index++) {
+                if (packedMessages[index].identifier == identifier) {
+                    table.entries[messageIndex] = (uint8_t)(index + 1);
+                }
+            }
+        }
+        return table;
+    }();
+
+    const PackedMessage* FindPackedMessage(CanCoder::Identifier identifier) {
+        size_t messageIndex = CanCoder::GetMessageIndex(identifier);
+        if (messageIndex == CanCoder::messageCount || messageNumbers.entries[messageIndex] == 0) {
+            return nullptr;
+        }
+        return &packedMessages[messageNumbers.entries[messageIndex] - 1];
+    }
+
+    void Store(const CanCoder& coder, const PackedField& field, CanPackedState::Values& values, CanPackedState::AdditionalData* additionalData) {
+        const uint8_t* source = (const uint8_t*)&coder + field.coderOffset;
+        uint8_t* destination = (uint8_t*)&values + field.packedOffset;
+        switch (field.kind) {
+        case Kind::flag: {
+            bool flag;
+            memcpy(&flag, source, sizeof(flag));
+            values.SetFlag((CanPackedState::Flag)field.packedOffset, flag);
+            break;
+        }
+        case Kind::character:
+            memcpy(destination, source, sizeof(char));
+            break;
+        case Kind::byte: {
+            int value;
+            memcpy(&value, source, sizeof(value));
+            *destination = (uint8_t)value;
+            break;
+        }
+        case Kind::shortFromInteger: {
+            int value;
+            memcpy(&value, source, sizeof(value));
+            uint16_t shortValue = (uint16_t)value;
+            memcpy(destination, &shortValue, sizeof(shortValue));
+            break;
+        }
+        case Kind::unsignedShort:
+            memcpy(destination, source, sizeof(uint16_t));
+            break;
+        case Kind::additionalData:
+            if (additionalData != nullptr) {
+                memcpy((uint8_t*)additionalData + field.packedOffset, source, field.size);
+            }
+            break;
+        }
+    }
+
+    int32_t Load(const CanPackedState::Values& values, const PackedField& field) {
+        const uint8_t* source = (const uint8_t*)&values + field.packedOffset;
+        switch (field.kind) {
+        case Kind::flag:
+            return values.GetFlag((CanPackedState::Flag)field.packedOffset) ? 1 : 0;
+        case Kind::character:
+            return (char)*source;
+        case Kind::byte:
+            return *source;
+        case Kind::shortFromInteger:
+        case Kind::unsignedShort: {
+            uint16_t value;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        case Kind::additionalData:
+            break;
+        }
+        return 0;
+    }
+
+    void Restore(const CanPackedState::Values& values, const CanPackedState::AdditionalData* additionalData, const PackedField& field, CanCoder& coder) {
+        uint8_t* destination = (uint8_t*)&coder + field.coderOffset;
+        switch (field.kind) {
+        case Kind::flag: {
+            bool flag = values.GetFlag((CanPackedState::Flag)field.packedOffset);
+            memcpy(destination, &flag, sizeof(flag));
+            break;
+        }
+        case Kind::character: {
+            char character = (char)Load(values, field);
+            memcpy(destination, &character, sizeof(character));
+            break;
+        }
+        case Kind::byte:
+        case Kind::shortFromInteger: {
+            int value = Load(values, field);
+            memcpy(destination, &value, sizeof(value));
+            break;
+        }
+        case Kind::unsignedShort: {
+            unsigned short value = (unsigned short)Load(values, field);
+            memcpy(destination, &value, sizeof(value));
+            break;
+        }
+        case Kind::additionalData:
+            if (additionalData != nullptr) {
+                memcpy(destination, (const uint8_t*)additionalData + field.packedOffset, field.size);
+            }
+            break;
+        }
+    }
+}
+
+void CanPackedState::Update(const CanCoder& inCoder, Values& outValues, AdditionalData* outAdditionalData) {
+    const PackedMessage* message = FindPackedMessage(inCoder._identifier);
+    if (message == nullptr) {
+        return;
+    }
+    for (const PackedField* field = message->fields; field < message->fields + message->count; field++) {
+        Store(inCoder, *field, outValues, outAdditionalData);
+    }
+    outValues.identifier = (uint16_t)inCoder._identifier;
+}
+
+void CanPackedState::Pack(const CanCoder& inCoder, Values& outValues, AdditionalData* outAdditionalData) {
+    for (const PackedMessage& message : packedMessages) {
+        for (const PackedField* field = message.fields; field < message.fields + message.count; field++) {
+            Store(inCoder, *field, outValues, outAdditionalData);
+        }
+    }
+    outValues.identifier = (uint16_t)inCoder._identifier;
+}
+
+void CanPackedState::Unpack(const Values& inValues, const AdditionalData* inAdditionalData, CanCoder& outCoder) {
+    for (const PackedMessage& message : packedMessages) {
+        for (const PackedField* field = message.fields; field < message.fields + message.count; field++) {
+            Restore(inValues, inAdditionalData, *field, outCoder);
+        }
+    }
+    outCoder._identifier = (CanCoder::Identifier)inValues.identifier;
+}
+
+int32_t CanPackedState::GetFieldValue(const Values& inValues, const CanCoder::Field& inField) {
+    if (inField.offset >= sizeof(CanCoder) || lookupTable.fieldAtOffset[inField.offset] == nullptr) {
+        return 0;
+    }
+    return Load(inValues, *lookupTable.fieldAtOffset[inField.offset]);
+}
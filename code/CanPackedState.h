@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanPackedState
+ *
+ * Compact representation of the decoded state of a CanCoder
+ *
+ * CanCoder keeps a struct of bools and ints per message, plus the additional data
+ * needed to encode, which is far larger than the information it holds. When many
+ * vehicles are simulated or monitored, keeping a CanCoder per vehicle fills the caches
+ * with padding. CanPackedState keeps the same state in two parts:
+ * Values          All decoded fields in 24 bytes: the booleans as bits of one word, the
+ *                 other fields as the narrowest integer holding their signal
+ * AdditionalData  The raw bytes that are not decoded, only needed to encode
+ * Values are used on every decode and AdditionalData rarely, so they can be stored
+ * apart, for example an array of Values for all vehicles and the additional data in
+ * another array.
+ * AdditionalData is sized for classic CAN, 25 bytes. With CANCODER_MAXIMUM_DATA_LENGTH
+ * set to 64 for CAN FD it holds up to 64 bytes per message, 305 bytes, and should only
+ * be kept for the vehicles that are encoded for.
+ * Update finds the message and GetFieldValue the field through tables built at compile
+ * time, neither searches.
+ *
+ * Decoding still uses a CanCoder: one CanCoder per thread decodes the frames of all
+ * vehicles and Update stores the decoded message in the packed state of the vehicle.
+ * Unpack restores a CanCoder, for example to encode from the state of a vehicle.
+ * Values written to a CanCoder for encoding must fit the signal of their field, the
+ * same range that is kept by the packed state.
+ *
+ * For example, decoding frames of many vehicles:
+ *     CanCoder coder;
+ *     std::vector<CanPackedState::Values> vehicles(vehicleCount);
+ *     if (coder.Decode(frame.identifier, frame.dataLengthCode, frame.data)) {
+ *         CanPackedState::Update(coder, vehicles[vehicle], nullptr);
+ *     }
+ *     if (vehicles[vehicle].GetFlag(CanPackedState::Flag::bootIsOpen)) {
+ *         ...
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: table lookups of messages and fields, AdditionalData sized for classic CAN
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class CanPackedState {
+public:
+    /// @brief Boolean fields, in the order of CanCoder::GetFields of the supported messages
+    enum class Flag : uint8_t {
+        frontPassengerSideDoorOpen,
+        frontPassengerSideDoorLocked,
+        rearPassengerSideDoorOpen,
+        rearPassengerSideDoorLocked,
+        frontDriverSideDoorOpen,
+        frontDriverSideDoorLocked,
+        rearDriverSideDoorOpen,
+        rearDriverSideDoorLocked,
+        mirrorsFolded,
+        keyIsOutside,
+        homeButton,
+        menuButton,
+        stickUp,
+        stickRight,
+        stickDown,
+        stickLeft,
+        stickPush,
+        remoteControlUnlockButton,
+        remoteControlLockButton,
+        doorHandleUnlockButton,
+        doorHandleLockButton,
+        closeWindowsAndRoof,
+        foldMirrors,
+        lockDoors,
+        seatbeltFastened,
+        occupied,
+        frontDriverSideDoorIsOpen,
+        frontPassengerSideDoorIsOpen,
+        rearDriverSideDoorIsOpen,
+        rearPassengerSideDoorIsOpen,
+        bootIsOpen,
+        bonnetIsOpen,
+        handbrakeIsActive,
+        count
+    };
+
+    /// @brief Decoded fields of all messages
+    struct Values {
+        // Bit n holds Flag n
+        uint64_t flags;
+        // Identifier of the message last stored by Update
+        uint16_t identifier;
+        // Vehicle speed, 12 bits
+        uint16_t speed;
+        uint16_t dialValue;
+        uint16_t year;
+        uint8_t month;
+        uint8_t day;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
+        char gearPosition;
+
+        /// @brief Get a boolean field
+        bool GetFlag(Flag inFlag) const { return (flags >> (unsigned)inFlag) & 1; }
+        /// @brief Set a boolean field
+        void SetFlag(Flag inFlag, bool inValue) {
+            flags = (flags & ~(1ull << (unsigned)inFlag)) | ((uint64_t)inValue << (unsigned)inFlag);
+        }
+    };
+
+    /// @brief Data of the messages that is not decoded, with the defaults of CanCoder
+    struct AdditionalData {
+        CanCoder::IDriveController::AdditionalData iDriveController;
+        CanCoder::GearShifterPosition::AdditionalData gearShifterPosition;
+        CanCoder::WindowRoofAndMirrorControl::AdditionalData windowRoofAndMirrorControl;
+        CanCoder::DoorLockControl::AdditionalData doorLockControl;
+        CanCoder::DateTime::AdditionalData dateTime;
+    };
+
+    /// @brief Store the message last decoded by a coder
+    /// @param inCoder The coder, its _identifier selects the message
+    /// @param outValues Receives the decoded fields of the message
+    /// @param outAdditionalData Receives the additional data of the message, may be nullptr
+    static void Update(const CanCoder& inCoder, Values& outValues, AdditionalData* outAdditionalData);
+    /// @brief Store all messages of a coder
+    /// @param inCoder The coder
+    /// @param outValues Receives the decoded fields of all messages
+    /// @param outAdditionalData Receives the additional data of all messages, may be nullptr
+    static void Pack(const CanCoder& inCoder, Values& outValues, AdditionalData* outAdditionalData);
+    /// @brief Restore all messages of a coder
+    /// @param inValues The decoded fields
+    /// @param inAdditionalData The additional data, nullptr to keep the additional data of the coder
+    /// @param outCoder The coder
+    static void Unpack(const Values& inValues, const AdditionalData* inAdditionalData, CanCoder& outCoder);
+    /// @brief Get the value of a field, the same value CanCoder::GetFieldValue returns
+    /// @param inValues The decoded fields
+    /// @param inField The field, from CanCoder::GetFields
+    static int32_t GetFieldValue(const Values& inValues, const CanCoder::Field& inField);
+
+    void Update(const CanCoder& inCoder) { Update(inCoder, _values, &_additionalData); }
+    void Pack(const CanCoder& inCoder) { Pack(inCoder, _values, &_additionalData); }
+    void Unpack(CanCoder& outCoder) const { Unpack(_values, &_additionalData, outCoder); }
+    int32_t GetFieldValue(const CanCoder::Field& inField) const { return GetFieldValue(_values, inField); }
+    bool GetFlag(Flag inFlag) const { return _values.GetFlag(inFlag); }
+
+    Values _values = {};
+    AdditionalData _additionalData;
+};
@@ -0,0 +1,238 @@
+#include "CanPayloadSearch.h"
+#include <string.h>
+#include <algorithm>
+#include <bit>
+
+namespace {
+    // Blocks of fewer patterns are compared without vector instructions, which costs less for them
+    constexpr uint32_t smallBlockSize = 8;
+
+    // Standard CAN identifiers are 11 bits
+    constexpr uint32_t standardIdentifierCount = 0x800;
+
+    // Data bytes as a word, byte n in bits 8n-8n+7
+    uint64_t ToWord(const uint8_t* bytes, uint8_t length) {
+        uint64_t word = 0;
+        for (uint8_t index = 0; index < length; index++) {
+            word |= (uint64_t)bytes[index] << (index * 8);
+        }
+        return word;
+    }
+
+    int HexadecimalValue(char character) {
+        if (character >= '0' && character <= '9') {
+            return character - '0';
+        }
+        if (character >= 'a' && character <= 'f') {
+            return character - 'a' + 10;
+        }
+        if (character >= 'A' && character <= 'F') {
+            return character - 'A' + 10;
+        }
+        return -1;
+    }
+}
+
+int CanPayloadSearch::AddPattern(uint32_t inIdentifier, const uint8_t* inValue, const uint8_t* inMask, uint8_t inLength) {
+    if (inLength > 8) {
+        return -1;
+    }
+    Pattern pattern;
+    pattern.identifier = inIdentifier;
+    pattern.mask = ToWord(inMask, inLength);
+    pattern.value = ToWord(inValue, inLength) & pattern.mask;
+    _patterns.push_back(pattern);
+    _compiled = false;
+    return (int)(_patterns.size() - 1);
+}
+
+int CanPayloadSearch::AddPattern(const char* inText) {
+    const char* separator = strchr(inText, '#');
+    if (separator == nullptr) {
+        return -1;
+    }
+    uint32_t identifier = 0;
+    size_t identifierLength = separator - inText;
+    if (identifierLength == 1 && inText[0] == '*') {
+        identifier = anyIdentifier;
+    }
+    else if (identifierLength == 3 || identifierLength == 8) {
+        for (const char* character = inText; character < separator; character++) {
+            int digit = HexadecimalValue(*character);
+            if (digit < 0) {
+                return -1;
+            }
+            identifier = identifier << 4 | digit;
+        }
+        if (identifierLength == 3 && identifier > 0x7ff) {
+            return -1;
+        }
+        if (identifierLength == 8) {
+            if (identifier > 0x1fffffff) {
+                return -1;
+            }
+            identifier |= CanCoder::extendedIdentifierFlag;
+        }
+    }
+    else {
+        return -1;
+    }
+    const char* digits = separator + 1;
+    size_t digitCount = strlen(digits);
+    if (digitCount % 2 != 0 || digitCount > 16) {
+        return -1;
+    }
+    uint8_t value[8] = {};
+    uint8_t mask[8] = {};
+    for (size_t index = 0; index < digitCount; index++) {
+        unsigned shift = index % 2 == 0 ? 4 : 0;
+        if (digits[index] == 'x' || digits[index] == 'X' || digits[index] == '?') {
+            continue;
+        }
+        int digit = HexadecimalValue(digits[index]);
+        if (digit < 0) {
+            return -1;
+        }
+        value[index / 2] |= (uint8_t)(digit << shift);
+        mask[index / 2] |= (uint8_t)(0xf << shift);
+    }
+    return AddPattern(identifier, value, mask, (uint8_t)(digitCount / 2));
+}
+
+void CanPayloadSearch::Clear() {
+    _patterns.clear();
+    _compiled = false;
+}
+
+void CanPayloadSearch::Compile() {
+    if (_compiled) {
+        return;
+    }
+    // Pattern numbers sorted by group: standard identifiers, extended identifiers, any identifier
+    std::vector<uint32_t> order(_patterns.size());
+    for (uint32_t index = 0; index < order.size(); index++) {
+        order[index] = index;
+    }
+    auto key = [this](uint32_t patternNumber) {
+        uint32_t identifier = _patterns[patternNumber].identifier;
+        return identifier == anyIdentifier ? UINT64_MAX : ((uint64_t)((identifier & CanCoder::extendedIdentifierFlag) != 0) << 32) | identifier;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t patternNumber1, uint32_t patternNumber2) { return key(patternNumber1) < key(patternNumber2); });
+
+    _values.clear();
+    _masks.clear();
+    _patternNumbers.clear();
+    _groups.clear();
+    _groupNumbers.clear();
+    for (uint32_t patternNumber : order) {
+        const Pattern& pattern = _patterns[patternNumber];
+        if (_groups.empty() || _groups.back().identifier != pattern.identifier) {
+            _groups.push_back({ pattern.identifier, (uint32_t)_values.size(), 0 });
+        }
+        _groups.back().count++;
+        _values.push_back(pattern.value);
+        _masks.push_back(pattern.mask);
+        _patternNumbers.push_back(patternNumber);
+    }
+    _extendedGroupsBegin = _groups.size();
+    _extendedGroupsEnd = _groups.size();
+    for (size_t groupNumber = 0; groupNumber < _groups.size(); groupNumber++) {
+        uint32_t identifier = _groups[groupNumber].identifier;
+        if (identifier == anyIdentifier) {
+            _extendedGroupsEnd = std::min(_extendedGroupsEnd, groupNumber);
+        }
+        else if ((identifier & CanCoder::extendedIdentifierFlag) != 0) {
+            _extendedGroupsBegin = std::min(_extendedGroupsBegin, groupNumber);
+        }
+        else {
+            // Allocated by the first standard group for all standard identifiers, which keeps the lookup of a frame a single compare
+            _groupNumbers.resize(standardIdentifierCount, 0);
+            _groupNumbers[identifier] = (uint16_t)(groupNumber + 1);
+        }
+    }
+    _extendedGroupsBegin = std::min(_extendedGroupsBegin, _extendedGroupsEnd);
+    _compiled = true;
+}
+
+size_t CanPayloadSearch::Match(const Group& inGroup, const CanCoder::Frame& inFrame, uint64_t inFrameNumber, std::vector<Hit>& outHits) const {
+    uint64_t data;
+    memcpy(&data, inFrame.data, sizeof(data));
+    if constexpr (std::endian::native == std::endian::big) {
+        data = ToWord(inFrame.data, 8);
+    }
+    // Bits of the bytes past the data length, a pattern masking any of them does not match
+    uint64_t invalid = inFrame.dataLengthCode >= 8 ? 0 : UINT64_MAX << (inFrame.dataLengthCode * 8);
+    const uint64_t* values = _values.data() + inGroup.first;
+    const uint64_t* masks = _masks.data() + inGroup.first;
+    size_t hitCount = 0;
+    // Up to 64 patterns are compared at a time. The compare loop has no branches and only
+    // 64 bit elements, so it vectorizes, hits are rare and only then gathered into a bit mask.
+    uint64_t results[64];
+    for (uint32_t block = 0; block < inGroup.count; block += 64) {
+        uint32_t blockSize = std::min<uint32_t>(inGroup.count - block, 64);
+        uint64_t matches = 0;
+        if (blockSize < smallBlockSize) {
+            for (uint32_t index = 0; index < blockSize; index++) {
+                uint64_t mask = masks[block + index];
+                uint64_t difference = ((data & mask) ^ values[block + index]) | (mask & invalid);
+                matches |= (uint64_t)(difference == 0) << index;
+            }
+        }
+        else {
+            uint64_t any = 0;
+            for (uint32_t index = 0; index < blockSize; index++) {
+                uint64_t mask = masks[block + index];
+                uint64_t difference = ((data & mask) ^ values[block + index]) | (mask & invalid);
+                // 1 when difference is 0
+                uint64_t match = ((difference - 1) & ~difference) >> 63;
+                results[index] = match;
+                any |= match;
+            }
+            if (any == 0) {
+                continue;
+            }
+            for (uint32_t index = 0; index < blockSize; index++) {
+                matches |= results[index] << index;
+            }
+        }
+        while (matches != 0) {
+            uint32_t index = block + std::countr_zero(matches);
+            matches &= matches - 1;
+            outHits.push_back({ inFrameNumber, inFrame.timestamp, inFrame.identifier, _patternNumbers[inGroup.first + index] });
+            hitCount++;
+        }
+    }
+    return hitCount;
+}
+
+size_t CanPayloadSearch::Search(const CanCoder::Frame* inFrames, size_t inFrameCount, std::vector<Hit>& outHits, uint64_t inFirstFrameNumber) {
+    Compile();
+    if (_groups.empty()) {
+        return 0;
+    }
+    const Group* anyGroup = _groups.back().identifier == anyIdentifier ? &_groups.back() : nullptr;
+    const Group* extendedGroupsBegin = _groups.data() + _extendedGroupsBegin;
+    const Group* extendedGroupsEnd = _groups.data() + _extendedGroupsEnd;
+    const uint16_t* groupNumbers = _groupNumbers.data();
+    size_t groupNumberCount = _groupNumbers.size();
+    size_t hitCount = 0;
+    for (size_t frameNumber = 0; frameNumber < inFrameCount; frameNumber++) {
+        const CanCoder::Frame& frame = inFrames[frameNumber];
+        const Group* group = nullptr;
+        if (frame.identifier < groupNumberCount) {
+            group = groupNumbers[frame.identifier] != 0 ? &_groups[groupNumbers[frame.identifier] - 1] : nullptr;
+        }
+        else if (extendedGroupsBegin != extendedGroupsEnd && (frame.identifier & CanCoder::extendedIdentifierFlag) != 0) {
+            const Group* found = std::lower_bound(extendedGroupsBegin, extendedGroupsEnd, frame.identifier,
+                [](const Group& group, uint32_t identifier) { return group.identifier < identifier; });
+            group = found != extendedGroupsEnd && found->identifier == frame.identifier ? found : nullptr;
+        }
+        if (group != nullptr) {
+            hitCount += Match(*group, frame, inFirstFrameNumber + frameNumber, outHits);
+        }
+        if (anyGroup != nullptr) {
+            hitCount += Match(*anyGroup, frame, inFirstFrameNumber + frameNumber, outHits);
+        }
+    }
+    return hitCount;
+}
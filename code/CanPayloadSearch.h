@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanPayloadSearch
+ *
+ * Searching frames for many masked payload patterns in one pass
+ *
+ * A pattern is an identifier with a value and a mask for each data byte, a frame matches
+ * when (data & mask) == value for all bytes and the data is long enough to hold every
+ * masked byte. Patterns are compiled into one 64 bit mask and value each, so matching a
+ * pattern is a single compare of the data as a word (SWAR). Mask bits in bytes past the
+ * data length of a frame always differ, which makes the length check part of that compare.
+ * The patterns are grouped by identifier and the masks and values of a group are kept in
+ * arrays of their own. For groups of 8 or more patterns the compare loop stores a 0 or 1
+ * per pattern without branches and compiles to SSE2 vector instructions, the rare matches
+ * are then gathered into a bit mask. A frame is only compared with the patterns of its own
+ * identifier, plus the patterns for any identifier.
+ *
+ * The patterns are compiled by the first Search after they were changed. When several
+ * threads search with the same CanPayloadSearch, call Compile before starting them.
+ *
+ * Patterns can be given as text, in the style of candump:
+ *     130#xx0Exxx4     identifier 0x130, byte 1 is 0x0E and the low nibble of byte 3 is 4
+ *     12345678#FF      extended identifier 0x12345678, byte 0 is 0xFF
+ *     *#xxxxA5         any identifier, byte 2 is 0xA5
+ * Each byte is 2 hexadecimal digits, x or ? ignores a digit. Identifiers of 3 digits are
+ * standard, of 8 digits extended. Bit masks can be given with the other AddPattern.
+ *
+ * For example:
+ *     CanPayloadSearch search;
+ *     search.AddPattern("130#xx0Exxx4");
+ *     CanCaptureReader capture;
+ *     capture.Open("drive.cap");
+ *     std::vector<CanPayloadSearch::Hit> hits;
+ *     search.Search(capture, hits);
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: compile the patterns on the first search instead of on each AddPattern,
+ *            vectorized compare loop
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class CanPayloadSearch {
+public:
+    /// @brief Identifier of patterns matching frames of every identifier
+    static constexpr uint32_t anyIdentifier = 0xffffffff;
+
+    /// @brief A frame matching a pattern
+    struct Hit {
+        // Number of the frame within the searched frames
+        uint64_t frameNumber;
+        uint64_t timestamp;
+        uint32_t identifier;
+        // Number of the pattern, as returned by AddPattern
+        uint32_t patternNumber;
+    };
+
+    /// @brief Add a pattern
+    /// @param inIdentifier CAN message identifier, extended identifiers carry CanCoder::extendedIdentifierFlag, or anyIdentifier
+    /// @param inValue Value of the masked bits of each byte
+    /// @param inMask Mask of each byte, bits that are 0 are ignored
+    /// @param inLength Number of bytes of the value and mask, 0-8
+    /// @return The pattern number, -1 when the length is more than 8 bytes
+    int AddPattern(uint32_t inIdentifier, const uint8_t* inValue, const uint8_t* inMask, uint8_t inLength);
+    /// @brief Add a pattern given as text, see the description above
+    /// @param inText The pattern, for example "130#xx0Exxx4"
+    /// @return The pattern number, -1 when the text is not a valid pattern
+    int AddPattern(const char* inText);
+    /// @brief Remove all patterns
+    void Clear();
+    /// @brief Get the number of patterns
+    size_t GetPatternCount() const { return _patterns.size(); }
+    /// @brief Compile the patterns added since the last compile, Search does this when needed
+    void Compile();
+
+    /// @brief Search frames for all patterns
+    /// @param inFrames The frames
+    /// @param inFrameCount Number of frames
+    /// @param outHits Receives a hit for each pattern a frame matches, in frame order
+    /// @param inFirstFrameNumber Frame number of the first frame
+    /// @return The number of hits added to outHits
+    size_t Search(const CanCoder::Frame* inFrames, size_t inFrameCount, std::vector<Hit>& outHits, uint64_t inFirstFrameNumber = 0);
+    /// @brief Search all frames of a source for all patterns
+    /// @param inSource A CanCaptureReader, CanLogReplay or other class with ForEachFrame
+    /// @param outHits Receives a hit for each pattern a frame matches, in frame order
+    /// @return The number of hits added to outHits
+    template <typename Source>
+    size_t Search(const Source& inSource, std::vector<Hit>& outHits) {
+        constexpr size_t chunkSize = 1024;
+        CanCoder::Frame frames[chunkSize];
+        size_t frameCount = 0;
+        uint64_t frameNumber = 0;
+        size_t hitCount = 0;
+        inSource.ForEachFrame([&](const CanCoder::Frame& frame) {
+            frames[frameCount++] = frame;
+            if (frameCount == chunkSize) {
+                hitCount += Search(frames, frameCount, outHits, frameNumber);
+                frameNumber += frameCount;
+                frameCount = 0;
+            }
+        });
+        return hitCount + Search(frames, frameCount, outHits, frameNumber);
+    }
+
+private:
+    struct Pattern {
+        uint32_t identifier;
+        uint64_t value;
+        uint64_t mask;
+    };
+    // Patterns of one identifier, stored from first in the compiled arrays
+    struct Group {
+        uint32_t identifier;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    size_t Match(const Group& inGroup, const CanCoder::Frame& inFrame, uint64_t inFrameNumber, std::vector<Hit>& outHits) const;
+
+    std::vector<Pattern> _patterns;
+    // Whether the compiled patterns below are up to date with _patterns
+    bool _compiled = false;
+    // Compiled patterns, grouped by identifier
+    std::vector<uint64_t> _values;
+    std::vector<uint64_t> _masks;
+    std::vector<uint32_t> _patternNumbers;
+    // Groups of standard identifiers, extended identifiers sorted by identifier, and any identifier last
+    std::vector<Group> _groups;
+    size_t _extendedGroupsBegin = 0;
+    size_t _extendedGroupsEnd = 0;
+    // Group number plus 1 for each standard identifier, 0 when it has no patterns, empty without standard patterns
+    // The patterns can be for any identifier, not only those CanCoder supports, so CanCoder::GetMessageIndex does not fit
+    std::vector<uint16_t> _groupNumbers;
+};
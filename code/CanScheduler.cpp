@@ -0,0 +1,106 @@
+#include "CanScheduler.h"
+#include <algorithm>
+
+int CanScheduler::AddPeriodic(CanCoder::Identifier inIdentifier, uint64_t inInterval, uint64_t inFirstDueTime) {
+    if (inInterval == 0) {
+        return -1;
+    }
+    return Add(inIdentifier, inInterval, inFirstDueTime);
+}
+
+int CanScheduler::AddOneShot(CanCoder::Identifier inIdentifier, uint64_t inDueTime) {
+    return Add(inIdentifier, 0, inDueTime);
+}
+
+int CanScheduler::Add(CanCoder::Identifier inIdentifier, uint64_t inInterval, uint64_t inDueTime) {
+    if (_sink == nullptr || !CanCoder::IsEncodable(inIdentifier)) {
+        return -1;
+    }
+    for (uint32_t jobNumber = 0; jobNumber < maximumJobCount; jobNumber++) {
+        Job& job = _jobs[jobNumber];
+        if (!job.active) {
+            // Removed jobs may still have an entry, make room by dropping those first
+            if (_heapSize == sizeof(_heap) / sizeof(_heap[0])) {
+                HeapEntry* end = std::remove_if(_heap, _heap + _heapSize, [this](const HeapEntry& entry) {
+                    return !_jobs[entry.jobNumber].active || _jobs[entry.jobNumber].generation != entry.generation;
+                });
+                _heapSize = end - _heap;
+                std::make_heap(_heap, _heap + _heapSize, IsLater);
+            }
+            job.identifier = inIdentifier;
+            job.interval = inInterval;
+            job.active = true;
+            job.frame = {};
+            PushHeapEntry({ inDueTime, jobNumber, job.generation });
+            return (int)jobNumber;
+        }
+    }
+    return -1;
+}
+
+bool CanScheduler::Remove(int inJobNumber) {
+    if (inJobNumber < 0 || inJobNumber >= (int)maximumJobCount || !_jobs[inJobNumber].active) {
+        return false;
+    }
+    // The heap entry is dropped when it comes to the top
+    _jobs[inJobNumber].active = false;
+    _jobs[inJobNumber].generation++;
+    return true;
+}
+
+size_t CanScheduler::Poll(uint64_t inNow) {
+    size_t frameCount = 0;
+    while (_heapSize > 0 && _heap[0].dueTime <= inNow) {
+        HeapEntry entry = _heap[0];
+        PopHeapEntry();
+        Job& job = _jobs[entry.jobNumber];
+        if (!job.active || job.generation != entry.generation) {
+            continue;
+        }
+        Transmit(job, entry.dueTime);
+        frameCount++;
+        if (job.interval == 0) {
+            job.active = false;
+            job.generation++;
+            continue;
+        }
+        // Skip the cycles that were missed entirely
+        uint64_t nextDueTime = entry.dueTime + job.interval;
+        if (nextDueTime <= inNow) {
+            nextDueTime += (inNow - nextDueTime) / job.interval * job.interval + job.interval;
+        }
+        PushHeapEntry({ nextDueTime, entry.jobNumber, entry.generation });
+    }
+    return frameCount;
+}
+
+uint64_t CanScheduler::NextDueTime() const {
+    // Entries of removed jobs are not dropped here, at worst the caller wakes up once for nothing
+    return _heapSize > 0 ? _heap[0].dueTime : never;
+}
+
+bool CanScheduler::IsLater(const HeapEntry& inEntry1, const HeapEntry& inEntry2) {
+    return inEntry1.dueTime > inEntry2.dueTime;
+}
+
+void CanScheduler::PushHeapEntry(const HeapEntry& inEntry) {
+    _heap[_heapSize++] = inEntry;
+    std::push_heap(_heap, _heap + _heapSize, IsLater);
+}
+
+void CanScheduler::PopHeapEntry() {
+    std::pop_heap(_heap, _heap + _heapSize, IsLater);
+    _heapSize--;
+}
+
+void CanScheduler::Transmit(Job& inJob, uint64_t inDueTime) {
+    // Encode uses the identifier of the coder, the identifier of the last decode is restored afterwards
+    CanCoder::Identifier identifier = _coder._identifier;
+    _coder._identifier = inJob.identifier;
+    _coder.Encode(inJob.frame.identifier, inJob.frame.dataLengthCode, inJob.frame.data);
+    _coder._identifier = identifier;
+    inJob.frame.timestamp = inDueTime;
+    if (!_sink(_context, inJob.frame)) {
+        _failedCount++;
+    }
+}
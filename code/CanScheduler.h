@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanScheduler
+ *
+ * Cyclic and one shot transmission of messages encoded by CanCoder
+ *
+ * Jobs are kept in a min-heap ordered by the time they are due, so one timer is enough
+ * for all messages: wait until NextDueTime(), then call Poll(). Each job has its own
+ * preallocated frame that the message is encoded into with CanCoder::Encode, using the
+ * latest state of the coder, after which the frame is passed to the sink.
+ * Periodic jobs are due at fixed intervals from their first due time, so the jitter of
+ * the caller waking up does not accumulate. Cycles that were missed entirely are
+ * skipped rather than sent in a burst.
+ * Times are in microseconds, from whatever clock the caller uses.
+ *
+ * The scheduler is not thread safe, it must be used on the thread that owns the coder.
+ *
+ * For example:
+ *     bool Send(void* context, const CanCoder::Frame& frame) {
+ *         ...
+ *     }
+ *     CanScheduler scheduler(coder, Send, nullptr);
+ *     scheduler.AddPeriodic(CanCoder::Identifier::gearShifterPosition, 100000, now);
+ *     while (running) {
+ *         // Wait until scheduler.NextDueTime()
+ *         scheduler.Poll(now);
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class CanScheduler {
+public:
+    /// @brief Function transmitting a frame
+    /// @param inContext The context passed to the scheduler
+    /// @param inFrame The frame, its timestamp is the time it was due
+    /// @return true on success, false on failure
+    using Sink = bool (*)(void* inContext, const CanCoder::Frame& inFrame);
+
+    /// @brief Maximum number of jobs
+    static constexpr size_t maximumJobCount = 32;
+    /// @brief Due time returned by NextDueTime when there are no jobs
+    static constexpr uint64_t never = UINT64_MAX;
+
+    /// @param inCoder The coder to encode with, it must outlive the scheduler
+    /// @param inSink Function transmitting the frames
+    /// @param inContext Passed to the sink
+    CanScheduler(CanCoder& inCoder, Sink inSink, void* inContext) : _coder(inCoder), _sink(inSink), _context(inContext) {}
+
+    /// @brief Add a job transmitting a message at a fixed interval
+    /// @param inIdentifier CAN message identifier, the message must be encodable
+    /// @param inInterval Interval in microseconds, must not be 0
+    /// @param inFirstDueTime Time of the first transmission
+    /// @return The job number, -1 when there are maximumJobCount jobs or the parameters are invalid
+    int AddPeriodic(CanCoder::Identifier inIdentifier, uint64_t inInterval, uint64_t inFirstDueTime);
+    /// @brief Add a job transmitting a message once
+    /// @param inIdentifier CAN message identifier, the message must be encodable
+    /// @param inDueTime Time of the transmission
+    /// @return The job number, -1 when there are maximumJobCount jobs or the parameters are invalid
+    int AddOneShot(CanCoder::Identifier inIdentifier, uint64_t inDueTime);
+    /// @brief Remove a job
+    /// @param inJobNumber The job number
+    /// @return true on success, false when there is no such job
+    bool Remove(int inJobNumber);
+
+    /// @brief Transmit all messages that are due
+    /// @param inNow The current time
+    /// @return The number of frames passed to the sink
+    size_t Poll(uint64_t inNow);
+    /// @brief Get the time the next message is due, never when there are no jobs
+    uint64_t NextDueTime() const;
+    /// @brief Get the number of frames the sink failed to transmit
+    uint64_t GetFailedCount() const { return _failedCount; }
+
+private:
+    struct Job {
+        CanCoder::Identifier identifier;
+        // 0 for one shot jobs
+        uint64_t interval;
+        // Incremented when the job is removed, so heap entries of removed jobs can be recognized
+        uint32_t generation;
+        bool active;
+        CanCoder::Frame frame;
+    };
+    struct HeapEntry {
+        uint64_t dueTime;
+        uint32_t jobNumber;
+        uint32_t generation;
+    };
+
+    // Order for std::push_heap and std::pop_heap, putting the earliest due time on top
+    static bool IsLater(const HeapEntry& inEntry1, const HeapEntry& inEntry2);
+    int Add(CanCoder::Identifier inIdentifier, uint64_t inInterval, uint64_t inDueTime);
+    void PushHeapEntry(const HeapEntry& inEntry);
+    void PopHeapEntry();
+    void Transmit(Job& inJob, uint64_t inDueTime);
+
+    CanCoder& _coder;
+    Sink _sink;
+    void* _context;
+    Job _jobs[maximumJobCount] = {};
+    // Min-heap on the due time, holding one entry per active job plus entries of removed jobs
+    HeapEntry _heap[maximumJobCount * 2];
+    size_t _heapSize = 0;
+    uint64_t _failedCount = 0;
+};
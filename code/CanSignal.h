@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanSignal
+ *
+ * Compile time description of a signal (bit field) in CAN message data
+ *
+ * A signal is described once by its start bit, length and byte order, the same way
+ * as in a DBC file. The extract and insert functions are generated from that
+ * description, so decoding and encoding of a message can not drift apart.
+ * All positions are known at compile time, so the functions compile to a few
+ * loads, shifts and masks without branches. Only the bytes covered by the signal
+ * are accessed.
+ *
+ * Bit numbering:
+ * Bit n is bit (n % 8) of byte (n / 8), bit 0 being the least significant bit.
+ * For little endian (Intel) signals the start bit is the least significant bit of the signal.
+ * For big endian (Motorola) signals the start bit is the most significant bit of the signal.
+ *
+ * For example, the vehicle speed in the first 12 bits of bytes 0 and 1:
+ *     using Speed = CanSignal<0, 12>;
+ *     int speed = Speed::Extract(data);
+ *     Speed::Insert(data, speed);
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: FromPhysical clamps to the range of the signal
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <ratio>
+#include <type_traits>
+
+enum class CanByteOrder {
+    littleEndian,
+    bigEndian
+};
+
+/// @brief Signal in CAN message data
+/// @tparam StartBit Start bit, see the bit numbering above
+/// @tparam Length Number of bits, 1-32
+/// @tparam ByteOrder Byte order of the signal
+/// @tparam Signed Whether the raw value is two's complement
+/// @tparam Scale Factor to get from the raw value to the physical value
+/// @tparam Offset Offset to add to the scaled value to get the physical value
+template <unsigned StartBit, unsigned Length, CanByteOrder ByteOrder = CanByteOrder::littleEndian, bool Signed = false, typename Scale = std::ratio<1>, typename Offset = std::ratio<0>>
+struct CanSignal {
+    static_assert(Length >= 1 && Length <= 32, "A signal must be 1-32 bits long");
+
+    using RawType = typename std::conditional<Signed, int32_t, uint32_t>::type;
+
+    static constexpr uint32_t mask = Length == 32 ? 0xffffffff : (uint32_t)((1ull << Length) - 1);
+    /// @brief Range of the raw value
+    static constexpr RawType minimumRaw = Signed ? (RawType)(-(int64_t)(1ull << (Length - 1))) : 0;
+    static constexpr RawType maximumRaw = Signed ? (RawType)((1ull << (Length - 1)) - 1) : (RawType)mask;
+
+    // Position of the least significant bit, counting from the most significant bit of byte 0
+    // Only used for big endian signals
+    static constexpr unsigned bigEndianLastBit = (StartBit / 8) * 8 + (7 - StartBit % 8) + Length - 1;
+
+    static constexpr unsigned firstByte = StartBit / 8;
+    static constexpr unsigned lastByte = ByteOrder == CanByteOrder::littleEndian ? (StartBit + Length - 1) / 8 : bigEndianLastBit / 8;
+    // Shift of the signal within the bytes firstByte-lastByte
+    // For little endian signals these bytes are combined with firstByte being least significant
+    // For big endian signals these bytes are combined with firstByte being most significant
+    static constexpr unsigned shift = ByteOrder == CanByteOrder::littleEndian ? StartBit % 8 : 7 - bigEndianLastBit % 8;
+
+    /// @brief Minimum data length code of a message holding this signal
+    static constexpr uint8_t minimumDataLengthCode = lastByte + 1;
+
+    /// @brief Get the raw value of the signal
+    /// @param inData CAN message data, must hold at least minimumDataLengthCode bytes
+    /// @return The raw value, sign extended for signed signals
+    static constexpr RawType Extract(const uint8_t* inData) {
+        uint64_t bytes = 0;
+        for (unsigned byte = firstByte; byte <= lastByte; byte++) {
+            if constexpr (ByteOrder == CanByteOrder::littleEndian) {
+                bytes |= (uint64_t)inData[byte] << ((byte - firstByte) * 8);
+            }
+            else {
+                bytes = (bytes << 8) | inData[byte];
+            }
+        }
+        uint32_t raw = (uint32_t)(bytes >> shift) & mask;
+        if constexpr (Signed && Length < 32) {
+            // Sign extend by moving the sign bit to bit 31 and shifting back arithmetically
+            return (RawType)((int32_t)(raw << (32 - Length)) >> (32 - Length));
+        }
+        return (RawType)raw;
+    }
+
+    /// @brief Set the raw value of the signal, leaving all other bits untouched
+    /// @param outData CAN message data, must hold at least minimumDataLengthCode bytes
+    /// @param inRaw The raw value, bits that do not fit the signal are discarded
+    static constexpr void Insert(uint8_t* outData, RawType inRaw) {
+        uint64_t bits = ((uint64_t)((uint32_t)inRaw & mask)) << shift;
+        uint64_t bitMask = (uint64_t)mask << shift;
+        for (unsigned byte = firstByte; byte <= lastByte; byte++) {
+            unsigned byteShift = ByteOrder == CanByteOrder::littleEndian ? (byte - firstByte) * 8 : (lastByte - byte) * 8;
+            uint8_t byteMask = (uint8_t)(bitMask >> byteShift);
+            outData[byte] = (uint8_t)((outData[byte] & ~byteMask) | ((bits >> byteShift) & byteMask));
+        }
+    }
+
+    /// @brief Convert a raw value to its physical value
+    static constexpr double ToPhysical(RawType inRaw) {
+        return (double)inRaw * Scale::num / Scale::den + (double)Offset::num / Offset::den;
+    }
+
+    /// @brief Convert a physical value to its raw value, rounding to the nearest raw value
+    ///
+    /// Values outside the range of the signal are clamped to minimumRaw or maximumRaw, NaN gives minimumRaw
+    static constexpr RawType FromPhysical(double inPhysical) {
+        double raw = (inPhysical - (double)Offset::num / Offset::den) * Scale::den / Scale::num;
+        raw = raw < 0 ? raw - 0.5 : raw + 0.5;
+        if (!(raw > (double)minimumRaw)) {
+            return minimumRaw;
+        }
+        if (raw >= (double)maximumRaw) {
+            return maximumRaw;
+        }
+        return (RawType)raw;
+    }
+};
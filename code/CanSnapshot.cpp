@@ -0,0 +1,47 @@
+#include "CanSnapshot.h"
+#include <string.h>
+
+CanSnapshot::CanSnapshot() {
+    Publish(CanCoder());
+    _sequence.store(0, std::memory_order_relaxed);
+}
+
+void CanSnapshot::Publish(const CanCoder& inCoder) {
+    uint64_t words[wordCount] = {};
+    memcpy(words, &inCoder, sizeof(CanCoder));
+
+    uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    // Readers that see any of the new words also see the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t index = 0; index < wordCount; index++) {
+        _words[index].store(words[index], std::memory_order_relaxed);
+    }
+    _sequence.store(sequence + 2, std::memory_order_release);
+}
+
+uint64_t CanSnapshot::Read(CanCoder& outCoder) const {
+    uint64_t version;
+    while (!TryRead(outCoder, version)) {
+    }
+    return version;
+}
+
+bool CanSnapshot::TryRead(CanCoder& outCoder, uint64_t& outVersion) const {
+    uint64_t sequence = _sequence.load(std::memory_order_acquire);
+    if (sequence % 2 != 0) {
+        return false;
+    }
+    uint64_t words[wordCount];
+    for (size_t index = 0; index < wordCount; index++) {
+        words[index] = _words[index].load(std::memory_order_relaxed);
+    }
+    // The words must be read before the sequence is checked again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_sequence.load(std::memory_order_relaxed) != sequence) {
+        return false;
+    }
+    memcpy(&outCoder, words, sizeof(CanCoder));
+    outVersion = sequence / 2;
+    return true;
+}
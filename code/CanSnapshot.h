@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanSnapshot
+ *
+ * Lock free publishing of the state of a CanCoder to other threads
+ *
+ * A CanCoder is written by the thread that decodes. Other threads, for example a user
+ * interface or telemetry, read a snapshot instead: the decoding thread publishes its
+ * CanCoder after decoding and readers copy the latest published state.
+ * The snapshot is a sequence lock. The writer never waits and never takes a mutex, readers
+ * never block the writer. A reader retries when its copy overlapped a publish, so it
+ * never sees a torn struct. All data is accessed through atomic words, so there is no
+ * data race even while retrying.
+ *
+ * There must be only one writer, any number of readers is allowed.
+ *
+ * For example:
+ *     // Decoding thread
+ *     coder.Decode(identifier, dataLengthCode, data);
+ *     snapshot.Publish(coder);
+ *
+ *     // Other thread
+ *     CanCoder state;
+ *     snapshot.Read(state);
+ *     int speed = state._vehicleSpeed.speed;
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+
+class CanSnapshot {
+public:
+    CanSnapshot();
+    CanSnapshot(const CanSnapshot&) = delete;
+    CanSnapshot& operator=(const CanSnapshot&) = delete;
+
+    /// @brief Publish the state of a coder, only to be called by one thread
+    /// @param inCoder The coder
+    void Publish(const CanCoder& inCoder);
+    /// @brief Read the latest published state, retrying while a publish is in progress
+    /// @param outCoder Receives the state
+    /// @return The version of the state, it increases with every publish
+    uint64_t Read(CanCoder& outCoder) const;
+    /// @brief Read the latest published state without retrying
+    /// @param outCoder Receives the state, it is only valid on success
+    /// @param outVersion The version of the state
+    /// @return true on success, false when a publish was in progress
+    bool TryRead(CanCoder& outCoder, uint64_t& outVersion) const;
+    /// @brief Get the version of the latest published state
+    ///
+    /// A reader can compare it with the version of its last read to skip copying an unchanged state
+    uint64_t GetVersion() const { return _sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    static_assert(std::is_trivially_copyable<CanCoder>::value, "CanCoder is copied word by word");
+
+    static constexpr size_t wordCount = (sizeof(CanCoder) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // Odd while a publish is in progress, its own cache line keeps readers from disturbing the words
+    alignas(64) std::atomic<uint64_t> _sequence{ 0 };
+    alignas(64) std::atomic<uint64_t> _words[wordCount];
+};
@@ -0,0 +1,173 @@
+#include "CanSocket.h"
+
+#if defined(__linux__)
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+
+CanSocket::~CanSocket() {
+    Close();
+}
+
+bool CanSocket::Open(const char* inInterfaceName, bool inFilterIdentifiers) {
+    Close();
+    if (strlen(inInterfaceName) >= IFNAMSIZ) {
+        return false;
+    }
+    int fileDescriptor = socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    sockaddr_can address = {};
+    address.can_family = AF_CAN;
+    address.can_ifindex = (int)if_nametoindex(inInterfaceName);
+    if (address.can_ifindex == 0) {
+        close(fileDescriptor);
+        return false;
+    }
+    _fileDescriptor = fileDescriptor;
+    // The filter is set before binding, so no unfiltered frames are queued
+    SetUpSocket(inFilterIdentifiers);
+    if (bind(fileDescriptor, (sockaddr*)&address, sizeof(address)) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool CanSocket::Attach(int inFileDescriptor, bool inFilterIdentifiers) {
+    Close();
+    if (inFileDescriptor < 0) {
+        return false;
+    }
+    _fileDescriptor = inFileDescriptor;
+    SetUpSocket(inFilterIdentifiers);
+    return true;
+}
+
+void CanSocket::Close() {
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+}
+
+void CanSocket::SetUpSocket(bool inFilterIdentifiers) {
+    // Failures are ignored, sockets other than CAN sockets do not support these options
+    // Without a kernel filter Receive filters the identifiers itself
+    _filterIdentifiers = false;
+    if (inFilterIdentifiers) {
+        CanCoder::Identifier identifiers[CAN_RAW_FILTER_MAX];
+        size_t identifierCount = CanCoder::GetIdentifiers(identifiers, CAN_RAW_FILTER_MAX);
+        can_filter filters[CAN_RAW_FILTER_MAX];
+        for (size_t index = 0; index < identifierCount && index < CAN_RAW_FILTER_MAX; index++) {
+            // Only standard data frames with exactly this identifier pass
+            filters[index].can_id = (canid_t)identifiers[index];
+            filters[index].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        }
+        _filterIdentifiers = setsockopt(_fileDescriptor, SOL_CAN_RAW, CAN_RAW_FILTER, filters, (socklen_t)(identifierCount * sizeof(can_filter))) != 0;
+    }
+    int timestamping = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    setsockopt(_fileDescriptor, SOL_SOCKET, SO_TIMESTAMPING, &timestamping, sizeof(timestamping));
+
+    for (size_t index = 0; index < maximumBatchSize; index++) {
+        _vectors[index] = { &_canFrames[index], sizeof(can_frame) };
+    }
+}
+
+size_t CanSocket::Receive(CanCoder::Frame* outFrames, size_t inMaximumFrameCount, bool inWait) {
+    if (_fileDescriptor < 0 || inMaximumFrameCount == 0) {
+        return 0;
+    }
+    unsigned int messageCount = (unsigned int)(inMaximumFrameCount < maximumBatchSize ? inMaximumFrameCount : maximumBatchSize);
+    for (unsigned int index = 0; index < messageCount; index++) {
+        msghdr& message = _messages[index].msg_hdr;
+        message = {};
+        message.msg_iov = &_vectors[index];
+        message.msg_iovlen = 1;
+        message.msg_control = _controls[index];
+        message.msg_controllen = sizeof(_controls[index]);
+    }
+    int receivedCount = recvmmsg(_fileDescriptor, _messages, messageCount, inWait ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr);
+    if (receivedCount <= 0) {
+        return 0;
+    }
+
+    size_t frameCount = 0;
+    for (int index = 0; index < receivedCount; index++) {
+        const can_frame& canFrame = _canFrames[index];
+        if (_messages[index].msg_len < sizeof(can_frame) || (canFrame.can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0 || canFrame.len > 8) {
+            continue;
+        }
+        if (_filterIdentifiers &&
+            ((canFrame.can_id & CAN_EFF_FLAG) != 0 || !CanCoder::IsDecodable((CanCoder::Identifier)(canFrame.can_id & CAN_SFF_MASK)))) {
+            continue;
+        }
+        CanCoder::Frame& frame = outFrames[frameCount++];
+        if ((canFrame.can_id & CAN_EFF_FLAG) != 0) {
+            frame.identifier = (canFrame.can_id & CAN_EFF_MASK) | CanCoder::extendedIdentifierFlag;
+        }
+        else {
+            frame.identifier = canFrame.can_id & CAN_SFF_MASK;
+        }
+        frame.dataLengthCode = canFrame.len;
+        memcpy(frame.data, canFrame.data, sizeof(frame.data));
+        frame.timestamp = GetTimestamp(_messages[index].msg_hdr);
+    }
+    return frameCount;
+}
+
+size_t CanSocket::Send(const CanCoder::Frame* inFrames, size_t inFrameCount) {
+    if (_fileDescriptor < 0) {
+        return 0;
+    }
+    size_t sentCount = 0;
+    while (sentCount < inFrameCount) {
+        unsigned int messageCount = (unsigned int)(inFrameCount - sentCount < maximumBatchSize ? inFrameCount - sentCount : maximumBatchSize);
+        for (unsigned int index = 0; index < messageCount; index++) {
+            const CanCoder::Frame& frame = inFrames[sentCount + index];
+            can_frame& canFrame = _canFrames[index];
+            canFrame = {};
+            if ((frame.identifier & CanCoder::extendedIdentifierFlag) != 0) {
+                canFrame.can_id = (frame.identifier & CAN_EFF_MASK) | CAN_EFF_FLAG;
+            }
+            else {
+                canFrame.can_id = frame.identifier & CAN_SFF_MASK;
+            }
+            canFrame.len = frame.dataLengthCode > 8 ? 8 : frame.dataLengthCode;
+            memcpy(canFrame.data, frame.data, canFrame.len);
+            msghdr& message = _messages[index].msg_hdr;
+            message = {};
+            message.msg_iov = &_vectors[index];
+            message.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(_fileDescriptor, _messages, messageCount, 0);
+        if (sent <= 0) {
+            break;
+        }
+        sentCount += (size_t)sent;
+    }
+    return sentCount;
+}
+
+uint64_t CanSocket::GetTimestamp(const msghdr& inMessage) {
+    for (cmsghdr* control = CMSG_FIRSTHDR(&inMessage); control != nullptr; control = CMSG_NXTHDR((msghdr*)&inMessage, control)) {
+        if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_TIMESTAMPING) {
+            // Index 0 is the software timestamp, index 2 the raw hardware timestamp
+            timespec timestamps[3];
+            memcpy(timestamps, CMSG_DATA(control), sizeof(timestamps));
+            const timespec& timestamp = timestamps[2].tv_sec != 0 || timestamps[2].tv_nsec != 0 ? timestamps[2] : timestamps[0];
+            return (uint64_t)timestamp.tv_sec * 1000000 + (uint64_t)timestamp.tv_nsec / 1000;
+        }
+    }
+    // No timestamp from the kernel, for example with a socketpair
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanSocket
+ *
+ * Linux SocketCAN transport for CanCoder
+ *
+ * A raw CAN socket is bound to an interface, for example can0 or a vcan interface for
+ * testing. Frames are received and sent in batches with recvmmsg and sendmmsg, so one
+ * system call handles up to maximumBatchSize frames. Received frames are
+ * CanCoder::Frame, ready for CanCoder::DecodeBatch.
+ * Frame timestamps are in microseconds, taken from the hardware when the interface
+ * supports it and from the kernel otherwise.
+ * By default a kernel filter passes only the identifiers supported by CanCoder, so
+ * other frames never reach user space. Sockets without kernel filters are filtered
+ * when receiving.
+ * Extended identifiers are marked by bit 31 (CanCoder::extendedIdentifierFlag), remote frames and
+ * error frames are skipped.
+ *
+ * Instead of opening an interface, an existing socket can be attached, for example one
+ * end of a socketpair exchanging struct can_frame messages in tests.
+ *
+ * For example:
+ *     CanSocket socket;
+ *     socket.Open("can0");
+ *     CanCoder::Frame frames[CanSocket::maximumBatchSize];
+ *     size_t frameCount = socket.Receive(frames, CanSocket::maximumBatchSize);
+ *     coder.DecodeBatch(frames, frameCount, nullptr);
+ *
+ * Only available on Linux.
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#pragma once
+
+#if defined(__linux__)
+
+#include "CanCoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/can.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+class CanSocket {
+public:
+    /// @brief Maximum number of frames received or sent with one system call
+    static constexpr size_t maximumBatchSize = 64;
+    CanSocket() = default;
+    CanSocket(const CanSocket&) = delete;
+    CanSocket& operator=(const CanSocket&) = delete;
+    ~CanSocket();
+
+    /// @brief Open a raw CAN socket on an interface
+    /// @param inInterfaceName Name of the interface, for example "can0" or "vcan0"
+    /// @param inFilterIdentifiers When true only the identifiers supported by CanCoder are received
+    /// @return true on success, false on failure
+    bool Open(const char* inInterfaceName, bool inFilterIdentifiers = true);
+    /// @brief Use an existing socket exchanging struct can_frame messages, it is closed by Close
+    ///
+    /// Filters and timestamps are set up when the socket supports them, when it does not support
+    /// filters the identifiers are filtered by Receive
+    /// @param inFileDescriptor The socket
+    /// @param inFilterIdentifiers When true only the identifiers supported by CanCoder are received
+    /// @return true on success, false on failure
+    bool Attach(int inFileDescriptor, bool inFilterIdentifiers = true);
+    /// @brief Close the socket
+    void Close();
+    /// @brief Get the file descriptor of the socket, for example to wait on it with poll
+    int GetFileDescriptor() const { return _fileDescriptor; }
+
+    /// @brief Receive frames, waiting for the first one
+    /// @param outFrames Receives the frames, must be able to hold inMaximumFrameCount frames
+    /// @param inMaximumFrameCount Maximum number of frames, at most maximumBatchSize are received
+    /// @param inWait When false, return immediately when no frame is available
+    /// @return The number of frames, 0 when none were available, all were filtered or on failure
+    size_t Receive(CanCoder::Frame* outFrames, size_t inMaximumFrameCount, bool inWait = true);
+    /// @brief Send frames
+    /// @param inFrames The frames
+    /// @param inFrameCount Number of frames
+    /// @return The number of frames sent
+    size_t Send(const CanCoder::Frame* inFrames, size_t inFrameCount);
+    /// @brief Send a frame
+    /// @param inFrame The frame
+    /// @return true on success, false on failure
+    bool Send(const CanCoder::Frame& inFrame) { return Send(&inFrame, 1) == 1; }
+
+private:
+    void SetUpSocket(bool inFilterIdentifiers);
+    static uint64_t GetTimestamp(const msghdr& inMessage);
+
+    int _fileDescriptor = -1;
+    // Set when identifiers must be filtered but the socket has no kernel filter
+    bool _filterIdentifiers = false;
+    // Buffers for recvmmsg and sendmmsg, allocated once
+    can_frame _canFrames[maximumBatchSize];
+    iovec _vectors[maximumBatchSize];
+    mmsghdr _messages[maximumBatchSize];
+    // Room for a struct scm_timestamping of 3 timespecs per frame
+    alignas(cmsghdr) uint8_t _controls[maximumBatchSize][CMSG_SPACE(3 * sizeof(timespec))];
+};
+
+#endif
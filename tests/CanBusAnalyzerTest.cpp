@@ -0,0 +1,142 @@
+// Unit test of CanBusAnalyzer
+//
+// Checks the bits on the wire of a frame worked out by hand and of pseudo random frames
+// against a bit by bit model of CAN 2.0 framing, and the bus load they add up to.
+
+#include "CanBusAnalyzer.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+namespace {
+    // Bit by bit model: the stuffed bits of the frame, from start of frame up to and including the CRC
+    std::vector<bool> GetStuffedBits(uint32_t identifier, uint8_t dataLengthCode, const uint8_t* data) {
+        std::vector<bool> bits;
+        auto add = [&bits](uint32_t value, unsigned bitCount) {
+            for (unsigned bit = bitCount; bit-- > 0;) {
+                bits.push_back((value >> bit) & 1);
+            }
+        };
+        add(0, 1);
+        if ((identifier & CanCoder::extendedIdentifierFlag) != 0) {
+            add((identifier >> 18) & 0x7ff, 11);
+            // Substitute remote request and identifier extension
+            add(1, 1);
+            add(1, 1);
+            add(identifier & 0x3ffff, 18);
+            // Remote transmission request, r1 and r0
+            add(0, 3);
+        }
+        else {
+            add(identifier, 11);
+            // Remote transmission request, identifier extension and r0
+            add(0, 3);
+        }
+        add(dataLengthCode, 4);
+        for (uint8_t index = 0; index < dataLengthCode; index++) {
+            add(data[index], 8);
+        }
+        // CRC-15 with polynomial 0x4599
+        uint32_t crc = 0;
+        for (bool bit : bits) {
+            bool next = bit ^ ((crc >> 14) & 1);
+            crc = (crc << 1) & 0x7fff;
+            if (next) {
+                crc ^= 0x4599;
+            }
+        }
+        add(crc, 15);
+        return bits;
+    }
+
+    uint32_t CountStuffBits(const std::vector<bool>& bits) {
+        uint32_t stuffBitCount = 0;
+        bool last = bits[0];
+        unsigned equalCount = 0;
+        for (bool bit : bits) {
+            equalCount = bit == last ? equalCount + 1 : 1;
+            last = bit;
+            if (equalCount == 5) {
+                // The stuff bit has the opposite value and starts the next run
+                stuffBitCount++;
+                last = !bit;
+                equalCount = 1;
+            }
+        }
+        return stuffBitCount;
+    }
+
+    void TestKnownFrame() {
+        // Identifier 0 without data: 34 dominant bits up to and including the CRC, which is 0,
+        // get a stuff bit after every 5, then 13 bits of delimiters, acknowledge, end of frame
+        // and interframe space follow
+        uint8_t data[8] = {};
+        uint32_t stuffBitCount;
+        CANTEST_CHECK_EQUAL(CanBusAnalyzer::GetFrameBitCount(0, 0, data, stuffBitCount), 53u);
+        CANTEST_CHECK_EQUAL(stuffBitCount, 6u);
+        CANTEST_CHECK_EQUAL(CountStuffBits(GetStuffedBits(0, 0, data)), 6u);
+    }
+
+    void TestModel() {
+        uint32_t seed = 1;
+        auto random = [&seed]() {
+            seed = seed * 1103515245 + 12345;
+            return seed >> 8;
+        };
+        for (int frame = 0; frame < 20000; frame++) {
+            bool extended = frame % 3 == 0;
+            uint32_t identifier = extended ? (random() & 0x1fffffff) | CanCoder::extendedIdentifierFlag : random() & 0x7ff;
+            uint8_t dataLengthCode = (uint8_t)(random() % 9);
+            uint8_t data[8];
+            // Runs of equal bits are common on a real bus, so half of the frames have bytes of 0x00 and 0xff
+            for (uint8_t& byte : data) {
+                byte = frame % 2 == 0 ? (uint8_t)random() : (random() & 1 ? 0xff : 0x00);
+            }
+            std::vector<bool> bits = GetStuffedBits(identifier, dataLengthCode, data);
+            uint32_t expectedStuffBitCount = CountStuffBits(bits);
+            uint32_t stuffBitCount;
+            uint32_t bitCount = CanBusAnalyzer::GetFrameBitCount(identifier, dataLengthCode, data, stuffBitCount);
+            CANTEST_CHECK_EQUAL(stuffBitCount, expectedStuffBitCount);
+            CANTEST_CHECK_EQUAL(bitCount, (uint32_t)bits.size() + expectedStuffBitCount + 13);
+        }
+        // Data of more than 8 bytes counts as 8
+        uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        uint32_t stuffBitCount;
+        uint32_t eightByteCount = CanBusAnalyzer::GetFrameBitCount(0x123, 8, data, stuffBitCount);
+        CANTEST_CHECK_EQUAL(CanBusAnalyzer::GetFrameBitCount(0x123, 15, data, stuffBitCount), eightByteCount);
+    }
+
+    void TestBusLoad() {
+        auto analyzer = std::make_unique<CanBusAnalyzer>(500000);
+        uint64_t bitCount = 0;
+        for (uint64_t index = 0; index < 100; index++) {
+            CanCoder::Frame frame = {};
+            frame.identifier = 0x1B4;
+            frame.dataLengthCode = 2;
+            frame.data[0] = (uint8_t)index;
+            frame.timestamp = 1000 + index * 1000;
+            analyzer->Add(frame);
+            uint32_t stuffBitCount;
+            bitCount += CanBusAnalyzer::GetFrameBitCount(frame.identifier, frame.dataLengthCode, frame.data, stuffBitCount);
+        }
+        CanBusAnalyzer::BusStatistics bus = analyzer->GetBusStatistics();
+        CANTEST_CHECK_EQUAL(bus.frameCount, 100u);
+        CANTEST_CHECK_EQUAL(bus.bitCount, bitCount);
+        // 99 ms between the first and the last frame at 500 kbit/s
+        double expectedLoad = (double)bitCount / (0.099 * 500000);
+        CANTEST_CHECK(bus.load > expectedLoad * 0.999 && bus.load < expectedLoad * 1.001);
+        CanBusAnalyzer::IdentifierStatistics speed;
+        CANTEST_CHECK(analyzer->GetStatistics(0x1B4, speed));
+        CANTEST_CHECK_EQUAL(speed.bitCount, bitCount);
+        CANTEST_CHECK_EQUAL(speed.minimumInterval, 1000u);
+        CANTEST_CHECK_EQUAL(speed.maximumInterval, 1000u);
+    }
+}
+
+int main() {
+    TestKnownFrame();
+    TestModel();
+    TestBusLoad();
+    return CanTestResult();
+}
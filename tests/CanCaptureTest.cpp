@@ -0,0 +1,151 @@
+// Unit test of CanCaptureWriter and CanCaptureReader
+//
+// Writes a capture and reads it back, then checks that truncated and corrupt captures
+// are rejected by Open.
+
+#include "CanCapture.h"
+#include "CanTest.h"
+#include <string.h>
+#include <vector>
+
+namespace {
+    // Positions of the trailer fields relative to the end of the file
+    constexpr size_t trailerSize = 48;
+    constexpr size_t blockCountPosition = 8;
+    constexpr size_t identifierTablePositionPosition = 16;
+    constexpr size_t identifierCountPosition = 24;
+
+    std::vector<CanCoder::Frame> CreateFrames() {
+        std::vector<CanCoder::Frame> frames;
+        for (uint32_t index = 0; index < 10000; index++) {
+            CanCoder::Frame frame = {};
+            frame.identifier = index % 3 == 0 ? 0x1B4 : 0x130;
+            frame.dataLengthCode = (uint8_t)(index % 9);
+            memcpy(frame.data, &index, sizeof(index));
+            // Jumps larger than 28 bits of microseconds start a new block
+            frame.timestamp = 1000000000000ull + index * 1000ull + (index >= 5000 ? (1ull << 30) : 0);
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    bool WriteCapture(const CanTest::TemporaryFile& inFile, const std::vector<CanCoder::Frame>& inFrames) {
+        CanCaptureWriter writer;
+        return writer.Open(inFile.GetPath()) && writer.Write(inFrames.data(), inFrames.size()) && writer.Close();
+    }
+
+    std::vector<uint8_t> ReadFile(const CanTest::TemporaryFile& inFile) {
+        std::vector<uint8_t> contents;
+        FILE* file = fopen(inFile.GetPath(), "rb");
+        if (file != nullptr) {
+            uint8_t buffer[4096];
+            size_t size;
+            while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                contents.insert(contents.end(), buffer, buffer + size);
+            }
+            fclose(file);
+        }
+        return contents;
+    }
+
+    uint64_t ReadTrailerField(const std::vector<uint8_t>& inContents, size_t inPosition) {
+        uint64_t value;
+        memcpy(&value, &inContents[inContents.size() - trailerSize + inPosition], sizeof(value));
+        return value;
+    }
+
+    void WriteTrailerField(std::vector<uint8_t>& inContents, size_t inPosition, uint64_t inValue) {
+        memcpy(&inContents[inContents.size() - trailerSize + inPosition], &inValue, sizeof(inValue));
+    }
+
+    bool OpenContents(const std::vector<uint8_t>& inContents) {
+        CanTest::TemporaryFile file;
+        CanCaptureReader reader;
+        return file.Write(inContents.data(), inContents.size()) && reader.Open(file.GetPath());
+    }
+
+    void TestRoundTrip() {
+        std::vector<CanCoder::Frame> frames = CreateFrames();
+        CanTest::TemporaryFile file;
+        CANTEST_CHECK(WriteCapture(file, frames));
+        CanCaptureReader reader;
+        CANTEST_CHECK(reader.Open(file.GetPath()));
+        CANTEST_CHECK_EQUAL(reader.GetFrameCount(), frames.size());
+        size_t frameNumber = 0;
+        bool same = true;
+        reader.ForEachFrame([&](const CanCoder::Frame& frame) {
+            const CanCoder::Frame& expected = frames[frameNumber++];
+            same = same && frame.identifier == expected.identifier && frame.dataLengthCode == expected.dataLengthCode &&
+                frame.timestamp == expected.timestamp && memcmp(frame.data, expected.data, sizeof(frame.data)) == 0;
+        });
+        CANTEST_CHECK(same);
+        CANTEST_CHECK_EQUAL(frameNumber, frames.size());
+
+        std::vector<CanCaptureReader::IdentifierInfo> identifiers = reader.GetIdentifiers();
+        CANTEST_CHECK_EQUAL(identifiers.size(), 2u);
+        if (identifiers.size() == 2) {
+            CANTEST_CHECK_EQUAL(identifiers[0].identifier, 0x130u);
+            CANTEST_CHECK_EQUAL(identifiers[1].identifier, 0x1B4u);
+            CANTEST_CHECK_EQUAL(identifiers[1].frameCount, 3334u);
+            CANTEST_CHECK_EQUAL(identifiers[1].firstTimestamp, frames[0].timestamp);
+            CANTEST_CHECK_EQUAL(identifiers[1].lastTimestamp, frames[9999].timestamp);
+        }
+
+        // Frames 5001-5999 of 0x1B4 in a window after the jump in time
+        uint64_t begin = frames[5001].timestamp;
+        uint64_t end = frames[5999].timestamp;
+        size_t windowCount = reader.ForEachFrame(0x1B4, begin, end, [&](const CanCoder::Frame& frame) {
+            CANTEST_CHECK(frame.identifier == 0x1B4 && frame.timestamp >= begin && frame.timestamp <= end);
+        });
+        CANTEST_CHECK_EQUAL(windowCount, 333u);
+        CANTEST_CHECK_EQUAL(reader.ForEachFrame(0x2FC, 0, UINT64_MAX, [](const CanCoder::Frame&) {}), 0u);
+    }
+
+    void TestInvalidCaptures() {
+        CanTest::TemporaryFile file;
+        CANTEST_CHECK(WriteCapture(file, CreateFrames()));
+        const std::vector<uint8_t> contents = ReadFile(file);
+        CANTEST_CHECK(OpenContents(contents));
+
+        // Truncated
+        std::vector<uint8_t> truncated(contents.begin(), contents.end() - 1);
+        CANTEST_CHECK(!OpenContents(truncated));
+        truncated.assign(contents.begin(), contents.begin() + 16);
+        CANTEST_CHECK(!OpenContents(truncated));
+
+        // Records without blocks
+        std::vector<uint8_t> corrupt = contents;
+        uint64_t blockCount = ReadTrailerField(corrupt, blockCountPosition);
+        uint64_t identifierTablePosition = ReadTrailerField(corrupt, identifierTablePositionPosition);
+        WriteTrailerField(corrupt, blockCountPosition, 0);
+        WriteTrailerField(corrupt, identifierTablePositionPosition, identifierTablePosition - blockCount * 16);
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // Counts whose table size overflows, 2^60 blocks of 16 bytes wrap around to 0 bytes
+        corrupt = contents;
+        WriteTrailerField(corrupt, blockCountPosition, 1ull << 60);
+        WriteTrailerField(corrupt, identifierTablePositionPosition, ReadTrailerField(contents, 0));
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteTrailerField(corrupt, identifierCountPosition, (1ull << 59) + 1);
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // A record number beyond the records, the record numbers are just before the trailer
+        corrupt = contents;
+        uint32_t recordNumber = 10000;
+        memcpy(&corrupt[corrupt.size() - trailerSize - sizeof(recordNumber)], &recordNumber, sizeof(recordNumber));
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // The first block does not start at record 0
+        corrupt = contents;
+        uint64_t firstRecord = 1;
+        memcpy(&corrupt[ReadTrailerField(contents, 0) + 8], &firstRecord, sizeof(firstRecord));
+        CANTEST_CHECK(!OpenContents(corrupt));
+    }
+}
+
+int main() {
+    TestRoundTrip();
+    TestInvalidCaptures();
+    return CanTestResult();
+}
@@ -0,0 +1,92 @@
+// Unit test of CanChannelPool
+//
+// Feeds every channel from its own thread into small queues while the workers decode
+// and steal, and checks that no frame is lost or decoded twice and that every channel
+// ends with the state of its last frame.
+
+#include "CanChannelPool.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t channelCount = 5;
+    constexpr uint64_t frameCount = 50000;
+
+    // The sequence number of a frame is its timestamp and the speed it carries
+    CanCoder::Frame CreateFrame(uint64_t inSequenceNumber) {
+        CanCoder::Frame frame = {};
+        frame.identifier = (uint32_t)CanCoder::Identifier::vehicleSpeed;
+        frame.dataLengthCode = 2;
+        frame.data[0] = (uint8_t)inSequenceNumber;
+        frame.data[1] = (uint8_t)(inSequenceNumber >> 8);
+        frame.timestamp = inSequenceNumber;
+        return frame;
+    }
+
+    void TestThreads() {
+        // Small queues, so the producers regularly find them full
+        CanChannelPool<16> pool(channelCount);
+        CANTEST_CHECK(pool.Start(3));
+        CANTEST_CHECK(!pool.Start(3));
+
+        // Frames that were dropped are pushed again, so every channel gets all its frames
+        std::vector<uint64_t> pushedCounts(channelCount, 0);
+        std::vector<std::thread> producers;
+        for (size_t channel = 0; channel < channelCount; channel++) {
+            producers.emplace_back([&pool, &pushedCounts, channel] {
+                // Channels are fed at different speeds, so the workers steal from each other
+                for (uint64_t sequenceNumber = 0; sequenceNumber < frameCount / (channel + 1); ) {
+                    if (pool.Push(channel, CreateFrame(sequenceNumber))) {
+                        sequenceNumber++;
+                        pushedCounts[channel]++;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+
+        // Wait until the workers decoded everything
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        bool done = false;
+        while (!done && std::chrono::steady_clock::now() < deadline) {
+            done = true;
+            for (size_t channel = 0; channel < channelCount; channel++) {
+                done = done && pool.GetStatistics(channel).frameCount == pushedCounts[channel];
+            }
+            std::this_thread::yield();
+        }
+        pool.Stop();
+
+        for (size_t channel = 0; channel < channelCount; channel++) {
+            CanChannelPool<16>::ChannelStatistics statistics = pool.GetStatistics(channel);
+            CANTEST_CHECK_EQUAL(pushedCounts[channel], frameCount / (channel + 1));
+            CANTEST_CHECK_EQUAL(statistics.frameCount, pushedCounts[channel]);
+            CANTEST_CHECK_EQUAL(statistics.decodedCount, pushedCounts[channel]);
+
+            // The state is that of the last frame, the frames of a channel are decoded in order
+            CanCoder expected;
+            CanCoder::Frame lastFrame = CreateFrame(pushedCounts[channel] - 1);
+            CANTEST_CHECK(expected.Decode(lastFrame.identifier, lastFrame.dataLengthCode, lastFrame.data));
+            CanCoder state;
+            CANTEST_CHECK(pool.Read(channel, state) != 0);
+            CANTEST_CHECK_EQUAL(state._vehicleSpeed.speed, expected._vehicleSpeed.speed);
+        }
+        pool.ForEachChannel([](size_t channel, const CanCoder& state) {
+            CANTEST_CHECK(channel < channelCount);
+            CANTEST_CHECK(state._identifier == CanCoder::Identifier::vehicleSpeed);
+        });
+    }
+}
+
+int main() {
+    TestThreads();
+    return CanTestResult();
+}
@@ -0,0 +1,385 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * CanCoderDifferential
+ *
+ * Differential testing of a CanCoder engine against the frozen reference
+ *
+ * The encode paths depend on state kept between calls: the additional data of the
+ * last decode, the counter of the gear shifter position, the clamping of the data
+ * length code and setDateTime sharing the struct of dateTime. An optimization can
+ * change these bytes without any visible failure. CanCoderDifferential applies every
+ * operation to both CanCoderReference and the engine under test and compares the
+ * results byte for byte. The first divergence is kept with the frame number, the
+ * operation, the identifier and the position of the first differing byte.
+ *
+ * The engine under test is a template parameter, any class with the interface of
+ * CanCoder (Decode, DecodeBatch, DecodeChanges, ResetChanges, Encode, ToString,
+ * RawMessageToString, GetFields and the message structs) can be compared, for example a new optimized
+ * engine next to CanCoder.
+ * The reference only has the original Decode, Encode and ToString. The other functions
+ * of the engine are compared against the same sequence of those: DecodeBatch against
+ * Decode of each frame, Decode and Encode of a span against Decode and Encode of a data
+ * length code, DecodeChanges against Decode plus the fields that differ afterwards, and
+ * the ToString functions writing a buffer or a string against the returned string.
+ *
+ * For example:
+ *     CanCoderDifferential<CanCoder> differential;
+ *     for (const CanCoder::Frame& frame : frames) {
+ *         if (!differential.Decode(frame.identifier, frame.dataLengthCode, frame.data)) {
+ *             puts(differential.GetDivergence().c_str());
+ *         }
+ *     }
+ *
+ *
+ * File history:
+ * Version 1: initial
+ * Version 2: DecodeBatch, DecodeChanges, Decode and Encode of a span and the ToString buffer functions
+ *
+ */
+
+#pragma once
+
+#include "reference/CanCoderReference.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <span>
+#include <string>
+
+template <typename Engine>
+class CanCoderDifferential {
+public:
+    /// @brief Identifiers of the supported messages
+    static constexpr uint32_t identifiers[] = {
+        0x0E2, 0x0E6, 0x0EA, 0x0EE, 0x0F6, 0x130, 0x1B4, 0x1B8, 0x1D2,
+        0x23A, 0x26E, 0x2A0, 0x2F8, 0x2FA, 0x2FC, 0x34F, 0x39E
+    };
+
+    /// @brief Decode a message with both engines
+    /// @param inIdentifier CAN message identifier
+    /// @param inDataLengthCode CAN message data length code, also values above 8
+    /// @param inData CAN message data, 8 bytes
+    /// @return true when both engines agree, false on the first divergence
+    bool Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData) {
+        _operationCount++;
+        // Each engine gets its own copy, padded for data length codes above 8
+        uint8_t referenceData[64] = {};
+        uint8_t engineData[64] = {};
+        memcpy(referenceData, inData, 8);
+        memcpy(engineData, inData, 8);
+        bool referenceDecoded = _reference.Decode(inIdentifier, inDataLengthCode, referenceData);
+        bool engineDecoded = _engine.Decode(inIdentifier, inDataLengthCode, engineData);
+        if (referenceDecoded != engineDecoded) {
+            return CompareBytes("Decode result", inIdentifier, (const uint8_t*)&referenceDecoded, (const uint8_t*)&engineDecoded, sizeof(bool));
+        }
+        return !referenceDecoded || CompareString(inIdentifier);
+    }
+
+    /// @brief Decode a message given as a span with the engine, and with its data length code with the reference
+    /// @param inIdentifier CAN message identifier
+    /// @param inLength Length of the data in bytes, 0-8
+    /// @param inData CAN message data, 8 bytes
+    /// @return true when both engines agree, false on the first divergence
+    bool DecodeSpan(uint32_t inIdentifier, uint8_t inLength, const uint8_t* inData) {
+        _operationCount++;
+        uint8_t referenceData[64] = {};
+        uint8_t engineData[8];
+        memcpy(referenceData, inData, 8);
+        memcpy(engineData, inData, 8);
+        bool referenceDecoded = _reference.Decode(inIdentifier, inLength, referenceData);
+        bool engineDecoded = _engine.Decode(inIdentifier, std::span<const uint8_t>(engineData, inLength));
+        if (referenceDecoded != engineDecoded) {
+            return CompareBytes("Decode span result", inIdentifier, (const uint8_t*)&referenceDecoded, (const uint8_t*)&engineDecoded, sizeof(bool));
+        }
+        return !referenceDecoded || CompareString(inIdentifier);
+    }
+
+    /// @brief Decode messages with DecodeBatch of the engine and one by one with the reference
+    /// @param inFrames CAN messages, data length codes above 8 included
+    /// @param inFrameCount Number of CAN messages, at most 256
+    /// @return true when both engines agree, false on the first divergence
+    bool DecodeBatch(const typename Engine::Frame* inFrames, size_t inFrameCount) {
+        _operationCount++;
+        uint32_t referenceResults[8] = {};
+        uint32_t engineResults[8] = {};
+        size_t referenceCount = 0;
+        for (size_t index = 0; index < inFrameCount; index++) {
+            uint8_t data[64] = {};
+            memcpy(data, inFrames[index].data, 8);
+            if (_reference.Decode(inFrames[index].identifier, inFrames[index].dataLengthCode, data)) {
+                referenceResults[index / 32] |= 1u << (index % 32);
+                referenceCount++;
+            }
+        }
+        size_t engineCount = _engine.DecodeBatch(inFrames, inFrameCount, engineResults);
+        uint32_t lastIdentifier = inFrameCount > 0 ? inFrames[inFrameCount - 1].identifier : 0;
+        if (!CompareBytes("DecodeBatch results", lastIdentifier, (const uint8_t*)referenceResults, (const uint8_t*)engineResults, (inFrameCount + 7) / 8)) {
+            return false;
+        }
+        if (referenceCount != engineCount) {
+            return CompareBytes("DecodeBatch count", lastIdentifier, (const uint8_t*)&referenceCount, (const uint8_t*)&engineCount, sizeof(size_t));
+        }
+        uint32_t referenceIdentifier = (uint32_t)_reference._identifier;
+        uint32_t engineIdentifier = (uint32_t)_engine._identifier;
+        if (referenceIdentifier != engineIdentifier) {
+            return CompareBytes("DecodeBatch identifier", lastIdentifier, (const uint8_t*)&referenceIdentifier, (const uint8_t*)&engineIdentifier, sizeof(uint32_t));
+        }
+        return CompareState();
+    }
+
+    /// @brief Decode a message with DecodeChanges of the engine and Decode of the reference
+    ///
+    /// Besides the state, the changed fields are compared with the fields that differ after decoding.
+    /// @param inIdentifier CAN message identifier
+    /// @param inDataLengthCode CAN message data length code, also values above 8
+    /// @param inData CAN message data, 8 bytes
+    /// @return true when both engines agree, false on the first divergence
+    bool DecodeChanges(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData) {
+        _operationCount++;
+        uint8_t referenceData[64] = {};
+        uint8_t engineData[64] = {};
+        memcpy(referenceData, inData, 8);
+        memcpy(engineData, inData, 8);
+        Engine previous = _engine;
+        uint32_t changedFields;
+        bool referenceDecoded = _reference.Decode(inIdentifier, inDataLengthCode, referenceData);
+        bool engineDecoded = _engine.DecodeChanges(inIdentifier, inDataLengthCode, engineData, changedFields);
+        if (referenceDecoded != engineDecoded) {
+            return CompareBytes("DecodeChanges result", inIdentifier, (const uint8_t*)&referenceDecoded, (const uint8_t*)&engineDecoded, sizeof(bool));
+        }
+        uint32_t expectedFields = 0;
+        if (engineDecoded) {
+            const typename Engine::Field* fields;
+            size_t fieldCount = Engine::GetFields(_engine._identifier, fields);
+            for (size_t index = 0; index < fieldCount; index++) {
+                if (previous.GetFieldValue(fields[index]) != _engine.GetFieldValue(fields[index])) {
+                    expectedFields |= 1u << index;
+                }
+            }
+        }
+        if (!CompareBytes("DecodeChanges fields", inIdentifier, (const uint8_t*)&expectedFields, (const uint8_t*)&changedFields, sizeof(uint32_t))) {
+            return false;
+        }
+        return !referenceDecoded || CompareString(inIdentifier);
+    }
+
+    /// @brief Encode a message with both engines, changing their state
+    /// @param inIdentifier CAN message identifier, also unsupported identifiers
+    /// @return true when both engines agree, false on the first divergence
+    bool Encode(uint32_t inIdentifier) {
+        _operationCount++;
+        return EncodeWith(_reference, _engine, inIdentifier);
+    }
+
+    /// @brief Encode a message into a span with the engine and with a data length code with the reference
+    ///
+    /// When the message does not fit the span neither engine changes its state.
+    /// @param inIdentifier CAN message identifier, also unsupported identifiers
+    /// @param inSize Size of the span, 0-8
+    /// @return true when both engines agree, false on the first divergence
+    bool EncodeSpan(uint32_t inIdentifier, size_t inSize) {
+        _operationCount++;
+        CanCoderReference reference = _reference;
+        reference._identifier = (CanCoderReference::Identifier)inIdentifier;
+        _engine._identifier = (decltype(_engine._identifier))inIdentifier;
+        uint32_t referenceIdentifier = 0;
+        uint32_t engineIdentifier = 0;
+        uint8_t referenceDataLengthCode = 0;
+        uint8_t referenceData[8] = {};
+        uint8_t engineData[8] = {};
+        reference.Encode(referenceIdentifier, referenceDataLengthCode, referenceData);
+        size_t engineLength = _engine.Encode(engineIdentifier, std::span<uint8_t>(engineData, inSize));
+        if (referenceIdentifier != engineIdentifier) {
+            return CompareBytes("Encode span identifier", inIdentifier, (const uint8_t*)&referenceIdentifier, (const uint8_t*)&engineIdentifier, sizeof(uint32_t));
+        }
+        // Unsupported messages leave the data length code zero, all supported messages have data
+        size_t referenceLength = referenceDataLengthCode <= inSize ? referenceDataLengthCode : 0;
+        if (referenceLength != engineLength) {
+            return CompareBytes("Encode span length", inIdentifier, (const uint8_t*)&referenceLength, (const uint8_t*)&engineLength, sizeof(size_t));
+        }
+        if (referenceLength == 0) {
+            _reference._identifier = reference._identifier;
+            return CompareState();
+        }
+        _reference = reference;
+        return CompareBytes("Encode span data", inIdentifier, referenceData, engineData, referenceLength);
+    }
+
+    /// @brief Compare the string of a message written to a buffer of a given size with the string of the reference
+    /// @param inIdentifier CAN message identifier
+    /// @param inBufferSize Size of the buffer, smaller sizes truncate the string
+    /// @return true when both engines agree, false on the first divergence
+    bool ToString(uint32_t inIdentifier, size_t inBufferSize) {
+        _operationCount++;
+        _reference._identifier = (CanCoderReference::Identifier)inIdentifier;
+        _engine._identifier = (decltype(_engine._identifier))inIdentifier;
+        std::string referenceString = _reference.ToString();
+        char buffer[Engine::stringBufferSize];
+        size_t bufferSize = inBufferSize < sizeof(buffer) ? inBufferSize : sizeof(buffer);
+        size_t engineLength = _engine.ToString(buffer, bufferSize);
+        size_t referenceLength = referenceString.size();
+        if (referenceLength != engineLength) {
+            return CompareBytes("ToString buffer length", inIdentifier, (const uint8_t*)&referenceLength, (const uint8_t*)&engineLength, sizeof(size_t));
+        }
+        if (bufferSize == 0) {
+            return true;
+        }
+        if (referenceString.size() >= bufferSize) {
+            referenceString.resize(bufferSize - 1);
+        }
+        return CompareStrings("ToString buffer", inIdentifier, referenceString, buffer);
+    }
+
+    /// @brief Set all decoded fields of both engines to the same pseudo random values, as done before an encode
+    ///
+    /// Like any code writing fields, this is followed by ResetChanges of the engine.
+    /// @param inSeed Seed of the values, values outside the range of the signals are included
+    void SetFields(uint64_t inSeed) {
+        _operationCount++;
+        SetFields(_reference, inSeed);
+        SetFields(_engine, inSeed);
+        _engine.ResetChanges();
+    }
+
+    /// @brief Compare the raw message strings of both engines
+    /// @return true when both engines agree, false on the first divergence
+    bool RawMessageToString(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData) {
+        _operationCount++;
+        uint8_t data[64] = {};
+        memcpy(data, inData, 8);
+        // The string of CAN messages shows at most 8 bytes
+        uint8_t dataLengthCode = inDataLengthCode > 8 ? 8 : inDataLengthCode;
+        std::string referenceString = CanCoderReference::RawMessageToString(inIdentifier, dataLengthCode, data);
+        std::string engineString = Engine::RawMessageToString(inIdentifier, dataLengthCode, data);
+        char buffer[Engine::stringBufferSize];
+        Engine::RawMessageToString(inIdentifier, dataLengthCode, data, buffer, sizeof(buffer));
+        return CompareStrings("RawMessageToString", inIdentifier, referenceString, engineString) &&
+            CompareStrings("RawMessageToString buffer", inIdentifier, referenceString, buffer);
+    }
+
+    /// @brief Compare the complete state of both engines
+    ///
+    /// The strings of all messages are compared, and every message is encoded by copies
+    /// of both engines, so the state of the engines is not changed.
+    /// @return true when both engines agree, false on the first divergence
+    bool CompareState() {
+        CanCoderReference::Identifier referenceIdentifier = _reference._identifier;
+        auto engineIdentifier = _engine._identifier;
+        bool same = true;
+        for (uint32_t identifier : identifiers) {
+            CanCoderReference reference = _reference;
+            Engine engine = _engine;
+            if (!CompareString(identifier) || !EncodeWith(reference, engine, identifier)) {
+                same = false;
+                break;
+            }
+        }
+        _reference._identifier = referenceIdentifier;
+        _engine._identifier = engineIdentifier;
+        return same;
+    }
+
+    /// @brief Get the description of the first divergence, empty when there was none
+    const std::string& GetDivergence() const { return _divergence; }
+    /// @brief Get the number of operations applied to both engines
+    uint64_t GetOperationCount() const { return _operationCount; }
+    /// @brief Get the engine under test
+    Engine& GetEngine() { return _engine; }
+    /// @brief Get the reference engine
+    CanCoderReference& GetReference() { return _reference; }
+
+private:
+    template <typename Coder>
+    static void SetFields(Coder& outCoder, uint64_t inSeed) {
+        uint64_t state = inSeed;
+        auto random = [&state]() {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return (uint32_t)(state >> 32);
+        };
+        outCoder._vehicleSpeed.speed = (int)(random() % 5000);
+        outCoder._iDriveController.dialValue = (unsigned short)random();
+        outCoder._gearShifterPosition.position = "PRNDSM?"[random() % 7];
+        outCoder._windowRoofAndMirrorControl.closeWindowsAndRoof = random() & 1;
+        outCoder._windowRoofAndMirrorControl.foldMirrors = random() & 1;
+        outCoder._doorLockControl.lockDoors = random() & 1;
+        outCoder._dateTime.year = (int)(random() % 70000);
+        outCoder._dateTime.month = (int)(random() % 20);
+        outCoder._dateTime.day = (int)(random() % 300);
+        outCoder._dateTime.hour = (int)(random() % 300);
+        outCoder._dateTime.minute = (int)(random() % 300);
+        outCoder._dateTime.second = (int)(random() % 300);
+    }
+
+    template <typename Reference, typename Other>
+    bool EncodeWith(Reference& inReference, Other& inEngine, uint32_t inIdentifier) {
+        inReference._identifier = (decltype(inReference._identifier))inIdentifier;
+        inEngine._identifier = (decltype(inEngine._identifier))inIdentifier;
+        uint32_t referenceIdentifier = 0;
+        uint32_t engineIdentifier = 0;
+        uint8_t referenceDataLengthCode = 0;
+        uint8_t engineDataLengthCode = 0;
+        uint8_t referenceData[8] = {};
+        uint8_t engineData[8] = {};
+        inReference.Encode(referenceIdentifier, referenceDataLengthCode, referenceData);
+        inEngine.Encode(engineIdentifier, engineDataLengthCode, engineData);
+        if (referenceIdentifier != engineIdentifier) {
+            return CompareBytes("Encode identifier", inIdentifier, (const uint8_t*)&referenceIdentifier, (const uint8_t*)&engineIdentifier, sizeof(uint32_t));
+        }
+        if (referenceDataLengthCode != engineDataLengthCode) {
+            return CompareBytes("Encode data length code", inIdentifier, &referenceDataLengthCode, &engineDataLengthCode, 1);
+        }
+        return CompareBytes("Encode data", inIdentifier, referenceData, engineData, referenceDataLengthCode > 8 ? 8 : referenceDataLengthCode);
+    }
+
+    bool CompareString(uint32_t inIdentifier) {
+        _reference._identifier = (CanCoderReference::Identifier)inIdentifier;
+        _engine._identifier = (decltype(_engine._identifier))inIdentifier;
+        std::string referenceString = _reference.ToString();
+        char buffer[Engine::stringBufferSize];
+        _engine.ToString(buffer, sizeof(buffer));
+        _engine.ToString(_string);
+        return CompareStrings("ToString", inIdentifier, referenceString, _engine.ToString()) &&
+            CompareStrings("ToString buffer", inIdentifier, referenceString, buffer) &&
+            CompareStrings("ToString string", inIdentifier, referenceString, _string);
+    }
+
+    bool CompareStrings(const char* inOperation, uint32_t inIdentifier, const std::string& inReferenceString, const std::string& inEngineString) {
+        if (inReferenceString == inEngineString) {
+            return true;
+        }
+        // The terminating zero makes a difference in length show up as a differing byte
+        return CompareBytes(inOperation, inIdentifier, (const uint8_t*)inReferenceString.c_str(), (const uint8_t*)inEngineString.c_str(),
+            (inReferenceString.size() < inEngineString.size() ? inReferenceString.size() : inEngineString.size()) + 1);
+    }
+
+    // Compare bytes, keeping the first divergence, true when the bytes are the same
+    bool CompareBytes(const char* inOperation, uint32_t inIdentifier, const uint8_t* inReferenceBytes, const uint8_t* inEngineBytes, size_t inSize) {
+        size_t position = 0;
+        while (position < inSize && inReferenceBytes[position] == inEngineBytes[position]) {
+            position++;
+        }
+        if (position == inSize) {
+            return true;
+        }
+        if (_divergence.empty()) {
+            char text[160];
+            snprintf(text, sizeof(text), "%s of identifier 0x%03X diverges at byte %zu: reference 0x%02X, engine 0x%02X (operation %llu)",
+                inOperation, (unsigned)inIdentifier, position, inReferenceBytes[position], inEngineBytes[position],
+                (unsigned long long)_operationCount);
+            _divergence = text;
+        }
+        return false;
+    }
+
+    CanCoderReference _reference;
+    Engine _engine;
+    uint64_t _operationCount = 0;
+    std::string _divergence;
+    // Reused by ToString(std::string&), as it would be in a logging loop
+    std::string _string;
+};
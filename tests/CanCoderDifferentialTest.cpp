@@ -0,0 +1,188 @@
+// Differential test of CanCoder against CanCoderReference
+//
+// Decodes generated bus traffic, pseudo random frames and replayed logs with both
+// engines, encodes every decoded message and compares the complete state regularly.
+// The engine decodes with Decode, DecodeChanges, Decode of a span and DecodeBatch, and
+// encodes with Encode and Encode of a span, chosen pseudo randomly.
+// Reports the first divergent byte and exits with 1 on a divergence.
+//     CanCoderDifferentialTest [--frames count] [--seed seed] [logs and captures]
+// Files ending in .cap are read as captures, other files as candump or ASC logs.
+
+#include "CanBusGenerator.h"
+#include "CanCapture.h"
+#include "CanCoder.h"
+#include "CanCoderDifferential.h"
+#include "CanLogReplay.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    // Interval in frames of the comparison of the complete state
+    constexpr uint64_t stateInterval = 4096;
+
+    class Runner {
+    public:
+        explicit Runner(uint64_t inSeed) : _state(inSeed) {}
+
+        // Decode a frame, encode the decoded message every few frames and compare the state regularly
+        bool Run(uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData) {
+            _frameCount++;
+            uint32_t random = Random();
+            bool same;
+            switch (random % 8) {
+            case 0:
+                same = _differential.DecodeChanges(inIdentifier, inDataLengthCode, inData);
+                break;
+            case 1:
+                same = _differential.DecodeSpan(inIdentifier, inDataLengthCode > 8 ? 8 : inDataLengthCode, inData);
+                break;
+            default:
+                same = _differential.Decode(inIdentifier, inDataLengthCode, inData);
+                break;
+            }
+            if (!same) {
+                return false;
+            }
+            if ((random >> 3) % 8 == 0) {
+                if ((random >> 6) % 8 == 0) {
+                    _differential.SetFields(Random());
+                }
+                // Spans of 0-8 bytes, so messages also do not fit
+                same = (random >> 9) % 2 == 0 ? _differential.Encode(inIdentifier) : _differential.EncodeSpan(inIdentifier, (random >> 10) % 9);
+                if (!same) {
+                    return false;
+                }
+            }
+            if ((random >> 14) % 64 == 0 && !_differential.ToString(inIdentifier, (random >> 20) % 64)) {
+                return false;
+            }
+            return _frameCount % stateInterval != 0 || _differential.CompareState();
+        }
+
+        // Decode frames in one batch
+        bool RunBatch(const CanCoder::Frame* inFrames, size_t inFrameCount) {
+            _frameCount += inFrameCount;
+            return _differential.DecodeBatch(inFrames, inFrameCount);
+        }
+
+        bool Finish() { return _differential.CompareState(); }
+
+        uint32_t Random() {
+            _state = _state * 6364136223846793005ull + 1442695040888963407ull;
+            return (uint32_t)(_state >> 32);
+        }
+
+        uint64_t GetFrameCount() const { return _frameCount; }
+        const std::string& GetDivergence() const { return _differential.GetDivergence(); }
+
+    private:
+        CanCoderDifferential<CanCoder> _differential;
+        uint64_t _state;
+        uint64_t _frameCount = 0;
+    };
+
+    bool EndsWith(const char* text, const char* suffix) {
+        size_t textLength = strlen(text);
+        size_t suffixLength = strlen(suffix);
+        return textLength >= suffixLength && strcmp(text + textLength - suffixLength, suffix) == 0;
+    }
+
+    bool RunGenerated(Runner& runner, uint64_t inSeed, size_t inFrameCount) {
+        CanBusGenerator generator(inSeed);
+        std::vector<CanCoder::Frame> frames(65536);
+        for (size_t frameNumber = 0; frameNumber < inFrameCount; frameNumber += frames.size()) {
+            generator.Generate(frames.data(), frames.size());
+            for (size_t index = 0; index < frames.size() && frameNumber + index < inFrameCount; index++) {
+                // One in 64 frames starts a batch of up to 100 frames
+                uint32_t batchRandom = runner.Random();
+                if (batchRandom % 64 == 0) {
+                    size_t batchSize = std::min<size_t>({ 1 + (batchRandom >> 6) % 100, frames.size() - index, inFrameCount - frameNumber - index });
+                    if (!runner.RunBatch(&frames[index], batchSize)) {
+                        return false;
+                    }
+                    index += batchSize - 1;
+                    continue;
+                }
+                const CanCoder::Frame& frame = frames[index];
+                if (!runner.Run(frame.identifier, frame.dataLengthCode, frame.data)) {
+                    return false;
+                }
+                // One in four frames is replaced by a random frame of a supported identifier
+                uint32_t random = runner.Random();
+                if (random % 4 == 0) {
+                    constexpr size_t identifierCount = sizeof(CanCoderDifferential<CanCoder>::identifiers) / sizeof(uint32_t);
+                    uint8_t data[8];
+                    for (uint8_t& byte : data) {
+                        byte = (uint8_t)runner.Random();
+                    }
+                    uint32_t identifier = CanCoderDifferential<CanCoder>::identifiers[(random >> 2) % identifierCount];
+                    if (!runner.Run(identifier, (uint8_t)((random >> 8) % 16), data)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool RunFile(Runner& runner, const char* inPath) {
+        bool same = true;
+        auto run = [&](const CanCoder::Frame& frame) {
+            // Extended identifiers are not supported by either engine, they are decoded anyway
+            same = same && runner.Run(frame.identifier, frame.dataLengthCode, frame.data);
+        };
+        if (EndsWith(inPath, ".cap")) {
+            CanCaptureReader capture;
+            if (!capture.Open(inPath)) {
+                fprintf(stderr, "Can not open capture %s\n", inPath);
+                return false;
+            }
+            capture.ForEachFrame(run);
+        }
+        else {
+            CanLogReplay replay;
+            if (!replay.Open(inPath)) {
+                fprintf(stderr, "Can not open log %s\n", inPath);
+                return false;
+            }
+            replay.ForEachFrame(run);
+        }
+        return same;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t frameCount = 1000000;
+    uint64_t seed = 1;
+    std::vector<const char*> paths;
+    for (int argument = 1; argument < argc; argument++) {
+        if (strcmp(argv[argument], "--frames") == 0 && argument + 1 < argc) {
+            frameCount = strtoull(argv[++argument], nullptr, 10);
+        }
+        else if (strcmp(argv[argument], "--seed") == 0 && argument + 1 < argc) {
+            seed = strtoull(argv[++argument], nullptr, 10);
+        }
+        else {
+            paths.push_back(argv[argument]);
+        }
+    }
+
+    Runner runner(seed);
+    bool same = RunGenerated(runner, seed, frameCount);
+    for (size_t index = 0; same && index < paths.size(); index++) {
+        same = RunFile(runner, paths[index]);
+    }
+    same = same && runner.Finish();
+    if (!same) {
+        if (!runner.GetDivergence().empty()) {
+            printf("Frame %llu: %s\n", (unsigned long long)runner.GetFrameCount(), runner.GetDivergence().c_str());
+        }
+        return 1;
+    }
+    printf("%llu frames, no divergence\n", (unsigned long long)runner.GetFrameCount());
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Fuzz target comparing CanCoder with CanCoderReference
+//
+// The input is a sequence of operations of 12 bytes each:
+// byte 0       operation, see ApplyOperation
+// bytes 1-2    identifier, little endian, bit 15 selects a supported identifier
+// byte 3       data length code in bits 0-3, the size of a span or a buffer in bits 4-7
+// bytes 4-11   data
+// A DecodeBatch operation decodes the frames of the operations following it, their
+// count is bits 4-7 of byte 3.
+//
+// Built with CANCODER_LIBFUZZER the target is run by libFuzzer (clang -fsanitize=fuzzer).
+// Otherwise main runs the inputs given as files, or pseudo random inputs:
+//     CanCoderFuzzer [--runs count] [--seed seed] [files]
+
+#include "CanCoderDifferential.h"
+#include "CanCoder.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+    constexpr size_t operationSize = 12;
+
+    uint32_t GetIdentifier(const uint8_t* operation) {
+        uint32_t identifier = operation[1] | ((operation[2] & 0x7f) << 8);
+        if ((operation[2] & 0x80) != 0) {
+            constexpr size_t identifierCount = sizeof(CanCoderDifferential<CanCoder>::identifiers) / sizeof(uint32_t);
+            identifier = CanCoderDifferential<CanCoder>::identifiers[operation[1] % identifierCount];
+        }
+        return identifier;
+    }
+
+    // Apply the operation at the start of operations, returns the number of operations used, 0 on a divergence
+    size_t ApplyOperation(CanCoderDifferential<CanCoder>& differential, const uint8_t* operations, size_t operationCount) {
+        const uint8_t* operation = operations;
+        uint32_t identifier = GetIdentifier(operation);
+        uint8_t dataLengthCode = operation[3] & 0x0f;
+        uint8_t size = operation[3] >> 4;
+        const uint8_t* data = operation + 4;
+        bool same;
+        switch (operation[0] % 16) {
+        case 6:
+        case 7:
+            same = differential.Encode(identifier);
+            break;
+        case 8:
+            same = differential.EncodeSpan(identifier, size > 8 ? 8 : size);
+            break;
+        case 9: {
+            uint64_t seed;
+            memcpy(&seed, data, sizeof(seed));
+            differential.SetFields(seed);
+            same = true;
+            break;
+        }
+        case 10:
+            same = differential.RawMessageToString(identifier, dataLengthCode, data);
+            break;
+        case 11:
+            same = differential.DecodeSpan(identifier, dataLengthCode > 8 ? 8 : dataLengthCode, data);
+            break;
+        case 12:
+        case 13:
+            same = differential.DecodeChanges(identifier, dataLengthCode, data);
+            break;
+        case 14:
+            // Buffers of 0-60 bytes truncate most strings
+            same = differential.ToString(identifier, size * 4);
+            break;
+        case 15: {
+            size_t frameCount = std::min<size_t>(size, operationCount - 1);
+            CanCoder::Frame frames[15];
+            for (size_t index = 0; index < frameCount; index++) {
+                const uint8_t* frameOperation = operations + (index + 1) * operationSize;
+                frames[index].identifier = GetIdentifier(frameOperation);
+                frames[index].dataLengthCode = frameOperation[3] & 0x0f;
+                memcpy(frames[index].data, frameOperation + 4, 8);
+                frames[index].timestamp = 0;
+            }
+            return differential.DecodeBatch(frames, frameCount) ? 1 + frameCount : 0;
+        }
+        default:
+            same = differential.Decode(identifier, dataLengthCode, data);
+            break;
+        }
+        return same ? 1 : 0;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    CanCoderDifferential<CanCoder> differential;
+    bool same = true;
+    size_t operationCount = size / operationSize;
+    for (size_t operation = 0; same && operation < operationCount; ) {
+        size_t appliedCount = ApplyOperation(differential, data + operation * operationSize, operationCount - operation);
+        same = appliedCount != 0;
+        operation += appliedCount;
+    }
+    if (same) {
+        same = differential.CompareState();
+    }
+    if (!same) {
+        fprintf(stderr, "%s\n", differential.GetDivergence().c_str());
+        abort();
+    }
+    return 0;
+}
+
+#ifndef CANCODER_LIBFUZZER
+
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    unsigned long runCount = 10000;
+    uint64_t seed = 1;
+    size_t fileCount = 0;
+    for (int argument = 1; argument < argc; argument++) {
+        if (strcmp(argv[argument], "--runs") == 0 && argument + 1 < argc) {
+            runCount = strtoul(argv[++argument], nullptr, 10);
+        }
+        else if (strcmp(argv[argument], "--seed") == 0 && argument + 1 < argc) {
+            seed = strtoull(argv[++argument], nullptr, 10);
+        }
+        else {
+            FILE* file = fopen(argv[argument], "rb");
+            if (file == nullptr) {
+                fprintf(stderr, "Can not open %s\n", argv[argument]);
+                return 1;
+            }
+            std::vector<uint8_t> input;
+            uint8_t buffer[4096];
+            size_t size;
+            while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                input.insert(input.end(), buffer, buffer + size);
+            }
+            fclose(file);
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+            fileCount++;
+        }
+    }
+    if (fileCount > 0) {
+        printf("%zu inputs, no divergence\n", fileCount);
+        return 0;
+    }
+
+    // Pseudo random inputs of up to 256 operations, the same for the same seed
+    uint64_t state = seed;
+    auto random = [&state]() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return (uint32_t)(state >> 32);
+    };
+    std::vector<uint8_t> input;
+    for (unsigned long run = 0; run < runCount; run++) {
+        input.resize((random() % 257) * operationSize);
+        for (uint8_t& byte : input) {
+            byte = (uint8_t)random();
+        }
+        // One in four operations repeats the identifier and data of an earlier one, as cyclic messages on a bus do,
+        // so DecodeChanges also sees data it has seen before
+        for (size_t position = operationSize; position < input.size(); position += operationSize) {
+            uint32_t repeat = random();
+            if (repeat % 4 == 0) {
+                size_t earlierPosition = (repeat >> 2) % (position / operationSize) * operationSize;
+                memcpy(&input[position + 1], &input[earlierPosition + 1], operationSize - 1);
+            }
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("%lu runs, no divergence\n", runCount);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,144 @@
+// Unit test of the CanCoder statistics
+//
+// Built with CanCoder.cpp compiled with CANCODER_STATISTICS and a latency sample interval of 2,
+// whatever the library is built with. Checks the decoded, encoded and rejected counts of every
+// decode and encode function, the number of latency samples and that ResetStatistics clears them.
+
+#include "CanCoder.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <string.h>
+
+static_assert(CANCODER_STATISTICS == 1 && CANCODER_LATENCY_SAMPLE_INTERVAL == 2, "The test needs the statistics compiled in");
+
+namespace {
+    uint64_t Sum(const uint64_t* counters, size_t count) {
+        uint64_t sum = 0;
+        for (size_t index = 0; index < count; index++) {
+            sum += counters[index];
+        }
+        return sum;
+    }
+
+    bool IsZero(const CanCoder::Statistics& statistics) {
+        CanCoder::Statistics zero = {};
+        return memcmp(&statistics, &zero, sizeof(zero)) == 0;
+    }
+
+    void TestDecode() {
+        CanCoder coder;
+        CanCoder::Statistics statistics;
+        CANTEST_CHECK(coder.GetStatistics(statistics));
+        CANTEST_CHECK(IsZero(statistics));
+
+        const size_t vehicleSpeed = CanCoder::GetMessageIndex(CanCoder::Identifier::vehicleSpeed);
+        const size_t gearShifterPosition = CanCoder::GetMessageIndex(CanCoder::Identifier::gearShifterPosition);
+        uint8_t data[CanCoder::maximumDataLength + 1] = { 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80 };
+        uint32_t changedFields = 0;
+        CANTEST_CHECK(coder.Decode(0x1B4, 2, data));
+        CANTEST_CHECK(coder.Decode(0x1B4, std::span<const uint8_t>(data, 8)));
+        CANTEST_CHECK(coder.Decode(0x1D2, 1, data));
+        // DecodeChanges counts the message that did not change as well
+        CANTEST_CHECK(coder.DecodeChanges(0x1B4, 2, data, changedFields));
+        CANTEST_CHECK(coder.DecodeChanges(0x1B4, 2, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+
+        CanCoder::Frame frames[3] = {};
+        frames[0].identifier = 0x1B4;
+        frames[0].dataLengthCode = 2;
+        frames[1].identifier = 0x1D2;
+        frames[1].dataLengthCode = 1;
+        frames[2].identifier = 0x123;
+        frames[2].dataLengthCode = 8;
+        CANTEST_CHECK_EQUAL(coder.DecodeBatch(frames, 3, nullptr), 2u);
+
+        // Rejected: an unknown identifier, too little data and a data length code above 8
+        CANTEST_CHECK(!coder.Decode(0x7FF, 8, data));
+        CANTEST_CHECK(!coder.DecodeChanges(0x7FF, 8, data, changedFields));
+        CANTEST_CHECK(!coder.Decode(0x1B4, 1, data));
+        CANTEST_CHECK(!coder.Decode(0x1B4, std::span<const uint8_t>(data, 1)));
+        CANTEST_CHECK(!coder.DecodeChanges(0x1B4, 1, data, changedFields));
+        CANTEST_CHECK(!coder.Decode(0x1B4, 9, data));
+        CANTEST_CHECK(!coder.DecodeChanges(0x1B4, 9, data, changedFields));
+        CANTEST_CHECK(!coder.Decode(0x1B4, std::span<const uint8_t>(data, CanCoder::maximumDataLength + 1)));
+
+        CANTEST_CHECK(coder.GetStatistics(statistics));
+        CANTEST_CHECK_EQUAL(statistics.decodedCount[vehicleSpeed], 5u);
+        CANTEST_CHECK_EQUAL(statistics.decodedCount[gearShifterPosition], 2u);
+        CANTEST_CHECK_EQUAL(Sum(statistics.decodedCount, CanCoder::messageCount), 7u);
+        CANTEST_CHECK_EQUAL(Sum(statistics.encodedCount, CanCoder::messageCount), 0u);
+        CANTEST_CHECK_EQUAL(statistics.unknownIdentifierCount, 3u);
+        CANTEST_CHECK_EQUAL(statistics.tooShortCount, 3u);
+        CANTEST_CHECK_EQUAL(statistics.tooLongCount, 3u);
+
+        // Every decode is counted for sampling, every second one is measured
+        CANTEST_CHECK_EQUAL(statistics.sampleCounter, 16u);
+        CANTEST_CHECK_EQUAL(Sum(statistics.latencyHistogram, CanCoder::latencyBucketCount), 8u);
+    }
+
+    void TestEncode() {
+        CanCoder coder;
+        const size_t gearShifterPosition = CanCoder::GetMessageIndex(CanCoder::Identifier::gearShifterPosition);
+        const size_t setDateTime = CanCoder::GetMessageIndex(CanCoder::Identifier::setDateTime);
+        uint32_t identifier = 0;
+        uint8_t dataLengthCode = 0;
+        uint8_t data[CanCoder::maximumDataLength] = {};
+
+        coder._identifier = CanCoder::Identifier::gearShifterPosition;
+        coder.Encode(identifier, dataLengthCode, data);
+        CANTEST_CHECK(coder.Encode(identifier, std::span<uint8_t>(data, sizeof(data))) != 0);
+        coder._identifier = CanCoder::Identifier::setDateTime;
+        coder.Encode(identifier, dataLengthCode, data);
+        // Not counted: a message that is not encodable, an unknown identifier and too little room
+        coder._identifier = CanCoder::Identifier::vehicleSpeed;
+        coder.Encode(identifier, dataLengthCode, data);
+        coder._identifier = (CanCoder::Identifier)0x123;
+        CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(data, sizeof(data))), 0u);
+        coder._identifier = CanCoder::Identifier::setDateTime;
+        CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(data, 1)), 0u);
+
+        CanCoder::Statistics statistics;
+        CANTEST_CHECK(coder.GetStatistics(statistics));
+        CANTEST_CHECK_EQUAL(statistics.encodedCount[gearShifterPosition], 2u);
+        CANTEST_CHECK_EQUAL(statistics.encodedCount[setDateTime], 1u);
+        CANTEST_CHECK_EQUAL(Sum(statistics.encodedCount, CanCoder::messageCount), 3u);
+        CANTEST_CHECK_EQUAL(Sum(statistics.decodedCount, CanCoder::messageCount), 0u);
+        CANTEST_CHECK_EQUAL(statistics.unknownIdentifierCount, 0u);
+        CANTEST_CHECK_EQUAL(statistics.sampleCounter, 0u);
+    }
+
+    void TestReset() {
+        CanCoder coder;
+        uint8_t data[8] = {};
+        coder.Decode(0x1B4, 2, data);
+        coder.Decode(0x1B4, 1, data);
+        coder.Decode(0x7FF, 8, data);
+        coder.Decode(0x1B4, 9, data);
+        coder._identifier = CanCoder::Identifier::gearShifterPosition;
+        uint32_t identifier = 0;
+        uint8_t dataLengthCode = 0;
+        coder.Encode(identifier, dataLengthCode, data);
+        CanCoder::Statistics statistics;
+        CANTEST_CHECK(coder.GetStatistics(statistics));
+        CANTEST_CHECK(!IsZero(statistics));
+
+        coder.ResetStatistics();
+        CANTEST_CHECK(coder.GetStatistics(statistics));
+        CANTEST_CHECK(IsZero(statistics));
+
+        // Counting starts again from zero
+        coder.Decode(0x1B4, 2, data);
+        coder.Decode(0x1B4, 2, data);
+        CANTEST_CHECK(coder.GetStatistics(statistics));
+        CANTEST_CHECK_EQUAL(statistics.decodedCount[CanCoder::GetMessageIndex(CanCoder::Identifier::vehicleSpeed)], 2u);
+        CANTEST_CHECK_EQUAL(statistics.sampleCounter, 2u);
+        CANTEST_CHECK_EQUAL(Sum(statistics.latencyHistogram, CanCoder::latencyBucketCount), 1u);
+    }
+}
+
+int main() {
+    TestDecode();
+    TestEncode();
+    TestReset();
+    return CanTestResult();
+}
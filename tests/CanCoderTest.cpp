@@ -0,0 +1,375 @@
+// Unit test of CanCoder
+//
+// Checks the changed fields reported by DecodeChanges, the std::span functions for
+// CAN FD messages, the truncation of strings written to a buffer, IsDecodable,
+// GetMessageIndex, the uncodedDataByte7 name of byte 7 of the date and time, and
+// CanSignal for both byte orders, signed signals and the clamping of physical values.
+
+#include "CanCoder.h"
+#include "CanSignal.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <string.h>
+#include <limits>
+#include <ratio>
+#include <string>
+
+namespace {
+    constexpr uint32_t doorOpenStatuses = (uint32_t)CanCoder::Identifier::doorOpenStatuses;
+    constexpr uint32_t iDriveController = (uint32_t)CanCoder::Identifier::iDriveControler;
+    constexpr uint32_t vehicleSpeed = (uint32_t)CanCoder::Identifier::vehicleSpeed;
+    constexpr uint32_t gearShifterPosition = (uint32_t)CanCoder::Identifier::gearShifterPosition;
+    constexpr uint32_t setDateTime = (uint32_t)CanCoder::Identifier::setDateTime;
+
+    uint32_t DoorMask(const char* inFieldName) {
+        return CanCoder::GetFieldMask(CanCoder::Identifier::doorOpenStatuses, inFieldName);
+    }
+
+    void TestDecodeChanges() {
+        CanCoder coder;
+        uint32_t changedFields = 0xffffffff;
+
+        // The first decode compares with the initial fields, which are all zero
+        uint8_t data[8] = { 0x00, 0x01, 0x01 };
+        CANTEST_CHECK(coder.DecodeChanges(doorOpenStatuses, 3, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, DoorMask("frontDriverSideDoorIsOpen") | DoorMask("bootIsOpen"));
+        CANTEST_CHECK(coder._doorOpenStatuses.frontDriverSideDoorIsOpen && coder._doorOpenStatuses.bootIsOpen);
+
+        // The same data, nothing changed, also when bytes beyond the data length code differ
+        data[5] = 0xff;
+        CANTEST_CHECK(coder.DecodeChanges(doorOpenStatuses, 3, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+
+        // One field changes
+        data[1] = 0x04;
+        CANTEST_CHECK(coder.DecodeChanges(doorOpenStatuses, 3, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, DoorMask("frontDriverSideDoorIsOpen") | DoorMask("frontPassengerSideDoorIsOpen"));
+
+        // A first decode of zero data changes no fields
+        uint8_t zeroData[8] = {};
+        CANTEST_CHECK(coder.DecodeChanges(vehicleSpeed, 2, zeroData, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::vehicleSpeed);
+    }
+
+    void TestDecodeChangesDataLengthCode() {
+        CanCoder coder;
+        uint32_t changedFields;
+        uint8_t data[8] = { 0x0f, 0xc0, 0x34, 0x12, 0xaa, 0xbb, 0xcc, 0xdd };
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 6, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, CanCoder::GetFieldMask(CanCoder::Identifier::iDriveControler, "dialValue"));
+        CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.dataLengthCode, 6);
+
+        // Another data length code with the same leading bytes is a different message, it is decoded
+        // No field changes, but the additional data follows the new message
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 8, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+        CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.dataLengthCode, 8);
+        CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.uncodedData[3], 0xdd);
+
+        // Changing the data length code in a way the fields do not see is still detected
+        coder._iDriveController.additionalData.dataLengthCode = 0;
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 8, data, changedFields));
+        CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.dataLengthCode, 0);
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 7, data, changedFields));
+        CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.dataLengthCode, 7);
+
+        // Too short and too long messages are rejected without changes
+        CANTEST_CHECK(!coder.DecodeChanges(iDriveController, 3, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+        CANTEST_CHECK(!coder.DecodeChanges(iDriveController, 9, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+        CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.dataLengthCode, 7);
+    }
+
+    void TestDecodeChangesAfterDecode() {
+        CanCoder coder;
+        uint32_t changedFields;
+        uint32_t speedMask = CanCoder::GetFieldMask(CanCoder::Identifier::vehicleSpeed, "speed");
+        uint8_t data[8] = { 0x64, 0x00 };
+        CANTEST_CHECK(coder.DecodeChanges(vehicleSpeed, 2, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, speedMask);
+
+        // Decode changes the fields behind the back of DecodeChanges, so the same data is decoded again
+        uint8_t otherData[8] = { 0xc8, 0x00 };
+        CANTEST_CHECK(coder.Decode(vehicleSpeed, 2, otherData));
+        CANTEST_CHECK_EQUAL(coder._vehicleSpeed.speed, 200);
+        CANTEST_CHECK(coder.DecodeChanges(vehicleSpeed, 2, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, speedMask);
+        CANTEST_CHECK_EQUAL(coder._vehicleSpeed.speed, 100);
+
+        // So does Encode, through the additional data
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 4, data, changedFields));
+        uint32_t identifier;
+        uint8_t dataLengthCode;
+        uint8_t encodedData[8] = {};
+        coder.Encode(identifier, dataLengthCode, encodedData);
+        CANTEST_CHECK_EQUAL(identifier, iDriveController);
+        coder._iDriveController.dialValue = 0x1234;
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 4, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, CanCoder::GetFieldMask(CanCoder::Identifier::iDriveControler, "dialValue"));
+
+        // Fields written directly are only noticed after ResetChanges
+        coder._iDriveController.dialValue = 0x1234;
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 4, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, 0u);
+        CANTEST_CHECK_EQUAL(coder._iDriveController.dialValue, 0x1234);
+        coder.ResetChanges();
+        CANTEST_CHECK(coder.DecodeChanges(iDriveController, 4, data, changedFields));
+        CANTEST_CHECK_EQUAL(changedFields, CanCoder::GetFieldMask(CanCoder::Identifier::iDriveControler, "dialValue"));
+        CANTEST_CHECK_EQUAL(coder._iDriveController.dialValue, 0);
+    }
+
+    void TestDecodeChangesIdentifier() {
+        // Like Decode, the identifier is set also when the message is rejected
+        CanCoder coder;
+        uint32_t changedFields;
+        uint8_t data[8] = {};
+        CANTEST_CHECK(!coder.DecodeChanges(0x123, 8, data, changedFields));
+        CANTEST_CHECK_EQUAL((uint32_t)coder._identifier, 0x123u);
+        CANTEST_CHECK(!coder.DecodeChanges(vehicleSpeed, 1, data, changedFields));
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::vehicleSpeed);
+        CANTEST_CHECK(!coder.DecodeChanges(doorOpenStatuses, 9, data, changedFields));
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::doorOpenStatuses);
+    }
+
+    void TestSpanDecode() {
+        CanCoder coder;
+        uint8_t data[8] = { 0x64, 0x00 };
+        CANTEST_CHECK(coder.Decode(vehicleSpeed, std::span<const uint8_t>(data, 2)));
+        CANTEST_CHECK_EQUAL(coder._vehicleSpeed.speed, 100);
+
+        // Like the other decode functions, the identifier is set also when the message is rejected
+        CANTEST_CHECK(!coder.Decode(doorOpenStatuses, std::span<const uint8_t>(data, 2)));
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::doorOpenStatuses);
+        uint8_t longData[64] = {};
+        CANTEST_CHECK(!coder.Decode(vehicleSpeed, std::span<const uint8_t>(longData, 9)));
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::vehicleSpeed);
+        CANTEST_CHECK(!coder.Decode(0x123, std::span<const uint8_t>(longData, 8)));
+        CANTEST_CHECK_EQUAL((uint32_t)coder._identifier, 0x123u);
+    }
+
+    void TestSpanEncode() {
+        CanCoder coder;
+        uint8_t data[8] = { 0x01, 0x0f, 0xf0, 0x20, 0xf0, 0xff, 0x00, 0x00 };
+        CANTEST_CHECK(coder.Decode(gearShifterPosition, 6, data));
+        CanCoder copy = coder;
+
+        // Too small for the 6 bytes of the message, nothing changes, not even the counter in byte 3
+        uint32_t identifier = 0;
+        uint8_t smallBuffer[5] = {};
+        CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(smallBuffer, 5)), 0u);
+        CANTEST_CHECK_EQUAL(identifier, gearShifterPosition);
+        CANTEST_CHECK(memcmp(&coder._gearShifterPosition, &copy._gearShifterPosition, sizeof(coder._gearShifterPosition)) == 0);
+
+        // The same message as the classic Encode
+        uint8_t buffer[8] = {};
+        CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(buffer, 8)), 6u);
+        uint32_t classicIdentifier;
+        uint8_t classicDataLengthCode;
+        uint8_t classicData[8] = {};
+        copy.Encode(classicIdentifier, classicDataLengthCode, classicData);
+        CANTEST_CHECK_EQUAL(classicDataLengthCode, 6);
+        CANTEST_CHECK(memcmp(buffer, classicData, 6) == 0);
+        CANTEST_CHECK_EQUAL(buffer[3], 0x30);
+
+        // Messages that can not be encoded
+        coder._identifier = CanCoder::Identifier::vehicleSpeed;
+        CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(buffer, 8)), 0u);
+    }
+
+    void TestSpanCanFd() {
+        CanCoder coder;
+        uint8_t data[64];
+        for (uint8_t index = 0; index < 64; index++) {
+            data[index] = index;
+        }
+        if constexpr (CanCoder::maximumDataLength < 12) {
+            // Without CAN FD support longer messages are rejected
+            CANTEST_CHECK(!coder.Decode(iDriveController, std::span<const uint8_t>(data, 12)));
+            return;
+        }
+        else {
+            CANTEST_CHECK(coder.Decode(iDriveController, std::span<const uint8_t>(data, 12)));
+            CANTEST_CHECK_EQUAL(coder._iDriveController.additionalData.dataLengthCode, 12);
+            // Not a valid CAN FD length
+            CANTEST_CHECK(!coder.Decode(iDriveController, std::span<const uint8_t>(data, 10)));
+
+            uint32_t identifier;
+            uint8_t buffer[64] = {};
+            CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(buffer, 8)), 0u);
+            CANTEST_CHECK_EQUAL(coder.Encode(identifier, std::span<uint8_t>(buffer, 64)), 12u);
+            CANTEST_CHECK(memcmp(buffer + 4, data + 4, 8) == 0);
+
+            // The classic Encode produces the first 8 bytes
+            uint8_t dataLengthCode;
+            uint8_t classicData[8] = {};
+            coder.Encode(identifier, dataLengthCode, classicData);
+            CANTEST_CHECK_EQUAL(dataLengthCode, 8);
+            CANTEST_CHECK(memcmp(classicData, buffer, 8) == 0);
+        }
+    }
+
+    void TestToStringBuffer() {
+        CanCoder coder;
+        uint8_t data[2] = { 0x64, 0x00 };
+        CANTEST_CHECK(coder.Decode(vehicleSpeed, 2, data));
+        std::string string = coder.ToString();
+        char buffer[CanCoder::stringBufferSize];
+        CANTEST_CHECK_EQUAL(coder.ToString(buffer, sizeof(buffer)), string.size());
+        CANTEST_CHECK(string == buffer);
+
+        // Truncated strings are zero terminated, an empty buffer is not written at all
+        memset(buffer, 'x', sizeof(buffer));
+        CANTEST_CHECK_EQUAL(coder.ToString(buffer, 5), string.size());
+        CANTEST_CHECK(string.substr(0, 4) == buffer);
+        memset(buffer, 'x', sizeof(buffer));
+        CANTEST_CHECK_EQUAL(coder.ToString(buffer, 0), string.size());
+        CANTEST_CHECK_EQUAL(buffer[0], 'x');
+    }
+
+    void TestIsDecodable() {
+        // Every supported message is decodable, only some are encodable
+        CanCoder::Identifier identifiers[CanCoder::messageCount];
+        size_t count = CanCoder::GetIdentifiers(identifiers, CanCoder::messageCount);
+        for (size_t index = 0; index < count; index++) {
+            CANTEST_CHECK(CanCoder::IsDecodable(identifiers[index]));
+        }
+        CANTEST_CHECK(CanCoder::IsDecodable(CanCoder::Identifier::vehicleSpeed));
+        CANTEST_CHECK(!CanCoder::IsEncodable(CanCoder::Identifier::vehicleSpeed));
+        CANTEST_CHECK(CanCoder::IsEncodable(CanCoder::Identifier::setDateTime));
+        CANTEST_CHECK(!CanCoder::IsDecodable((CanCoder::Identifier)0x000));
+        CANTEST_CHECK(!CanCoder::IsDecodable((CanCoder::Identifier)0x1B5));
+        CANTEST_CHECK(!CanCoder::IsDecodable((CanCoder::Identifier)0x7FF));
+        CANTEST_CHECK(!CanCoder::IsDecodable((CanCoder::Identifier)(0x1B4 | CanCoder::extendedIdentifierFlag)));
+    }
+
+    void TestGetMessageIndex() {
+        // The index is the position in GetIdentifiers, as used by the per message arrays
+        CanCoder::Identifier identifiers[CanCoder::messageCount];
+        size_t count = CanCoder::GetIdentifiers(identifiers, CanCoder::messageCount);
+        for (size_t index = 0; index < count; index++) {
+            CANTEST_CHECK_EQUAL(CanCoder::GetMessageIndex(identifiers[index]), index);
+        }
+        CANTEST_CHECK_EQUAL(CanCoder::GetMessageIndex((CanCoder::Identifier)0x1B5), CanCoder::messageCount);
+        CANTEST_CHECK_EQUAL(CanCoder::GetMessageIndex((CanCoder::Identifier)0x800), CanCoder::messageCount);
+        CANTEST_CHECK_EQUAL(CanCoder::GetMessageIndex((CanCoder::Identifier)(0x1B4 | CanCoder::extendedIdentifierFlag)), CanCoder::messageCount);
+    }
+
+    void TestDateTimeByte7() {
+        CanCoder coder;
+        uint8_t data[8] = { 12, 34, 56, 7, 0x8f, 0xe8, 0x07, 0xa5 };
+        CANTEST_CHECK(coder.Decode(setDateTime, 8, data));
+        CANTEST_CHECK_EQUAL(coder._dateTime.additionalData.uncodedDataByte7, 0xa5);
+        coder._dateTime.additionalData.uncodedDataByte7 = 0x5a;
+        CANTEST_CHECK_EQUAL(coder._dateTime.additionalData.uncodedData[0], 0x5a);
+        uint32_t identifier;
+        uint8_t dataLengthCode;
+        uint8_t encoded[8] = {};
+        coder.Encode(identifier, dataLengthCode, encoded);
+        CANTEST_CHECK_EQUAL(dataLengthCode, 8);
+        CANTEST_CHECK_EQUAL(encoded[7], 0x5a);
+    }
+
+    void TestSignalLittleEndian() {
+        // Bits 28-37: the high nibble of byte 3 and the low 6 bits of byte 4
+        using Unsigned = CanSignal<28, 10>;
+        using Signed = CanSignal<28, 10, CanByteOrder::littleEndian, true>;
+        static_assert(Unsigned::minimumDataLengthCode == 5);
+        uint8_t data[8] = { 0, 0, 0, 0x31, 0xFC, 0, 0, 0 };
+        CANTEST_CHECK_EQUAL(Unsigned::Extract(data), 0x3C3u);
+        CANTEST_CHECK_EQUAL(Signed::Extract(data), 0x3C3 - 0x400);
+        Signed::Insert(data, -512);
+        CANTEST_CHECK_EQUAL(data[3], 0x01);
+        CANTEST_CHECK_EQUAL(data[4], 0xE0);
+        CANTEST_CHECK_EQUAL(Signed::Extract(data), -512);
+        // Bits that do not fit are discarded
+        Unsigned::Insert(data, 0xFFFFFFFF);
+        CANTEST_CHECK_EQUAL(data[3], 0xF1);
+        CANTEST_CHECK_EQUAL(data[4], 0xFF);
+        CANTEST_CHECK_EQUAL(data[5], 0x00);
+
+        // 32 bit signals over 5 bytes
+        using Word = CanSignal<4, 32, CanByteOrder::littleEndian, true>;
+        uint8_t word[8] = {};
+        Word::Insert(word, INT32_MIN);
+        CANTEST_CHECK_EQUAL(word[0], 0x00);
+        CANTEST_CHECK_EQUAL(word[3], 0x00);
+        CANTEST_CHECK_EQUAL(word[4], 0x08);
+        CANTEST_CHECK_EQUAL(Word::Extract(word), INT32_MIN);
+    }
+
+    void TestSignalBigEndian() {
+        // Starting at the most significant bit of byte 0: byte 0 and the high nibble of byte 1
+        using Pressure = CanSignal<7, 12, CanByteOrder::bigEndian>;
+        // Starting at bit 3 of byte 1: the low nibble of byte 1, byte 2 and the high bit of byte 3
+        using Torque = CanSignal<11, 13, CanByteOrder::bigEndian, true>;
+        static_assert(Pressure::minimumDataLengthCode == 2);
+        static_assert(Torque::minimumDataLengthCode == 4);
+        uint8_t data[4] = { 0xAB, 0xCD, 0xEF, 0x92 };
+        CANTEST_CHECK_EQUAL(Pressure::Extract(data), 0xABCu);
+        CANTEST_CHECK_EQUAL(Torque::Extract(data), 0x1BDF - 0x2000);
+        Torque::Insert(data, 4095);
+        CANTEST_CHECK_EQUAL(data[0], 0xAB);
+        CANTEST_CHECK_EQUAL(data[1], 0xC7);
+        CANTEST_CHECK_EQUAL(data[2], 0xFF);
+        CANTEST_CHECK_EQUAL(data[3], 0x92);
+        Torque::Insert(data, -4096);
+        CANTEST_CHECK_EQUAL(data[1], 0xC8);
+        CANTEST_CHECK_EQUAL(data[2], 0x00);
+        CANTEST_CHECK_EQUAL(data[3], 0x12);
+        CANTEST_CHECK_EQUAL(Torque::Extract(data), -4096);
+        Pressure::Insert(data, 0x123);
+        CANTEST_CHECK_EQUAL(data[0], 0x12);
+        CANTEST_CHECK_EQUAL(data[1], 0x38);
+    }
+
+    void TestSignalPhysical() {
+        // 0.25 per bit, offset -40
+        using Temperature = CanSignal<0, 8, CanByteOrder::littleEndian, false, std::ratio<1, 4>, std::ratio<-40>>;
+        CANTEST_CHECK(Temperature::ToPhysical(200) == 10.0);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(10.0), 200u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(10.1), 200u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(10.2), 201u);
+        // Out of range values are clamped
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(-41.0), 0u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(-1000000.0), 0u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(23.75), 255u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(24.0), 255u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(1e30), 255u);
+        CANTEST_CHECK_EQUAL(Temperature::FromPhysical(std::numeric_limits<double>::quiet_NaN()), 0u);
+
+        using Torque = CanSignal<11, 13, CanByteOrder::bigEndian, true>;
+        static_assert(Torque::minimumRaw == -4096 && Torque::maximumRaw == 4095);
+        CANTEST_CHECK_EQUAL(Torque::FromPhysical(-4096.4), -4096);
+        CANTEST_CHECK_EQUAL(Torque::FromPhysical(-5000.0), -4096);
+        CANTEST_CHECK_EQUAL(Torque::FromPhysical(4095.4), 4095);
+        CANTEST_CHECK_EQUAL(Torque::FromPhysical(1e30), 4095);
+        CANTEST_CHECK_EQUAL(Torque::FromPhysical(-2.5), -3);
+        CANTEST_CHECK_EQUAL(Torque::FromPhysical(2.5), 3);
+
+        using Word = CanSignal<0, 32>;
+        CANTEST_CHECK_EQUAL(Word::FromPhysical(5e9), 0xFFFFFFFFu);
+        using SignedWord = CanSignal<0, 32, CanByteOrder::littleEndian, true>;
+        CANTEST_CHECK_EQUAL(SignedWord::FromPhysical(-5e9), INT32_MIN);
+        CANTEST_CHECK_EQUAL(SignedWord::FromPhysical(5e9), INT32_MAX);
+    }
+}
+
+int main() {
+    TestDecodeChanges();
+    TestDecodeChangesDataLengthCode();
+    TestDecodeChangesAfterDecode();
+    TestDecodeChangesIdentifier();
+    TestSpanDecode();
+    TestSpanEncode();
+    TestSpanCanFd();
+    TestToStringBuffer();
+    TestIsDecodable();
+    TestGetMessageIndex();
+    TestDateTimeByte7();
+    TestSignalLittleEndian();
+    TestSignalBigEndian();
+    TestSignalPhysical();
+    return CanTestResult();
+}
@@ -0,0 +1,248 @@
+// Unit test of CanColumnWriter and CanColumnReader
+//
+// Writes the columns of several messages and reads them back, checking the bit-packed,
+// run-length and plain encodings and the shared timestamp column, then checks that
+// truncated and corrupt files are rejected by Open, including positions and counts whose
+// sums overflow.
+
+#include "CanColumns.h"
+#include "CanTest.h"
+#include <string.h>
+#include <vector>
+
+namespace {
+    // Positions of the fields in the file
+    constexpr size_t tableCountPosition = 8;
+    constexpr size_t columnCountPosition = 12;
+    constexpr size_t tableDirectoryPositionPosition = 16;
+    constexpr size_t columnDirectoryPositionPosition = 24;
+    constexpr size_t tableEntrySize = 24;
+    constexpr size_t tableRowCountPosition = 8;
+    constexpr size_t tableTimestampsPositionPosition = 16;
+    constexpr size_t columnEntrySize = 80;
+    constexpr size_t columnRowCountPosition = 56;
+    constexpr size_t columnPositionPosition = 64;
+    constexpr size_t columnSizePosition = 72;
+
+    constexpr uint32_t rowCount = 1000;
+    const char gearPositions[] = "PRNDDDDD";
+
+    bool WriteColumns(const CanTest::TemporaryFile& inFile) {
+        CanColumnWriter writer;
+        CanCoder coder;
+        for (uint32_t row = 0; row < rowCount; row++) {
+            coder._identifier = CanCoder::Identifier::vehicleSpeed;
+            coder._vehicleSpeed.speed = (int)row - 500;
+            writer.Append(coder, 1000 + row);
+            coder._identifier = CanCoder::Identifier::doorOpenStatuses;
+            coder._doorOpenStatuses.bootIsOpen = row % 3 == 0;
+            coder._doorOpenStatuses.bonnetIsOpen = row >= 900;
+            writer.Append(coder, 2000 + row);
+            // The gear position changes at most every 100 rows, PRNDPR in 6 runs
+            coder._identifier = CanCoder::Identifier::gearShifterPosition;
+            coder._gearShifterPosition.position = gearPositions[row / 100 % 8];
+            writer.Append(coder, 3000 + row);
+        }
+        coder._identifier = CanCoder::Identifier::iDriveControler;
+        coder._iDriveController.dialValue = 0xfffe;
+        writer.Append(coder, 4000);
+        CANTEST_CHECK_EQUAL(writer.GetRowCount((uint32_t)CanCoder::Identifier::vehicleSpeed), rowCount);
+        CANTEST_CHECK_EQUAL(writer.GetRowCount((uint32_t)CanCoder::Identifier::handbrakeStatus), 0u);
+        return writer.Write(inFile.GetPath());
+    }
+
+    std::vector<uint8_t> ReadFile(const CanTest::TemporaryFile& inFile) {
+        std::vector<uint8_t> contents;
+        FILE* file = fopen(inFile.GetPath(), "rb");
+        if (file != nullptr) {
+            uint8_t buffer[4096];
+            size_t size;
+            while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                contents.insert(contents.end(), buffer, buffer + size);
+            }
+            fclose(file);
+        }
+        return contents;
+    }
+
+    template <typename Type>
+    Type ReadField(const std::vector<uint8_t>& inContents, size_t inPosition) {
+        Type value;
+        memcpy(&value, &inContents[inPosition], sizeof(value));
+        return value;
+    }
+
+    template <typename Type>
+    void WriteField(std::vector<uint8_t>& inContents, size_t inPosition, Type inValue) {
+        memcpy(&inContents[inPosition], &inValue, sizeof(inValue));
+    }
+
+    bool OpenContents(const std::vector<uint8_t>& inContents) {
+        CanTest::TemporaryFile file;
+        CanColumnReader reader;
+        return file.Write(inContents.data(), inContents.size()) && reader.Open(file.GetPath());
+    }
+
+    void TestRoundTrip() {
+        CanTest::TemporaryFile file;
+        CANTEST_CHECK(WriteColumns(file));
+        CanColumnReader reader;
+        CANTEST_CHECK(reader.Open(file.GetPath()));
+
+        // Only decoded messages are written
+        uint64_t timestampCount = 0;
+        CANTEST_CHECK(reader.GetTimestamps((uint32_t)CanCoder::Identifier::handbrakeStatus, timestampCount) == nullptr);
+        CANTEST_CHECK_EQUAL(timestampCount, 0u);
+
+        const CanColumnReader::Column* speed = reader.FindColumn((uint32_t)CanCoder::Identifier::vehicleSpeed, "speed");
+        CANTEST_CHECK(speed != nullptr);
+        if (speed != nullptr) {
+            CANTEST_CHECK(speed->encoding == CanColumnEncoding::plain);
+            CANTEST_CHECK_EQUAL(speed->rowCount, rowCount);
+            const int32_t* speeds = (const int32_t*)speed->data;
+            bool same = true;
+            for (uint32_t row = 0; row < rowCount; row++) {
+                same = same && speeds[row] == (int32_t)row - 500 && speed->GetValue(row) == (int32_t)row - 500;
+            }
+            CANTEST_CHECK(same);
+        }
+
+        const CanColumnReader::Column* dialValue = reader.FindColumn((uint32_t)CanCoder::Identifier::iDriveControler, "dialValue");
+        CANTEST_CHECK(dialValue != nullptr);
+        if (dialValue != nullptr) {
+            CANTEST_CHECK(dialValue->type == CanCoder::FieldType::unsignedShort);
+            CANTEST_CHECK_EQUAL(dialValue->size, sizeof(uint16_t));
+            CANTEST_CHECK_EQUAL(dialValue->GetValue(0), 0xfffe);
+        }
+
+        // Bit-packed, 64 rows per word
+        const CanColumnReader::Column* boot = reader.FindColumn((uint32_t)CanCoder::Identifier::doorOpenStatuses, "bootIsOpen");
+        const CanColumnReader::Column* bonnet = reader.FindColumn((uint32_t)CanCoder::Identifier::doorOpenStatuses, "bonnetIsOpen");
+        CANTEST_CHECK(boot != nullptr && bonnet != nullptr);
+        if (boot != nullptr && bonnet != nullptr) {
+            CANTEST_CHECK(boot->encoding == CanColumnEncoding::bitPacked);
+            CANTEST_CHECK_EQUAL(boot->size, (rowCount + 63) / 64 * sizeof(uint64_t));
+            CANTEST_CHECK_EQUAL(((const uint64_t*)boot->data)[0] & 0xf, 0x9u);
+            bool same = true;
+            for (uint32_t row = 0; row < rowCount; row++) {
+                same = same && boot->GetValue(row) == (row % 3 == 0) && bonnet->GetValue(row) == (row >= 900);
+            }
+            CANTEST_CHECK(same);
+        }
+
+        // Run-length encoded, one run for each gear position
+        const CanColumnReader::Column* gear = reader.FindColumn((uint32_t)CanCoder::Identifier::gearShifterPosition, "position");
+        CANTEST_CHECK(gear != nullptr);
+        if (gear != nullptr) {
+            CANTEST_CHECK(gear->encoding == CanColumnEncoding::runLength);
+            size_t runCount = gear->size / sizeof(CanColumnRun);
+            CANTEST_CHECK_EQUAL(runCount, 6u);
+            const CanColumnRun* runs = (const CanColumnRun*)gear->data;
+            CANTEST_CHECK_EQUAL(runs[0].endRow, 100u);
+            CANTEST_CHECK_EQUAL(runs[0].value, 'P');
+            CANTEST_CHECK_EQUAL(runs[3].endRow, 800u);
+            CANTEST_CHECK_EQUAL(runs[3].value, 'D');
+            CANTEST_CHECK_EQUAL(runs[runCount - 1].endRow, rowCount);
+            bool same = true;
+            for (uint32_t row = 0; row < rowCount; row++) {
+                same = same && gear->GetValue(row) == gearPositions[row / 100 % 8];
+            }
+            CANTEST_CHECK(same);
+        }
+
+        // All columns of a message share the timestamps of its table
+        const uint64_t* timestamps = reader.GetTimestamps((uint32_t)CanCoder::Identifier::doorOpenStatuses, timestampCount);
+        CANTEST_CHECK(timestamps != nullptr);
+        CANTEST_CHECK_EQUAL(timestampCount, rowCount);
+        if (timestamps != nullptr) {
+            CANTEST_CHECK_EQUAL(timestamps[0], 2000u);
+            CANTEST_CHECK_EQUAL(timestamps[rowCount - 1], 2000u + rowCount - 1);
+        }
+        for (const CanColumnReader::Column& column : reader.GetColumns()) {
+            uint64_t columnTimestampCount = 0;
+            CANTEST_CHECK(reader.GetTimestamps(column.identifier, columnTimestampCount) != nullptr);
+            CANTEST_CHECK_EQUAL(column.rowCount, columnTimestampCount);
+        }
+    }
+
+    void TestAdd() {
+        CanColumnWriter writer;
+        // Speed 42 in the first 12 bits
+        CanCoder::Frame frame = {};
+        frame.identifier = (uint32_t)CanCoder::Identifier::vehicleSpeed;
+        frame.dataLengthCode = 2;
+        frame.data[0] = 42;
+        CANTEST_CHECK(writer.Add(frame));
+        CANTEST_CHECK_EQUAL(writer.GetRowCount((uint32_t)CanCoder::Identifier::vehicleSpeed), 1u);
+        frame.identifier = 0x123;
+        CANTEST_CHECK(!writer.Add(frame));
+        writer.Clear();
+        CANTEST_CHECK_EQUAL(writer.GetRowCount((uint32_t)CanCoder::Identifier::vehicleSpeed), 0u);
+    }
+
+    void TestInvalidFiles() {
+        CanTest::TemporaryFile file;
+        CANTEST_CHECK(WriteColumns(file));
+        const std::vector<uint8_t> contents = ReadFile(file);
+        CANTEST_CHECK(OpenContents(contents));
+        uint64_t tableDirectoryPosition = ReadField<uint64_t>(contents, tableDirectoryPositionPosition);
+        uint64_t columnDirectoryPosition = ReadField<uint64_t>(contents, columnDirectoryPositionPosition);
+
+        // Truncated, the column directory is at the end of the file
+        std::vector<uint8_t> truncated(contents.begin(), contents.end() - 1);
+        CANTEST_CHECK(!OpenContents(truncated));
+        truncated.assign(contents.begin(), contents.begin() + 16);
+        CANTEST_CHECK(!OpenContents(truncated));
+
+        std::vector<uint8_t> corrupt = contents;
+        corrupt[0] = 'X';
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteField<uint32_t>(corrupt, tableCountPosition, ReadField<uint32_t>(contents, tableCountPosition) + 1);
+        WriteField<uint32_t>(corrupt, columnCountPosition, ReadField<uint32_t>(contents, columnCountPosition) + 1);
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // Directory positions whose sum with the directory size wraps around
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, tableDirectoryPositionPosition, UINT64_MAX - 7);
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, columnDirectoryPositionPosition, 0 - (uint64_t)columnEntrySize);
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // Timestamps of the first table at a position that wraps around
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, tableDirectoryPosition + tableTimestampsPositionPosition, UINT64_MAX - 7);
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, tableDirectoryPosition + tableRowCountPosition, 1ull << 61);
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // Data of the first column at a position that wraps around, or larger than the file
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, columnDirectoryPosition + columnPositionPosition, UINT64_MAX - 7);
+        WriteField<uint64_t>(corrupt, columnDirectoryPosition + columnSizePosition, 16);
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, columnDirectoryPosition + columnSizePosition, UINT64_MAX - 7);
+        CANTEST_CHECK(!OpenContents(corrupt));
+
+        // Column row counts that differ from their table, 2^63 rows of 2 or 4 bytes wrap around to 0 bytes
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, columnDirectoryPosition + columnRowCountPosition, rowCount + 1);
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, columnDirectoryPosition + columnRowCountPosition, 1ull << 63);
+        CANTEST_CHECK(!OpenContents(corrupt));
+        corrupt = contents;
+        WriteField<uint64_t>(corrupt, columnDirectoryPosition + columnRowCountPosition, 0);
+        CANTEST_CHECK(!OpenContents(corrupt));
+    }
+}
+
+int main() {
+    TestRoundTrip();
+    TestAdd();
+    TestInvalidFiles();
+    return CanTestResult();
+}
@@ -0,0 +1,131 @@
+// Unit test of CanDispatcher
+//
+// Checks the order in which listeners are called, the filtering on fields and
+// unsubscribing.
+
+#include "CanDispatcher.h"
+#include "CanTest.h"
+#include <string>
+
+namespace {
+    constexpr uint32_t doorOpenStatuses = (uint32_t)CanCoder::Identifier::doorOpenStatuses;
+    constexpr uint32_t vehicleSpeed = (uint32_t)CanCoder::Identifier::vehicleSpeed;
+
+    // Appends its name to the calls, so the order of the calls can be checked
+    struct Recorder {
+        std::string* calls;
+        char name;
+        uint32_t lastChangedFields = 0;
+
+        void OnChange(const CanCoder&, uint32_t inChangedFields) {
+            *calls += name;
+            lastChangedFields = inChangedFields;
+        }
+    };
+
+    void Record(void* inContext, const CanCoder& inCoder, uint32_t inChangedFields) {
+        ((Recorder*)inContext)->OnChange(inCoder, inChangedFields);
+    }
+
+    void TestOrder() {
+        CanCoder coder;
+        CanDispatcher dispatcher(coder);
+        std::string calls;
+        Recorder a = { &calls, 'a' };
+        Recorder b = { &calls, 'b' };
+        Recorder c = { &calls, 'c' };
+        Recorder d = { &calls, 'd' };
+        // Subscriptions of other identifiers in between do not change the order
+        CANTEST_CHECK(dispatcher.Subscribe(CanCoder::Identifier::doorOpenStatuses, CanDispatcher::allFields, Record, &c));
+        CANTEST_CHECK(dispatcher.Subscribe(CanCoder::Identifier::vehicleSpeed, CanDispatcher::allFields, Record, &d));
+        CANTEST_CHECK(dispatcher.Subscribe(CanCoder::Identifier::doorOpenStatuses, "bootIsOpen", Record, &a));
+        CANTEST_CHECK(dispatcher.Subscribe(CanCoder::Identifier::mirrorFoldStatus, CanDispatcher::allFields, Record, &d));
+        CANTEST_CHECK(dispatcher.Subscribe<&Recorder::OnChange>(CanCoder::Identifier::doorOpenStatuses,
+            CanCoder::GetFieldMask(CanCoder::Identifier::doorOpenStatuses, "bonnetIsOpen"), b));
+        CANTEST_CHECK(!dispatcher.Subscribe(CanCoder::Identifier::doorOpenStatuses, "noSuchField", Record, &a));
+
+        // Boot open: c and a, in the order of subscribing
+        uint8_t data[8] = { 0x00, 0x00, 0x01 };
+        CANTEST_CHECK(dispatcher.Decode(doorOpenStatuses, 3, data));
+        CANTEST_CHECK_EQUAL(calls, "ca");
+        CANTEST_CHECK_EQUAL(a.lastChangedFields, CanCoder::GetFieldMask(CanCoder::Identifier::doorOpenStatuses, "bootIsOpen"));
+
+        // Nothing changed, no calls
+        calls.clear();
+        CANTEST_CHECK(dispatcher.Decode(doorOpenStatuses, 3, data));
+        CANTEST_CHECK_EQUAL(calls, "");
+
+        // Boot closed and bonnet open: all three, the listeners get all changed fields
+        data[2] = 0x04;
+        CANTEST_CHECK(dispatcher.Decode(doorOpenStatuses, 3, data));
+        CANTEST_CHECK_EQUAL(calls, "cab");
+        CANTEST_CHECK_EQUAL(b.lastChangedFields,
+            CanCoder::GetFieldMask(CanCoder::Identifier::doorOpenStatuses, "bootIsOpen") |
+            CanCoder::GetFieldMask(CanCoder::Identifier::doorOpenStatuses, "bonnetIsOpen"));
+
+        // Only the listener of the other message
+        calls.clear();
+        uint8_t speedData[8] = { 0x10 };
+        CANTEST_CHECK(dispatcher.Decode(vehicleSpeed, 2, speedData));
+        CANTEST_CHECK_EQUAL(calls, "d");
+
+        // Rejected messages call no listeners
+        calls.clear();
+        CANTEST_CHECK(!dispatcher.Decode(vehicleSpeed, 1, speedData));
+        CANTEST_CHECK(!dispatcher.Decode(0x123, 8, speedData));
+        CANTEST_CHECK_EQUAL(calls, "");
+    }
+
+    void TestUnsubscribe() {
+        CanCoder coder;
+        CanDispatcher dispatcher(coder);
+        std::string calls;
+        Recorder a = { &calls, 'a' };
+        Recorder b = { &calls, 'b' };
+        Recorder c = { &calls, 'c' };
+        dispatcher.Subscribe(CanCoder::Identifier::doorOpenStatuses, CanDispatcher::allFields, Record, &a);
+        dispatcher.Subscribe(CanCoder::Identifier::doorOpenStatuses, CanDispatcher::allFields, Record, &b);
+        dispatcher.Subscribe(CanCoder::Identifier::vehicleSpeed, CanDispatcher::allFields, Record, &b);
+        dispatcher.Subscribe<&Recorder::OnChange>(CanCoder::Identifier::doorOpenStatuses, CanDispatcher::allFields, c);
+
+        // All subscriptions of b, the others keep their order
+        CANTEST_CHECK_EQUAL(dispatcher.Unsubscribe(Record, &b), 2u);
+        CANTEST_CHECK_EQUAL(dispatcher.Unsubscribe(Record, &b), 0u);
+        // The member function has its own listener, so Record with c removes nothing
+        CANTEST_CHECK_EQUAL(dispatcher.Unsubscribe(Record, &c), 0u);
+
+        uint8_t data[8] = { 0x00, 0x01 };
+        dispatcher.Decode(doorOpenStatuses, 3, data);
+        CANTEST_CHECK_EQUAL(calls, "ac");
+        calls.clear();
+        uint8_t speedData[8] = { 0x10 };
+        dispatcher.Decode(vehicleSpeed, 2, speedData);
+        CANTEST_CHECK_EQUAL(calls, "");
+
+        CANTEST_CHECK_EQUAL(dispatcher.Unsubscribe<&Recorder::OnChange>(c), 1u);
+        data[1] = 0x00;
+        dispatcher.Decode(doorOpenStatuses, 3, data);
+        CANTEST_CHECK_EQUAL(calls, "a");
+    }
+
+    void TestCapacity() {
+        CanCoder coder;
+        CanDispatcher dispatcher(coder);
+        std::string calls;
+        Recorder a = { &calls, 'a' };
+        for (size_t index = 0; index < CanDispatcher::maximumSubscriptionCount; index++) {
+            CANTEST_CHECK(dispatcher.Subscribe(CanCoder::Identifier::vehicleSpeed, CanDispatcher::allFields, Record, &a));
+        }
+        CANTEST_CHECK(!dispatcher.Subscribe(CanCoder::Identifier::vehicleSpeed, CanDispatcher::allFields, Record, &a));
+        CANTEST_CHECK(!dispatcher.Subscribe(CanCoder::Identifier::vehicleSpeed, CanDispatcher::allFields, nullptr, &a));
+        CANTEST_CHECK_EQUAL(dispatcher.Unsubscribe(Record, &a), CanDispatcher::maximumSubscriptionCount);
+        CANTEST_CHECK(dispatcher.Subscribe(CanCoder::Identifier::vehicleSpeed, CanDispatcher::allFields, Record, &a));
+    }
+}
+
+int main() {
+    TestOrder();
+    TestUnsubscribe();
+    TestCapacity();
+    return CanTestResult();
+}
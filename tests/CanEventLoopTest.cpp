@@ -0,0 +1,184 @@
+// Unit test of CanEventLoop
+//
+// Checks the order in which waiting coroutines are resumed by frames and by timeouts,
+// the results of timed out waits, predicates that already hold, transmitting and the
+// destruction of coroutines still waiting.
+
+#include "CanEventLoop.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <string>
+
+namespace {
+    constexpr uint32_t vehicleSpeed = (uint32_t)CanCoder::Identifier::vehicleSpeed;
+    constexpr uint32_t doorOpenStatuses = (uint32_t)CanCoder::Identifier::doorOpenStatuses;
+
+    // The speed is in byte 0, the boot open status in bit 0 of byte 2
+    CanCoder::Frame CreateFrame(uint32_t identifier, uint8_t speed, bool bootIsOpen, uint64_t timestamp) {
+        CanCoder::Frame frame = {};
+        frame.identifier = identifier;
+        frame.dataLengthCode = 8;
+        frame.data[0] = speed;
+        frame.data[2] = bootIsOpen ? 0x01 : 0x00;
+        frame.timestamp = timestamp;
+        return frame;
+    }
+
+    // Each coroutine appends its name and the result of its wait to the log
+    CanTask WaitForFrame(CanEventLoop& loop, std::string& log, char name, uint64_t timeout) {
+        bool result = co_await loop.NextFrame(CanCoder::Identifier::vehicleSpeed, timeout);
+        log += name;
+        log += result ? '+' : '-';
+    }
+
+    CanTask WaitForBoot(CanEventLoop& loop, std::string& log, char name, uint64_t timeout) {
+        bool result = co_await loop.WaitUntil(CanCoder::Identifier::doorOpenStatuses,
+            [](const CanCoder& coder) { return coder._doorOpenStatuses.bootIsOpen; }, timeout);
+        log += name;
+        log += result ? '+' : '-';
+    }
+
+    CanTask WaitForTime(CanEventLoop& loop, std::string& log, char name, uint64_t duration) {
+        bool result = co_await loop.Delay(duration);
+        log += name;
+        log += result ? '+' : '-';
+    }
+
+    CanTask CountFrames(CanEventLoop& loop, int& count) {
+        while (true) {
+            co_await loop.NextFrame(CanCoder::Identifier::vehicleSpeed);
+            count++;
+        }
+    }
+
+    void TestFrameOrder() {
+        CanCoder coder;
+        CanEventLoop loop(coder, nullptr, nullptr);
+        std::string log;
+        int count = 0;
+        loop.Spawn(WaitForFrame(loop, log, 'a', CanEventLoop::never));
+        loop.Spawn(CountFrames(loop, count));
+        loop.Spawn(WaitForFrame(loop, log, 'b', CanEventLoop::never));
+        loop.Spawn(WaitForBoot(loop, log, 'c', CanEventLoop::never));
+        CANTEST_CHECK_EQUAL(loop.GetWaitingCount(), 4u);
+        CANTEST_CHECK_EQUAL(loop.NextDueTime(), CanEventLoop::never);
+
+        // Other identifiers and messages that do not decode resume nothing
+        CANTEST_CHECK(!loop.Decode(CreateFrame(0x123, 0, false, 10)));
+        CANTEST_CHECK(loop.Decode(CreateFrame(doorOpenStatuses, 0, false, 20)));
+        CANTEST_CHECK(log.empty());
+
+        // Resumed in the order they started waiting, a coroutine waiting again waits for the next frame
+        CANTEST_CHECK(loop.Decode(CreateFrame(vehicleSpeed, 0x64, false, 30)));
+        CANTEST_CHECK_EQUAL(log, std::string("a+b+"));
+        CANTEST_CHECK_EQUAL(count, 1);
+        CANTEST_CHECK(loop.Decode(CreateFrame(vehicleSpeed, 0x64, false, 40)));
+        CANTEST_CHECK_EQUAL(count, 2);
+        CANTEST_CHECK_EQUAL(loop.GetTime(), 40u);
+
+        // The boot opens
+        CANTEST_CHECK(loop.Decode(CreateFrame(doorOpenStatuses, 0, true, 50)));
+        CANTEST_CHECK_EQUAL(log, std::string("a+b+c+"));
+
+        // The predicate holds for the last decoded message, so the wait is over right away
+        loop.Spawn(WaitForBoot(loop, log, 'd', 10));
+        CANTEST_CHECK_EQUAL(log, std::string("a+b+c+d+"));
+        CANTEST_CHECK_EQUAL(loop.GetWaitingCount(), 1u);
+    }
+
+    void TestTimeouts() {
+        CanCoder coder;
+        CanEventLoop loop(coder, nullptr, nullptr);
+        std::string log;
+        loop.Poll(1000);
+        loop.Spawn(WaitForTime(loop, log, 'a', 300));
+        loop.Spawn(WaitForFrame(loop, log, 'b', 100));
+        loop.Spawn(WaitForBoot(loop, log, 'c', 200));
+        loop.Spawn(WaitForTime(loop, log, 'd', 100));
+        loop.Spawn(WaitForFrame(loop, log, 'e', CanEventLoop::never));
+        CANTEST_CHECK_EQUAL(loop.NextDueTime(), 1100u);
+
+        loop.Poll(1099);
+        CANTEST_CHECK(log.empty());
+        loop.Poll(1100);
+        CANTEST_CHECK_EQUAL(log, std::string("b-d+"));
+        CANTEST_CHECK_EQUAL(loop.NextDueTime(), 1200u);
+
+        // Time running backwards is ignored
+        loop.Poll(500);
+        CANTEST_CHECK_EQUAL(loop.GetTime(), 1100u);
+
+        // A frame after the deadlines first times the waits out, in the order of their deadlines,
+        // and is then decoded
+        CANTEST_CHECK(loop.Decode(CreateFrame(vehicleSpeed, 0x64, false, 5000)));
+        CANTEST_CHECK_EQUAL(log, std::string("b-d+c-a+e+"));
+        CANTEST_CHECK_EQUAL(loop.GetWaitingCount(), 0u);
+        CANTEST_CHECK_EQUAL(loop.NextDueTime(), CanEventLoop::never);
+
+        // A delay that is already over does not wait
+        loop.Spawn(WaitForTime(loop, log, 'f', 0));
+        CANTEST_CHECK_EQUAL(log, std::string("b-d+c-a+e+f+"));
+    }
+
+    struct Sent {
+        int count = 0;
+        CanCoder::Frame frame = {};
+    };
+
+    bool Send(void* context, const CanCoder::Frame& frame) {
+        Sent& sent = *(Sent*)context;
+        sent.count++;
+        sent.frame = frame;
+        return true;
+    }
+
+    void TestTransmit() {
+        CanCoder coder;
+        Sent sent;
+        CanEventLoop loop(coder, &Send, &sent);
+        CANTEST_CHECK(loop.Decode(CreateFrame(vehicleSpeed, 0x64, false, 100)));
+        CANTEST_CHECK(!loop.Transmit(CanCoder::Identifier::vehicleSpeed));
+        coder._doorLockControl.lockDoors = true;
+        CANTEST_CHECK(loop.Transmit(CanCoder::Identifier::doorLockControl));
+        CANTEST_CHECK_EQUAL(sent.count, 1);
+        CANTEST_CHECK_EQUAL(sent.frame.identifier, (uint32_t)CanCoder::Identifier::doorLockControl);
+        CANTEST_CHECK_EQUAL(sent.frame.timestamp, 100u);
+        // The identifier of the last decode is kept
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::vehicleSpeed);
+    }
+
+    // Counts the coroutine frames that were destroyed
+    struct Guard {
+        int* destroyedCount;
+        ~Guard() { (*destroyedCount)++; }
+    };
+
+    CanTask WaitForever(CanEventLoop& loop, int& destroyedCount) {
+        Guard guard{ &destroyedCount };
+        co_await loop.NextFrame(CanCoder::Identifier::vehicleSpeed);
+        co_await loop.Delay(CanEventLoop::never);
+    }
+
+    void TestDestruction() {
+        CanCoder coder;
+        int destroyedCount = 0;
+        {
+            CanEventLoop loop(coder, nullptr, nullptr);
+            loop.Spawn(WaitForever(loop, destroyedCount));
+            loop.Spawn(WaitForever(loop, destroyedCount));
+            CANTEST_CHECK(loop.Decode(CreateFrame(vehicleSpeed, 0x64, false, 100)));
+            loop.Spawn(WaitForever(loop, destroyedCount));
+            CANTEST_CHECK_EQUAL(loop.GetWaitingCount(), 3u);
+            CANTEST_CHECK_EQUAL(destroyedCount, 0);
+        }
+        CANTEST_CHECK_EQUAL(destroyedCount, 3);
+    }
+}
+
+int main() {
+    TestFrameOrder();
+    TestTimeouts();
+    TestTransmit();
+    TestDestruction();
+    return CanTestResult();
+}
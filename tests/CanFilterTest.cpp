@@ -0,0 +1,147 @@
+// Unit test of CanFilter
+//
+// Checks deadbands, on change rules, rate limits and their combination on the state of a
+// coder, that a rejected on change mask adds no rules, that timestamps going back restart
+// the rate limit and that fields of every type are compared.
+
+#include "CanFilter.h"
+#include "CanTest.h"
+#include <stdint.h>
+
+namespace {
+    bool AcceptSpeed(CanFilter& filter, CanCoder& coder, int speed, uint64_t timestamp) {
+        coder._identifier = CanCoder::Identifier::vehicleSpeed;
+        coder._vehicleSpeed.speed = speed;
+        return filter.Accept(coder, timestamp);
+    }
+
+    bool AcceptBoot(CanFilter& filter, CanCoder& coder, bool bootIsOpen) {
+        coder._identifier = CanCoder::Identifier::doorOpenStatuses;
+        coder._doorOpenStatuses.bootIsOpen = bootIsOpen;
+        return filter.Accept(coder, 0);
+    }
+
+    void TestDeadband() {
+        CanFilter filter;
+        CanCoder coder;
+        CANTEST_CHECK(filter.AddDeadband(CanCoder::Identifier::vehicleSpeed, "speed", 2));
+        CANTEST_CHECK(!filter.AddDeadband(CanCoder::Identifier::vehicleSpeed, "unknown", 2));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 0));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 101, 1));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 102, 2));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 103, 3));
+        // Relative to the last forwarded value
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 101, 4));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 5));
+        CANTEST_CHECK_EQUAL(filter.GetStatistics(CanCoder::Identifier::vehicleSpeed).forwardedCount, 3u);
+        CANTEST_CHECK_EQUAL(filter.GetStatistics(CanCoder::Identifier::vehicleSpeed).droppedCount, 3u);
+
+        // A new rule for the same field replaces the old one
+        CANTEST_CHECK(filter.AddDeadband(CanCoder::Identifier::vehicleSpeed, "speed", 0));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 6));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 101, 7));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 101, 8));
+    }
+
+    void TestOnChange() {
+        CanFilter filter;
+        CanCoder coder;
+        uint32_t bootMask = CanCoder::GetFieldMask(CanCoder::Identifier::doorOpenStatuses, "bootIsOpen");
+        CANTEST_CHECK(filter.AddOnChange(CanCoder::Identifier::doorOpenStatuses, bootMask));
+        CANTEST_CHECK(AcceptBoot(filter, coder, false));
+        CANTEST_CHECK(!AcceptBoot(filter, coder, false));
+        CANTEST_CHECK(AcceptBoot(filter, coder, true));
+        CANTEST_CHECK(!AcceptBoot(filter, coder, true));
+        // Fields without a rule do not trigger
+        coder._doorOpenStatuses.bonnetIsOpen = true;
+        CANTEST_CHECK(!AcceptBoot(filter, coder, true));
+
+        CANTEST_CHECK(filter.AddOnChange(CanCoder::Identifier::doorOpenStatuses, CanFilter::allFields));
+        CANTEST_CHECK(AcceptBoot(filter, coder, true));
+        coder._doorOpenStatuses.bonnetIsOpen = false;
+        CANTEST_CHECK(AcceptBoot(filter, coder, true));
+
+        // Masks with fields the message does not have, or without fields, add nothing
+        filter.Clear();
+        CANTEST_CHECK(!filter.AddOnChange(CanCoder::Identifier::doorOpenStatuses, bootMask | 0x80000000));
+        CANTEST_CHECK(!filter.AddOnChange(CanCoder::Identifier::doorOpenStatuses, 0));
+        CANTEST_CHECK(!filter.AddOnChange((CanCoder::Identifier)0x123, CanFilter::allFields));
+        CANTEST_CHECK(AcceptBoot(filter, coder, true));
+        CANTEST_CHECK(AcceptBoot(filter, coder, true));
+    }
+
+    void TestRateLimit() {
+        CanFilter filter;
+        CanCoder coder;
+        CANTEST_CHECK(filter.SetRateLimit(CanCoder::Identifier::vehicleSpeed, 100));
+        CANTEST_CHECK(!filter.SetRateLimit((CanCoder::Identifier)0x123, 100));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 1000));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 100, 1099));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 1100));
+
+        // With a deadband both have to pass
+        CANTEST_CHECK(filter.AddDeadband(CanCoder::Identifier::vehicleSpeed, "speed", 5));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 1200));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 110, 1250));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 102, 1400));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 110, 1400));
+
+        // After a reset the next message is forwarded regardless of the rules
+        filter.Reset();
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 110, 1401));
+        CANTEST_CHECK_EQUAL(filter.GetStatistics(CanCoder::Identifier::vehicleSpeed).forwardedCount, 5u);
+        CANTEST_CHECK_EQUAL(filter.GetStatistics(CanCoder::Identifier::vehicleSpeed).droppedCount, 3u);
+
+        // Messages without rules are always forwarded
+        CANTEST_CHECK(AcceptBoot(filter, coder, false));
+        CANTEST_CHECK(AcceptBoot(filter, coder, false));
+    }
+
+    void TestTimeGoingBack() {
+        CanFilter filter;
+        CanCoder coder;
+        CANTEST_CHECK(filter.SetRateLimit(CanCoder::Identifier::vehicleSpeed, 100));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 1000));
+        // The interval restarts at the earlier timestamp instead of wrapping around
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 100, 10));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 100, 109));
+        CANTEST_CHECK(AcceptSpeed(filter, coder, 100, 110));
+        CANTEST_CHECK(!AcceptSpeed(filter, coder, 100, 209));
+
+        // Without a rate limit time going back does not matter
+        CanFilter unlimitedFilter;
+        CANTEST_CHECK(AcceptSpeed(unlimitedFilter, coder, 100, 1000));
+        CANTEST_CHECK(AcceptSpeed(unlimitedFilter, coder, 100, 10));
+    }
+
+    void TestFieldTypes() {
+        CanFilter filter;
+        CanCoder coder;
+        CANTEST_CHECK(filter.AddOnChange(CanCoder::Identifier::gearShifterPosition, CanFilter::allFields));
+        CANTEST_CHECK(filter.AddDeadband(CanCoder::Identifier::iDriveControler, "dialValue", 1000));
+        coder._identifier = CanCoder::Identifier::gearShifterPosition;
+        coder._gearShifterPosition.position = 'P';
+        CANTEST_CHECK(filter.Accept(coder, 0));
+        CANTEST_CHECK(!filter.Accept(coder, 1));
+        coder._gearShifterPosition.position = 'D';
+        CANTEST_CHECK(filter.Accept(coder, 2));
+
+        // Unsigned shorts above 0x7fff are not sign extended
+        coder._identifier = CanCoder::Identifier::iDriveControler;
+        coder._iDriveController.dialValue = 0xffff;
+        CANTEST_CHECK(filter.Accept(coder, 0));
+        coder._iDriveController.dialValue = 0xffff - 1000;
+        CANTEST_CHECK(!filter.Accept(coder, 1));
+        coder._iDriveController.dialValue = 0;
+        CANTEST_CHECK(filter.Accept(coder, 2));
+    }
+}
+
+int main() {
+    TestDeadband();
+    TestOnChange();
+    TestRateLimit();
+    TestTimeGoingBack();
+    TestFieldTypes();
+    return CanTestResult();
+}
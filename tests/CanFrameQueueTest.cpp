@@ -0,0 +1,127 @@
+// Unit test of CanFrameQueue
+//
+// Checks the order of frames when the positions wrap around the ring, dropping when
+// the ring is full, and a producer and a consumer on their own threads.
+
+#include "CanFrameQueue.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <thread>
+
+namespace {
+    // The sequence number of a frame is its timestamp
+    CanCoder::Frame CreateFrame(uint64_t inSequenceNumber) {
+        CanCoder::Frame frame = {};
+        frame.identifier = (uint32_t)(inSequenceNumber % 0x800);
+        frame.dataLengthCode = 8;
+        frame.timestamp = inSequenceNumber;
+        return frame;
+    }
+
+    void TestWraparound() {
+        CanFrameQueue<8> queue;
+        CanCoder::Frame frames[8];
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+        bool inOrder = true;
+        // Batches of 1-7 frames, so the positions wrap around at every offset in the ring
+        for (int round = 0; round < 1000; round++) {
+            size_t pushCount = 1 + round % 7;
+            for (size_t index = 0; index < pushCount; index++) {
+                frames[index] = CreateFrame(pushed + index);
+            }
+            size_t pushedCount = queue.PushBatch(frames, pushCount);
+            CANTEST_CHECK_EQUAL(pushedCount, pushCount);
+            pushed += pushedCount;
+            CANTEST_CHECK_EQUAL(queue.GetSize(), pushed - popped);
+
+            size_t poppedCount = queue.PopBatch(frames, 1 + (round * 3) % 8);
+            for (size_t index = 0; index < poppedCount; index++) {
+                inOrder = inOrder && frames[index].timestamp == popped + index;
+            }
+            popped += poppedCount;
+            // Keep room for the next batch
+            while (queue.GetSize() > 1) {
+                CanCoder::Frame frame;
+                CANTEST_CHECK(queue.Pop(frame));
+                inOrder = inOrder && frame.timestamp == popped;
+                popped++;
+            }
+        }
+        CANTEST_CHECK(inOrder);
+        CANTEST_CHECK_EQUAL(queue.GetDroppedCount(), 0u);
+    }
+
+    void TestFull() {
+        CanFrameQueue<4> queue;
+        CanCoder::Frame frames[6];
+        for (uint64_t index = 0; index < 6; index++) {
+            frames[index] = CreateFrame(index);
+        }
+        CANTEST_CHECK(queue.Push(frames[0]));
+        // Three frames fit, the last two are dropped
+        CANTEST_CHECK_EQUAL(queue.PushBatch(frames + 1, 5), 3u);
+        CANTEST_CHECK_EQUAL(queue.GetDroppedCount(), 2u);
+        CANTEST_CHECK(!queue.Push(frames[5]));
+        CANTEST_CHECK_EQUAL(queue.GetDroppedCount(), 3u);
+        CANTEST_CHECK_EQUAL(queue.GetSize(), 4u);
+
+        CanCoder::Frame frame;
+        for (uint64_t index = 0; index < 4; index++) {
+            CANTEST_CHECK(queue.Pop(frame));
+            CANTEST_CHECK_EQUAL(frame.timestamp, index);
+        }
+        CANTEST_CHECK(!queue.Pop(frame));
+        CANTEST_CHECK_EQUAL(queue.PopBatch(frames, 6), 0u);
+        // Room again after popping
+        CANTEST_CHECK(queue.Push(frames[5]));
+        CANTEST_CHECK(queue.Pop(frame));
+        CANTEST_CHECK_EQUAL(frame.timestamp, 5u);
+    }
+
+    void TestThreads() {
+        constexpr uint64_t frameCount = 200000;
+        CanFrameQueue<64> queue;
+        std::thread producer([&]() {
+            uint64_t sequenceNumber = 0;
+            while (sequenceNumber < frameCount) {
+                CanCoder::Frame frames[5];
+                size_t batchCount = (size_t)std::min<uint64_t>(1 + sequenceNumber % 5, frameCount - sequenceNumber);
+                for (size_t index = 0; index < batchCount; index++) {
+                    frames[index] = CreateFrame(sequenceNumber + index);
+                }
+                // Frames that did not fit are pushed again, so dropped frames are counted but none are lost
+                size_t pushedCount = queue.PushBatch(frames, batchCount);
+                sequenceNumber += pushedCount;
+                // Let the consumer run when it shares the core
+                if (pushedCount == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        uint64_t expected = 0;
+        bool inOrder = true;
+        CanCoder::Frame frames[16];
+        while (expected < frameCount) {
+            size_t poppedCount = queue.PopBatch(frames, 16);
+            if (poppedCount == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t index = 0; index < poppedCount; index++) {
+                inOrder = inOrder && frames[index].timestamp == expected && frames[index].identifier == expected % 0x800;
+                expected++;
+            }
+        }
+        producer.join();
+        CANTEST_CHECK(inOrder);
+        CANTEST_CHECK_EQUAL(expected, frameCount);
+        CANTEST_CHECK_EQUAL(queue.GetSize(), 0u);
+    }
+}
+
+int main() {
+    TestWraparound();
+    TestFull();
+    TestThreads();
+    return CanTestResult();
+}
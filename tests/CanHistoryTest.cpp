@@ -0,0 +1,74 @@
+// Unit test of CanHistory
+//
+// Checks the time windows of a history that has wrapped around and the statistics of
+// closed and open ended windows, whose rate does not depend on the bounds of the window.
+
+#include "CanHistory.h"
+#include "CanTest.h"
+
+namespace {
+    void TestWindows() {
+        // Values 0-99 every 10 ms, of which the last 64 are kept
+        CanHistory<int, 64> history;
+        for (int value = 0; value < 100; value++) {
+            history.Add((uint64_t)value * 10000, value);
+        }
+        CANTEST_CHECK_EQUAL(history.GetSize(), 64u);
+        CANTEST_CHECK_EQUAL(history[0].value, 36);
+        CANTEST_CHECK_EQUAL(history.GetLatest().value, 99);
+
+        size_t first;
+        CANTEST_CHECK_EQUAL(history.FindWindow(500000, 599999, first), 10u);
+        CANTEST_CHECK_EQUAL(history[first].value, 50);
+        CANTEST_CHECK_EQUAL(history.FindWindow(0, 365000, first), 1u);
+        CANTEST_CHECK_EQUAL(history.FindWindow(990001, UINT64_MAX, first), 0u);
+        CANTEST_CHECK_EQUAL(history.FindWindow(600000, 500000, first), 0u);
+        int sum = 0;
+        CANTEST_CHECK_EQUAL(history.ForEach(900000, UINT64_MAX, [&](const CanHistory<int, 64>::Entry& entry) { sum += entry.value; }), 10u);
+        CANTEST_CHECK_EQUAL(sum, 945);
+    }
+
+    void TestStatistics() {
+        CanHistory<int, 64> history;
+        for (int value = 0; value < 100; value++) {
+            history.Add((uint64_t)value * 10000, value % 7);
+        }
+        CanHistory<int, 64>::Statistics statistics;
+        CANTEST_CHECK(!history.GetStatistics(2000000, 3000000, statistics));
+
+        // 100 ms holding 100 values per second
+        CANTEST_CHECK(history.GetStatistics(500000, 599999, statistics));
+        CANTEST_CHECK_EQUAL(statistics.count, 10u);
+        CANTEST_CHECK_EQUAL(statistics.minimum, 0);
+        CANTEST_CHECK_EQUAL(statistics.maximum, 6);
+        CANTEST_CHECK_EQUAL(statistics.first.timestamp, 500000u);
+        CANTEST_CHECK_EQUAL(statistics.last.timestamp, 590000u);
+        CANTEST_CHECK(statistics.rate > 99.99 && statistics.rate < 100.01);
+
+        // The rate does not depend on the bounds of a window holding the same values
+        CANTEST_CHECK(history.GetStatistics(495001, 595000, statistics));
+        CANTEST_CHECK_EQUAL(statistics.count, 10u);
+        CANTEST_CHECK(statistics.rate > 99.99 && statistics.rate < 100.01);
+        CANTEST_CHECK(history.GetStatistics(500000, UINT64_MAX, statistics));
+        CANTEST_CHECK_EQUAL(statistics.count, 50u);
+        CANTEST_CHECK(statistics.rate > 99.99 && statistics.rate < 100.01);
+        CANTEST_CHECK(history.GetStatistics(500000, 2000000, statistics));
+        CANTEST_CHECK_EQUAL(statistics.count, 50u);
+        CANTEST_CHECK(statistics.rate > 99.99 && statistics.rate < 100.01);
+        CANTEST_CHECK(history.GetStatistics(500000, 500000, statistics));
+        CANTEST_CHECK_EQUAL(statistics.count, 1u);
+        CANTEST_CHECK_EQUAL(statistics.rate, 0.0);
+        CANTEST_CHECK(history.GetStatistics(990000, UINT64_MAX, statistics));
+        CANTEST_CHECK_EQUAL(statistics.count, 1u);
+        CANTEST_CHECK_EQUAL(statistics.rate, 0.0);
+
+        history.Clear();
+        CANTEST_CHECK(!history.GetStatistics(0, UINT64_MAX, statistics));
+    }
+}
+
+int main() {
+    TestWindows();
+    TestStatistics();
+    return CanTestResult();
+}
@@ -0,0 +1,75 @@
+// Unit test of CanLogReplay
+//
+// Parses small candump and ASC logs and checks the frames, including the lines that
+// must be skipped.
+
+#include "CanLogReplay.h"
+#include "CanTest.h"
+#include <string.h>
+#include <vector>
+
+namespace {
+    std::vector<CanCoder::Frame> ReadFrames(const char* inLog, CanLogReplay::Format inFormat) {
+        std::vector<CanCoder::Frame> frames;
+        CanTest::TemporaryFile file;
+        CANTEST_CHECK(file.Write(inLog, strlen(inLog)));
+        CanLogReplay replay;
+        CANTEST_CHECK(replay.Open(file.GetPath()));
+        CANTEST_CHECK(replay.GetFormat() == inFormat);
+        replay.ForEachFrame([&](const CanCoder::Frame& frame) {
+            frames.push_back(frame);
+        });
+        return frames;
+    }
+
+    void TestCandump() {
+        const char* log =
+            "(1436509052.249713) can0 1B4#2A36\n"
+            "(1436509052.250000) can0 130#0011223344556677\n"
+            // More than 8 bytes of data, skipped rather than truncated
+            "(1436509052.250100) can0 130#001122334455667788\n"
+            "(1436509052.250200) can0 1B4#R\n"
+            "(1436509052.250300) can0 1B4##1001122334455667788\n"
+            "(1436509052.3) can0 12345678#01\n";
+        std::vector<CanCoder::Frame> frames = ReadFrames(log, CanLogReplay::Format::candump);
+        CANTEST_CHECK_EQUAL(frames.size(), 3u);
+        if (frames.size() != 3) {
+            return;
+        }
+        CANTEST_CHECK_EQUAL(frames[0].identifier, 0x1B4u);
+        CANTEST_CHECK_EQUAL(frames[0].dataLengthCode, 2);
+        CANTEST_CHECK_EQUAL(frames[0].data[0], 0x2A);
+        CANTEST_CHECK_EQUAL(frames[0].data[1], 0x36);
+        CANTEST_CHECK_EQUAL(frames[0].timestamp, 1436509052249713ull);
+        CANTEST_CHECK_EQUAL(frames[1].identifier, 0x130u);
+        CANTEST_CHECK_EQUAL(frames[1].dataLengthCode, 8);
+        CANTEST_CHECK_EQUAL(frames[1].data[7], 0x77);
+        CANTEST_CHECK_EQUAL(frames[2].identifier, 0x12345678u | CanCoder::extendedIdentifierFlag);
+        CANTEST_CHECK_EQUAL(frames[2].timestamp, 1436509052300000ull);
+    }
+
+    void TestAsc() {
+        const char* log =
+            "date Fri Jul 10 08:17:32 am 2015\n"
+            "base hex  timestamps absolute\n"
+            "   0.009943 1  1B4             Rx   d 2 2A 36\n"
+            "   0.010000 1  1B4             Rx   r\n"
+            "   0.011000 1  130             Rx   d 9 00 11 22 33 44 55 66 77 88\n"
+            "   0.012000 1  1FFFFFFx        Rx   d 1 01\n";
+        std::vector<CanCoder::Frame> frames = ReadFrames(log, CanLogReplay::Format::asc);
+        CANTEST_CHECK_EQUAL(frames.size(), 2u);
+        if (frames.size() != 2) {
+            return;
+        }
+        CANTEST_CHECK_EQUAL(frames[0].identifier, 0x1B4u);
+        CANTEST_CHECK_EQUAL(frames[0].dataLengthCode, 2);
+        CANTEST_CHECK_EQUAL(frames[0].timestamp, 9943ull);
+        CANTEST_CHECK_EQUAL(frames[1].identifier, 0x1FFFFFFu | CanCoder::extendedIdentifierFlag);
+    }
+}
+
+int main() {
+    TestCandump();
+    TestAsc();
+    return CanTestResult();
+}
@@ -0,0 +1,76 @@
+// Unit test of CanPackedState
+//
+// Decodes every supported message and checks that the packed fields read back as the
+// fields of the coder, through Update, Pack and Unpack.
+
+#include "CanPackedState.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <string.h>
+#include <span>
+
+namespace {
+    void CheckFields(const CanCoder& coder, const CanPackedState::Values& values, CanCoder::Identifier identifier) {
+        const CanCoder::Field* fields;
+        size_t fieldCount = CanCoder::GetFields(identifier, fields);
+        for (size_t index = 0; index < fieldCount; index++) {
+            CANTEST_CHECK_EQUAL(CanPackedState::GetFieldValue(values, fields[index]), coder.GetFieldValue(fields[index]));
+        }
+    }
+
+    void TestUpdate() {
+        CanCoder::Identifier identifiers[CanCoder::messageCount];
+        size_t identifierCount = CanCoder::GetIdentifiers(identifiers, CanCoder::messageCount);
+        CanCoder coder;
+        CanPackedState state;
+        uint32_t seed = 1;
+        for (int round = 0; round < 100; round++) {
+            for (size_t index = 0; index < identifierCount; index++) {
+                uint8_t data[8];
+                for (uint8_t& byte : data) {
+                    seed = seed * 1103515245 + 12345;
+                    byte = (uint8_t)(seed >> 16);
+                }
+                if (coder.Decode((uint32_t)identifiers[index], 8, data)) {
+                    state.Update(coder);
+                    CANTEST_CHECK_EQUAL((uint32_t)state._values.identifier, (uint32_t)identifiers[index]);
+                    CheckFields(coder, state._values, identifiers[index]);
+                }
+            }
+        }
+
+        // Unknown identifiers leave the state alone
+        CanPackedState::Values values = state._values;
+        CanCoder unknown;
+        unknown._identifier = (CanCoder::Identifier)0x123;
+        CanPackedState::Update(unknown, values, nullptr);
+        CANTEST_CHECK(memcmp(&values, &state._values, sizeof(values)) == 0);
+
+        // Unpacking restores the fields and the additional data, encoding gives the same messages
+        CanCoder restored;
+        state.Unpack(restored);
+        for (size_t index = 0; index < identifierCount; index++) {
+            CheckFields(restored, state._values, identifiers[index]);
+            restored._identifier = identifiers[index];
+            coder._identifier = identifiers[index];
+            uint8_t expectedData[CanCoder::maximumDataLength] = {};
+            uint8_t restoredData[CanCoder::maximumDataLength] = {};
+            uint32_t identifier;
+            size_t expectedLength = coder.Encode(identifier, std::span<uint8_t>(expectedData));
+            CANTEST_CHECK_EQUAL(restored.Encode(identifier, std::span<uint8_t>(restoredData)), expectedLength);
+            CANTEST_CHECK(memcmp(restoredData, expectedData, sizeof(expectedData)) == 0);
+        }
+
+        // Packing everything gives the same values
+        CanPackedState packed;
+        packed.Pack(restored);
+        for (size_t index = 0; index < identifierCount; index++) {
+            CheckFields(restored, packed._values, identifiers[index]);
+        }
+    }
+}
+
+int main() {
+    TestUpdate();
+    return CanTestResult();
+}
@@ -0,0 +1,169 @@
+// Unit test of CanPayloadSearch
+//
+// Checks the parsing of text patterns, the hits of standard, extended and any identifier
+// patterns including groups of more than 64 patterns, and that patterns added or cleared
+// after a search are compiled by the next one.
+
+#include "CanPayloadSearch.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+    CanCoder::Frame MakeFrame(uint32_t identifier, uint8_t dataLengthCode, const uint8_t* data, uint64_t timestamp) {
+        CanCoder::Frame frame = {};
+        frame.identifier = identifier;
+        frame.dataLengthCode = dataLengthCode;
+        memcpy(frame.data, data, dataLengthCode);
+        frame.timestamp = timestamp;
+        return frame;
+    }
+
+    // Source with ForEachFrame, as CanCaptureReader and CanLogReplay
+    struct FrameSource {
+        std::vector<CanCoder::Frame> frames;
+
+        template <typename Function>
+        void ForEachFrame(Function&& inFunction) const {
+            for (const CanCoder::Frame& frame : frames) {
+                inFunction(frame);
+            }
+        }
+    };
+
+    void TestParse() {
+        CanPayloadSearch search;
+        CANTEST_CHECK_EQUAL(search.AddPattern("130#xx0Exxx4"), 0);
+        CANTEST_CHECK_EQUAL(search.AddPattern("12345678#FF"), 1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("*#xx??A5"), 2);
+        CANTEST_CHECK_EQUAL(search.AddPattern("7ff#"), 3);
+        CANTEST_CHECK_EQUAL(search.AddPattern("1fffffff#0123456789abcdef"), 4);
+        CANTEST_CHECK_EQUAL(search.GetPatternCount(), 5u);
+
+        // Not a valid pattern
+        CANTEST_CHECK_EQUAL(search.AddPattern("130"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("13#FF"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("1300#FF"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("800#FF"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("20000000#FF"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("13g#FF"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("**#FF"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("130#F"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("130#FG"), -1);
+        CANTEST_CHECK_EQUAL(search.AddPattern("130#001122334455667788"), -1);
+        uint8_t bytes[9] = {};
+        CANTEST_CHECK_EQUAL(search.AddPattern(0x130, bytes, bytes, 9), -1);
+        CANTEST_CHECK_EQUAL(search.GetPatternCount(), 5u);
+    }
+
+    void TestHits() {
+        CanPayloadSearch search;
+        search.AddPattern("130#xx0Exxx4");
+        search.AddPattern("130#xx0E");
+        search.AddPattern("12345678#FF");
+        search.AddPattern("*#xxxxA5");
+
+        const uint8_t match[4] = { 0x00, 0x0E, 0x00, 0xF4 };
+        const uint8_t lowNibbleDiffers[4] = { 0x00, 0x0E, 0x00, 0x45 };
+        const uint8_t any[3] = { 0xFF, 0xFF, 0xA5 };
+        std::vector<CanCoder::Frame> frames;
+        frames.push_back(MakeFrame(0x130, 4, match, 10));
+        frames.push_back(MakeFrame(0x130, 4, lowNibbleDiffers, 11));
+        // Too short for byte 3, the data past the length does not count
+        CanCoder::Frame shortFrame = MakeFrame(0x130, 2, match, 12);
+        shortFrame.data[3] = 0xF4;
+        frames.push_back(shortFrame);
+        // Another identifier
+        frames.push_back(MakeFrame(0x131, 4, match, 13));
+        frames.push_back(MakeFrame(0x12345678 | CanCoder::extendedIdentifierFlag, 3, any, 14));
+        // Standard identifier 0x678 is not the extended identifier
+        frames.push_back(MakeFrame(0x678, 3, any, 15));
+
+        std::vector<CanPayloadSearch::Hit> hits;
+        CANTEST_CHECK_EQUAL(search.Search(frames.data(), frames.size(), hits, 100), 7u);
+        struct Expected {
+            uint64_t frameNumber;
+            uint32_t patternNumber;
+        };
+        const Expected expected[] = { { 100, 0 }, { 100, 1 }, { 101, 1 }, { 102, 1 }, { 104, 2 }, { 104, 3 }, { 105, 3 } };
+        CANTEST_CHECK_EQUAL(hits.size(), 7u);
+        for (size_t index = 0; index < hits.size() && index < sizeof(expected) / sizeof(expected[0]); index++) {
+            CANTEST_CHECK_EQUAL(hits[index].frameNumber, expected[index].frameNumber);
+            CANTEST_CHECK_EQUAL(hits[index].patternNumber, expected[index].patternNumber);
+            CANTEST_CHECK_EQUAL(hits[index].timestamp, expected[index].frameNumber - 100 + 10);
+            CANTEST_CHECK_EQUAL(hits[index].identifier, frames[expected[index].frameNumber - 100].identifier);
+        }
+
+        // The same hits from a source, numbered from 0
+        FrameSource source;
+        source.frames = frames;
+        std::vector<CanPayloadSearch::Hit> sourceHits;
+        CANTEST_CHECK_EQUAL(search.Search(source, sourceHits), hits.size());
+        for (size_t index = 0; index < sourceHits.size() && index < hits.size(); index++) {
+            CANTEST_CHECK_EQUAL(sourceHits[index].frameNumber + 100, hits[index].frameNumber);
+            CANTEST_CHECK_EQUAL(sourceHits[index].patternNumber, hits[index].patternNumber);
+        }
+    }
+
+    void TestLargeGroup() {
+        // 150 patterns of one identifier span 3 blocks of 64, each matches one value of byte 0
+        CanPayloadSearch search;
+        for (int patternNumber = 0; patternNumber < 150; patternNumber++) {
+            uint8_t value = (uint8_t)patternNumber;
+            uint8_t mask = 0xFF;
+            CANTEST_CHECK_EQUAL(search.AddPattern(0x200, &value, &mask, 1), patternNumber);
+        }
+        // Matches every frame of any length
+        CANTEST_CHECK_EQUAL(search.AddPattern(0x200, nullptr, nullptr, 0), 150);
+
+        std::vector<CanCoder::Frame> frames;
+        for (int value = 0; value < 256; value++) {
+            uint8_t data[1] = { (uint8_t)value };
+            frames.push_back(MakeFrame(0x200, 1, data, 0));
+        }
+        std::vector<CanPayloadSearch::Hit> hits;
+        CANTEST_CHECK_EQUAL(search.Search(frames.data(), frames.size(), hits), 150u + 256u);
+        size_t index = 0;
+        for (uint64_t frameNumber = 0; frameNumber < 256 && index < hits.size(); frameNumber++) {
+            if (frameNumber < 150) {
+                CANTEST_CHECK_EQUAL(hits[index].frameNumber, frameNumber);
+                CANTEST_CHECK_EQUAL(hits[index].patternNumber, frameNumber);
+                index++;
+            }
+            CANTEST_CHECK_EQUAL(hits[index].frameNumber, frameNumber);
+            CANTEST_CHECK_EQUAL(hits[index].patternNumber, 150u);
+            index++;
+        }
+    }
+
+    void TestCompile() {
+        CanPayloadSearch search;
+        const uint8_t data[1] = { 0x42 };
+        CanCoder::Frame frame = MakeFrame(0x100, 1, data, 0);
+        std::vector<CanPayloadSearch::Hit> hits;
+        CANTEST_CHECK_EQUAL(search.Search(&frame, 1, hits), 0u);
+
+        // Patterns added after a search are compiled by the next one
+        search.AddPattern("100#42");
+        CANTEST_CHECK_EQUAL(search.Search(&frame, 1, hits), 1u);
+        search.AddPattern("*#4x");
+        search.Compile();
+        CANTEST_CHECK_EQUAL(search.Search(&frame, 1, hits), 2u);
+
+        search.Clear();
+        CANTEST_CHECK_EQUAL(search.GetPatternCount(), 0u);
+        CANTEST_CHECK_EQUAL(search.Search(&frame, 1, hits), 0u);
+        CANTEST_CHECK_EQUAL(search.AddPattern("100#x2"), 0);
+        CANTEST_CHECK_EQUAL(search.Search(&frame, 1, hits), 1u);
+        CANTEST_CHECK_EQUAL(hits.size(), 4u);
+    }
+}
+
+int main() {
+    TestParse();
+    TestHits();
+    TestLargeGroup();
+    TestCompile();
+    return CanTestResult();
+}
@@ -0,0 +1,133 @@
+// Unit test of CanScheduler
+//
+// Checks that frames are sent in order of their due time, that missed cycles are
+// skipped, removing jobs and the failures of the sink.
+
+#include "CanScheduler.h"
+#include "CanTest.h"
+#include <vector>
+
+namespace {
+    struct Sent {
+        std::vector<CanCoder::Frame> frames;
+        bool fail = false;
+    };
+
+    bool Send(void* inContext, const CanCoder::Frame& inFrame) {
+        Sent* sent = (Sent*)inContext;
+        sent->frames.push_back(inFrame);
+        return !sent->fail;
+    }
+
+    constexpr uint32_t gearShifterPosition = (uint32_t)CanCoder::Identifier::gearShifterPosition;
+    constexpr uint32_t iDriveController = (uint32_t)CanCoder::Identifier::iDriveControler;
+    constexpr uint32_t setDateTime = (uint32_t)CanCoder::Identifier::setDateTime;
+
+    void TestOrder() {
+        CanCoder coder;
+        Sent sent;
+        CanScheduler scheduler(coder, Send, &sent);
+        CANTEST_CHECK_EQUAL(scheduler.NextDueTime(), CanScheduler::never);
+        // Added out of order of their due times
+        CANTEST_CHECK(scheduler.AddPeriodic(CanCoder::Identifier::gearShifterPosition, 100, 30) >= 0);
+        CANTEST_CHECK(scheduler.AddPeriodic(CanCoder::Identifier::iDriveControler, 40, 15) >= 0);
+        CANTEST_CHECK(scheduler.AddOneShot(CanCoder::Identifier::setDateTime, 45) >= 0);
+        CANTEST_CHECK_EQUAL(scheduler.NextDueTime(), 15u);
+
+        CANTEST_CHECK_EQUAL(scheduler.Poll(14), 0u);
+        for (uint64_t now = 15; now <= 200; now++) {
+            scheduler.Poll(now);
+        }
+        const uint64_t dueTimes[] = { 15, 30, 45, 55, 95, 130, 135, 175 };
+        const uint32_t identifiers[] = {
+            iDriveController, gearShifterPosition, setDateTime, iDriveController,
+            iDriveController, gearShifterPosition, iDriveController, iDriveController
+        };
+        CANTEST_CHECK_EQUAL(sent.frames.size(), 8u);
+        for (size_t index = 0; index < sent.frames.size() && index < 8; index++) {
+            CANTEST_CHECK_EQUAL(sent.frames[index].timestamp, dueTimes[index]);
+            CANTEST_CHECK_EQUAL(sent.frames[index].identifier, identifiers[index]);
+        }
+        CANTEST_CHECK_EQUAL(scheduler.NextDueTime(), 215u);
+    }
+
+    void TestSkippedCycles() {
+        CanCoder coder;
+        Sent sent;
+        CanScheduler scheduler(coder, Send, &sent);
+        scheduler.AddPeriodic(CanCoder::Identifier::gearShifterPosition, 100, 0);
+        CANTEST_CHECK_EQUAL(scheduler.Poll(0), 1u);
+        // Woken up late: the cycles at 100-300 are missed, one frame is sent instead of a burst
+        CANTEST_CHECK_EQUAL(scheduler.Poll(350), 1u);
+        CANTEST_CHECK_EQUAL(sent.frames.back().timestamp, 100u);
+        // The cycle stays on the grid of the first due time
+        CANTEST_CHECK_EQUAL(scheduler.NextDueTime(), 400u);
+        CANTEST_CHECK_EQUAL(scheduler.Poll(405), 1u);
+        CANTEST_CHECK_EQUAL(sent.frames.back().timestamp, 400u);
+        CANTEST_CHECK_EQUAL(scheduler.NextDueTime(), 500u);
+
+        // One poll sends each job once, even when several of its cycles are due
+        scheduler.AddPeriodic(CanCoder::Identifier::iDriveControler, 10, 500);
+        CANTEST_CHECK_EQUAL(scheduler.Poll(555), 2u);
+        CANTEST_CHECK_EQUAL(scheduler.NextDueTime(), 560u);
+    }
+
+    void TestRemove() {
+        CanCoder coder;
+        Sent sent;
+        CanScheduler scheduler(coder, Send, &sent);
+        int gearJob = scheduler.AddPeriodic(CanCoder::Identifier::gearShifterPosition, 10, 0);
+        int iDriveJob = scheduler.AddPeriodic(CanCoder::Identifier::iDriveControler, 10, 5);
+        CANTEST_CHECK(scheduler.Remove(gearJob));
+        CANTEST_CHECK(!scheduler.Remove(gearJob));
+        CANTEST_CHECK(!scheduler.Remove(-1));
+        CANTEST_CHECK(!scheduler.Remove((int)CanScheduler::maximumJobCount));
+        CANTEST_CHECK_EQUAL(scheduler.Poll(5), 1u);
+        CANTEST_CHECK_EQUAL(sent.frames.back().identifier, iDriveController);
+
+        // A new job reusing the number of the removed one is not confused with its heap entry
+        int newJob = scheduler.AddOneShot(CanCoder::Identifier::doorLockControl, 100);
+        CANTEST_CHECK_EQUAL(newJob, gearJob);
+        CANTEST_CHECK(scheduler.Remove(iDriveJob));
+        CANTEST_CHECK_EQUAL(scheduler.Poll(99), 0u);
+        CANTEST_CHECK_EQUAL(scheduler.Poll(100), 1u);
+        CANTEST_CHECK_EQUAL(sent.frames.back().identifier, (uint32_t)CanCoder::Identifier::doorLockControl);
+        // One shot jobs are gone after sending
+        CANTEST_CHECK(!scheduler.Remove(newJob));
+        CANTEST_CHECK_EQUAL(scheduler.Poll(1000), 0u);
+
+        // Many adds and removes do not fill up the heap with stale entries
+        for (int round = 0; round < 1000; round++) {
+            int job = scheduler.AddPeriodic(CanCoder::Identifier::gearShifterPosition, 10, 2000);
+            CANTEST_CHECK(job >= 0);
+            scheduler.Remove(job);
+        }
+    }
+
+    void TestInvalidJobs() {
+        CanCoder coder;
+        Sent sent;
+        CanScheduler scheduler(coder, Send, &sent);
+        CANTEST_CHECK_EQUAL(scheduler.AddPeriodic(CanCoder::Identifier::vehicleSpeed, 10, 0), -1);
+        CANTEST_CHECK_EQUAL(scheduler.AddPeriodic(CanCoder::Identifier::gearShifterPosition, 0, 0), -1);
+        for (size_t index = 0; index < CanScheduler::maximumJobCount; index++) {
+            CANTEST_CHECK(scheduler.AddOneShot(CanCoder::Identifier::gearShifterPosition, 0) >= 0);
+        }
+        CANTEST_CHECK_EQUAL(scheduler.AddOneShot(CanCoder::Identifier::gearShifterPosition, 0), -1);
+
+        // Failures of the sink are counted, the identifier of the last decode is kept
+        coder._identifier = CanCoder::Identifier::vehicleSpeed;
+        sent.fail = true;
+        CANTEST_CHECK_EQUAL(scheduler.Poll(0), CanScheduler::maximumJobCount);
+        CANTEST_CHECK_EQUAL(scheduler.GetFailedCount(), CanScheduler::maximumJobCount);
+        CANTEST_CHECK(coder._identifier == CanCoder::Identifier::vehicleSpeed);
+    }
+}
+
+int main() {
+    TestOrder();
+    TestSkippedCycles();
+    TestRemove();
+    TestInvalidJobs();
+    return CanTestResult();
+}
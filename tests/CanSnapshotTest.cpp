@@ -0,0 +1,112 @@
+// Unit test of CanSnapshot
+//
+// One writer publishes states whose fields, spread over the whole CanCoder, all hold the
+// same counter while readers spin reading them. Checks that no reader ever sees a torn
+// state, that versions and counters only increase, and that the writer finishes all its
+// publishes while the readers keep reading.
+
+#include "CanSnapshot.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t readerCount = 3;
+    constexpr int publishCount = 200000;
+
+    void SetCounter(CanCoder& coder, int counter) {
+        coder._vehicleSpeed.speed = counter;
+        coder._dateTime.year = counter;
+        coder._dateTime.month = counter;
+        coder._dateTime.day = counter;
+        coder._dateTime.hour = counter;
+        coder._dateTime.minute = counter;
+        coder._dateTime.second = counter;
+        coder._iDriveController.dialValue = (unsigned short)counter;
+    }
+
+    // True when all fields hold the same counter
+    bool IsWhole(const CanCoder& coder) {
+        int counter = coder._vehicleSpeed.speed;
+        return coder._dateTime.year == counter && coder._dateTime.month == counter && coder._dateTime.day == counter &&
+            coder._dateTime.hour == counter && coder._dateTime.minute == counter && coder._dateTime.second == counter &&
+            coder._iDriveController.dialValue == (unsigned short)counter;
+    }
+
+    void TestSingleThread() {
+        CanSnapshot snapshot;
+        CanCoder coder;
+        CANTEST_CHECK_EQUAL(snapshot.GetVersion(), 0u);
+        CANTEST_CHECK_EQUAL(snapshot.Read(coder), 0u);
+        CANTEST_CHECK_EQUAL(coder._vehicleSpeed.speed, 0);
+
+        SetCounter(coder, 42);
+        snapshot.Publish(coder);
+        CanCoder state;
+        uint64_t version = 0;
+        CANTEST_CHECK(snapshot.TryRead(state, version));
+        CANTEST_CHECK_EQUAL(version, 1u);
+        CANTEST_CHECK_EQUAL(snapshot.GetVersion(), 1u);
+        CANTEST_CHECK(IsWhole(state));
+        CANTEST_CHECK_EQUAL(state._vehicleSpeed.speed, 42);
+    }
+
+    void TestReaders() {
+        CanSnapshot snapshot;
+        std::atomic<bool> writing{ true };
+        std::vector<uint64_t> tornCounts(readerCount, 0);
+        std::vector<uint64_t> outOfOrderCounts(readerCount, 0);
+        std::atomic<size_t> startedReaderCount{ 0 };
+        std::vector<std::thread> readers;
+        for (size_t reader = 0; reader < readerCount; reader++) {
+            readers.emplace_back([&, reader] {
+                CanCoder state;
+                uint64_t lastVersion = 0;
+                int lastCounter = 0;
+                snapshot.Read(state);
+                startedReaderCount++;
+                while (writing.load(std::memory_order_relaxed)) {
+                    uint64_t version = snapshot.Read(state);
+                    tornCounts[reader] += !IsWhole(state);
+                    // Publish n carries counter n, so the version is the counter
+                    outOfOrderCounts[reader] += version < lastVersion || state._vehicleSpeed.speed < lastCounter ||
+                        (uint64_t)state._vehicleSpeed.speed != version;
+                    lastVersion = version;
+                    lastCounter = state._vehicleSpeed.speed;
+                }
+            });
+        }
+
+        // The writer never waits for the readers, it publishes as fast as it can while they read
+        while (startedReaderCount.load() < readerCount) {
+            std::this_thread::yield();
+        }
+        CanCoder coder;
+        for (int counter = 1; counter <= publishCount; counter++) {
+            SetCounter(coder, counter);
+            snapshot.Publish(coder);
+        }
+        CANTEST_CHECK_EQUAL(snapshot.GetVersion(), (uint64_t)publishCount);
+        writing.store(false, std::memory_order_relaxed);
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+
+        for (size_t reader = 0; reader < readerCount; reader++) {
+            CANTEST_CHECK_EQUAL(tornCounts[reader], 0u);
+            CANTEST_CHECK_EQUAL(outOfOrderCounts[reader], 0u);
+        }
+        CanCoder state;
+        CANTEST_CHECK_EQUAL(snapshot.Read(state), (uint64_t)publishCount);
+        CANTEST_CHECK(IsWhole(state));
+        CANTEST_CHECK_EQUAL(state._vehicleSpeed.speed, publishCount);
+    }
+}
+
+int main() {
+    TestSingleThread();
+    TestReaders();
+    return CanTestResult();
+}
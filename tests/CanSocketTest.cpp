@@ -0,0 +1,108 @@
+// Unit test of CanSocket
+//
+// Both ends of a socketpair are attached, frames sent in a batch with sendmmsg must be
+// received unchanged with recvmmsg. A socketpair has no kernel filter, so the identifier
+// filter of the receiving end is applied by CanSocket itself.
+
+#include "CanSocket.h"
+#include "CanTest.h"
+#include <string.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <sys/socket.h>
+
+namespace {
+    constexpr uint32_t vehicleSpeed = (uint32_t)CanCoder::Identifier::vehicleSpeed;
+    constexpr uint32_t doorOpenStatuses = (uint32_t)CanCoder::Identifier::doorOpenStatuses;
+
+    CanCoder::Frame CreateFrame(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t inFirstByte) {
+        CanCoder::Frame frame = {};
+        frame.identifier = inIdentifier;
+        frame.dataLengthCode = inDataLengthCode;
+        for (uint8_t index = 0; index < inDataLengthCode; index++) {
+            frame.data[index] = (uint8_t)(inFirstByte + index);
+        }
+        return frame;
+    }
+
+    bool SameFrame(const CanCoder::Frame& inFrame1, const CanCoder::Frame& inFrame2) {
+        return inFrame1.identifier == inFrame2.identifier && inFrame1.dataLengthCode == inFrame2.dataLengthCode &&
+            memcmp(inFrame1.data, inFrame2.data, inFrame1.dataLengthCode) == 0;
+    }
+
+    bool AttachPair(CanSocket& outSender, CanSocket& outReceiver, bool inFilterIdentifiers) {
+        int fileDescriptors[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fileDescriptors) != 0) {
+            return false;
+        }
+        return outSender.Attach(fileDescriptors[0], false) && outReceiver.Attach(fileDescriptors[1], inFilterIdentifiers);
+    }
+
+    void TestBatch() {
+        CanSocket sender;
+        CanSocket receiver;
+        CANTEST_CHECK(AttachPair(sender, receiver, false));
+
+        // More than one batch, with standard and extended identifiers
+        constexpr size_t frameCount = CanSocket::maximumBatchSize + 10;
+        CanCoder::Frame frames[frameCount];
+        for (size_t index = 0; index < frameCount; index++) {
+            uint32_t identifier = index % 4 == 3 ? (0x1234567 | CanCoder::extendedIdentifierFlag) : (uint32_t)(index * 7 % 0x800);
+            frames[index] = CreateFrame(identifier, (uint8_t)(index % 9), (uint8_t)index);
+        }
+        CANTEST_CHECK_EQUAL(sender.Send(frames, frameCount), frameCount);
+
+        CanCoder::Frame received[frameCount];
+        size_t receivedCount = receiver.Receive(received, frameCount);
+        CANTEST_CHECK_EQUAL(receivedCount, CanSocket::maximumBatchSize);
+        receivedCount += receiver.Receive(received + receivedCount, frameCount - receivedCount);
+        CANTEST_CHECK_EQUAL(receivedCount, frameCount);
+        for (size_t index = 0; index < receivedCount; index++) {
+            CANTEST_CHECK(SameFrame(received[index], frames[index]));
+        }
+        CANTEST_CHECK_EQUAL(receiver.Receive(received, frameCount, false), 0u);
+    }
+
+    void TestFilter() {
+        CanSocket sender;
+        CanSocket receiver;
+        CANTEST_CHECK(AttachPair(sender, receiver, true));
+        const CanCoder::Frame frames[] = {
+            CreateFrame(0x123, 8, 0x10),
+            CreateFrame(vehicleSpeed, 2, 0x20),
+            // The identifier of doorOpenStatuses as an extended identifier
+            CreateFrame(doorOpenStatuses | CanCoder::extendedIdentifierFlag, 3, 0x30),
+            CreateFrame(doorOpenStatuses, 3, 0x40),
+            CreateFrame(0x7FF, 1, 0x50)
+        };
+        CANTEST_CHECK_EQUAL(sender.Send(frames, 5), 5u);
+        // Remote frames are skipped, also when their identifier passes the filter
+        can_frame remoteFrame = {};
+        remoteFrame.can_id = vehicleSpeed | CAN_RTR_FLAG;
+        CANTEST_CHECK_EQUAL(write(sender.GetFileDescriptor(), &remoteFrame, sizeof(remoteFrame)), (ssize_t)sizeof(remoteFrame));
+
+        CanCoder::Frame received[8];
+        size_t receivedCount = receiver.Receive(received, 8);
+        CANTEST_CHECK_EQUAL(receivedCount, 2u);
+        if (receivedCount == 2) {
+            CANTEST_CHECK(SameFrame(received[0], frames[1]));
+            CANTEST_CHECK(SameFrame(received[1], frames[3]));
+        }
+    }
+
+    void TestInvalid() {
+        CanSocket socket;
+        CanCoder::Frame frame = CreateFrame(vehicleSpeed, 2, 0);
+        CANTEST_CHECK(!socket.Attach(-1));
+        CANTEST_CHECK(!socket.Send(frame));
+        CANTEST_CHECK_EQUAL(socket.Receive(&frame, 1, false), 0u);
+        CANTEST_CHECK(!socket.Open("an interface name that is too long"));
+    }
+}
+
+int main() {
+    TestBatch();
+    TestFilter();
+    TestInvalid();
+    return CanTestResult();
+}
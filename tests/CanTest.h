@@ -0,0 +1,68 @@
+// Checks shared by the unit tests
+//
+// A failed check prints its file, line and expression and the test continues, so one
+// run reports all failures. main returns CanTestResult(), 1 when a check failed.
+//     CANTEST_CHECK(coder.Decode(0x1B4, 2, data));
+//     CANTEST_CHECK_EQUAL(coder._vehicleSpeed.speed, 42);
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+namespace CanTest {
+    inline int failureCount = 0;
+
+    inline void Fail(const char* inFile, int inLine, const char* inExpression) {
+        fprintf(stderr, "%s:%d: check failed: %s\n", inFile, inLine, inExpression);
+        failureCount++;
+    }
+
+    // Temporary file that is removed when it goes out of scope
+    class TemporaryFile {
+    public:
+        TemporaryFile() {
+            char path[] = "/tmp/CanTestXXXXXX";
+            int fileDescriptor = mkstemp(path);
+            if (fileDescriptor >= 0) {
+                close(fileDescriptor);
+                _path = path;
+            }
+        }
+        TemporaryFile(const TemporaryFile&) = delete;
+        TemporaryFile& operator=(const TemporaryFile&) = delete;
+        ~TemporaryFile() {
+            if (!_path.empty()) {
+                unlink(_path.c_str());
+            }
+        }
+
+        const char* GetPath() const { return _path.c_str(); }
+
+        // Replace the contents of the file
+        bool Write(const void* inData, size_t inSize) const {
+            FILE* file = fopen(_path.c_str(), "wb");
+            if (file == nullptr) {
+                return false;
+            }
+            bool written = fwrite(inData, 1, inSize, file) == inSize;
+            return fclose(file) == 0 && written;
+        }
+
+    private:
+        std::string _path;
+    };
+}
+
+#define CANTEST_CHECK(expression) ((expression) ? (void)0 : CanTest::Fail(__FILE__, __LINE__, #expression))
+#define CANTEST_CHECK_EQUAL(actual, expected) CANTEST_CHECK((actual) == (expected))
+
+inline int CanTestResult() {
+    if (CanTest::failureCount != 0) {
+        fprintf(stderr, "%d checks failed\n", CanTest::failureCount);
+        return 1;
+    }
+    return 0;
+}
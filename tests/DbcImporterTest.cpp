@@ -0,0 +1,103 @@
+// Unit test of the code generated by DbcImporter
+//
+// SampleCoder is generated from DbcImporterSample.dbc when building. Checks little and big
+// endian, signed and unsigned signals against known frames, that encoding changes only the
+// bits of the signals, and that decoding and encoding random data gives the same data,
+// including the bytes and the multiplexed signal that are not decoded.
+
+#include "SampleCoder.h"
+#include "CanTest.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+    bool EncodesTo(SampleCoder& coder, uint32_t inIdentifier, uint8_t inDataLengthCode, const uint8_t* inData) {
+        uint32_t identifier = 0;
+        uint8_t dataLengthCode = 0;
+        uint8_t data[8] = {};
+        coder.Encode(identifier, dataLengthCode, data);
+        return identifier == inIdentifier && dataLengthCode == inDataLengthCode && memcmp(data, inData, inDataLengthCode) == 0;
+    }
+
+    void TestLittleEndian() {
+        SampleCoder coder;
+        uint8_t data[8] = { 0x10, 0x27, 0xD8, 0x31, 0xFC, 0xAA, 0xBB, 0xCC };
+        CANTEST_CHECK(coder.Decode(0x100, 8, data));
+        CANTEST_CHECK(coder._identifier == SampleCoder::Identifier::engineStatus);
+        CANTEST_CHECK_EQUAL(coder._engineStatus.engineSpeed, 10000);
+        CANTEST_CHECK_EQUAL(coder._engineStatus.coolantTemperature, -40);
+        CANTEST_CHECK_EQUAL(coder._engineStatus.engineRunning, true);
+        // 0x3C3 in bits 28-37, 10 bit two's complement
+        CANTEST_CHECK_EQUAL(coder._engineStatus.oilTemperature, -61);
+        CANTEST_CHECK(coder.ToString() == "ID:ENGINE_STATUS engineSpeed:10000 coolantTemperature:-40 engineRunning:1 oilTemperature:-61");
+        CANTEST_CHECK(EncodesTo(coder, 0x100, 8, data));
+
+        coder._engineStatus.engineSpeed = 0xBEEF;
+        coder._engineStatus.coolantTemperature = 127;
+        coder._engineStatus.engineRunning = false;
+        coder._engineStatus.oilTemperature = -512;
+        const uint8_t encoded[8] = { 0xEF, 0xBE, 0x7F, 0x00, 0xE0, 0xAA, 0xBB, 0xCC };
+        CANTEST_CHECK(EncodesTo(coder, 0x100, 8, encoded));
+
+        // Too short for the oil temperature
+        CANTEST_CHECK(!coder.Decode(0x100, 4, data));
+        CANTEST_CHECK(!coder.Decode(0x101, 8, data));
+        CANTEST_CHECK(!coder.Decode(0x100, 9, data));
+    }
+
+    void TestBigEndian() {
+        SampleCoder coder;
+        uint8_t data[6] = { 0xAB, 0xCD, 0xEF, 0x92, 0x35, 0x99 };
+        CANTEST_CHECK(coder.Decode(0x200, 6, data));
+        // Byte 0 and the high nibble of byte 1
+        CANTEST_CHECK_EQUAL(coder._brakePressure.pressure, 0xABC);
+        // The low nibble of byte 1, byte 2 and the high bit of byte 3, 0x1BDF in 13 bit two's complement
+        CANTEST_CHECK_EQUAL(coder._brakePressure.torque, -1057);
+        CANTEST_CHECK_EQUAL(coder._brakePressure.counter, 5);
+        CANTEST_CHECK_EQUAL(coder._brakePressure.mode, 1);
+        CANTEST_CHECK(EncodesTo(coder, 0x200, 6, data));
+
+        // The low 7 bits of byte 3, the high nibble of byte 4 and the multiplexed bits of byte 5 are kept
+        coder._brakePressure.pressure = 1;
+        coder._brakePressure.torque = 4095;
+        coder._brakePressure.counter = 15;
+        coder._brakePressure.mode = 2;
+        const uint8_t encoded[6] = { 0x00, 0x17, 0xFF, 0x92, 0x3F, 0x9A };
+        CANTEST_CHECK(EncodesTo(coder, 0x200, 6, encoded));
+        coder._brakePressure.torque = -4096;
+        const uint8_t negative[6] = { 0x00, 0x18, 0x00, 0x12, 0x3F, 0x9A };
+        CANTEST_CHECK(EncodesTo(coder, 0x200, 6, negative));
+
+        // A message that was never decoded is encoded with the data length code of the DBC file
+        SampleCoder newCoder;
+        newCoder._identifier = SampleCoder::Identifier::brakePressure;
+        newCoder._brakePressure.torque = -1;
+        const uint8_t minusOne[6] = { 0x00, 0x0F, 0xFF, 0x80, 0x00, 0x00 };
+        CANTEST_CHECK(EncodesTo(newCoder, 0x200, 6, minusOne));
+    }
+
+    void TestRoundTrip() {
+        // Every bit of random data survives a decode and encode
+        srand(1);
+        SampleCoder coder;
+        bool same = true;
+        for (int index = 0; index < 10000; index++) {
+            uint32_t identifier = index % 2 == 0 ? 0x100 : 0x200;
+            uint8_t dataLengthCode = (uint8_t)(identifier == 0x100 ? 5 + index / 2 % 4 : 6 + index / 2 % 3);
+            uint8_t data[8];
+            for (uint8_t& byte : data) {
+                byte = (uint8_t)rand();
+            }
+            same = same && coder.Decode(identifier, dataLengthCode, data) && EncodesTo(coder, identifier, dataLengthCode, data);
+        }
+        CANTEST_CHECK(same);
+    }
+}
+
+int main() {
+    TestLittleEndian();
+    TestBigEndian();
+    TestRoundTrip();
+    return CanTestResult();
+}
@@ -0,0 +1,467 @@
+/*
+ * SPDX-FileCopyrightText: Hans Lennaerts (cancoder@lennaerts.eu)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * DbcImporter
+ *
+ * Generates a coder class from a DBC file
+ *
+ * Usage: DbcImporter <input.dbc> <ClassName> [output directory]
+ *
+ * The generated <ClassName>.h and <ClassName>.cpp work like CanCoder: there is an
+ * Identifier enum, a struct member per message and Decode, Encode and ToString
+ * functions. Signals are described with CanSignal, so the generated code is as fast
+ * as the hand written messages in CanCoder.
+ * Like CanCoder, the generated coder keeps the data that was not decoded. For each
+ * message the data of the latest decode is stored in its AdditionalData. When
+ * encoding, the signals are inserted into that data, so all bits that are not part
+ * of a signal are encoded as they were decoded.
+ *
+ * Supported are standard (11 bit) identifiers and signals of 1-32 bits.
+ * Other messages and signals, including multiplexed signals, are skipped. The bits
+ * of skipped signals are still preserved as uncoded data.
+ *
+ *
+ * File history:
+ * Version 1: initial
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Signal {
+        std::string name;
+        std::string memberName;
+        unsigned startBit;
+        unsigned length;
+        bool bigEndian;
+        bool isSigned;
+        std::string scale;
+        std::string offset;
+        std::string unit;
+    };
+
+    struct Message {
+        uint32_t identifier;
+        std::string name;
+        std::string memberName;
+        unsigned dataLengthCode;
+        std::vector<Signal> signals;
+    };
+
+    // Convert a DBC name like "ENGINE_SPEED" or "EngineSpeed" to "engineSpeed"
+    std::string ToMemberName(const std::string& name) {
+        std::string memberName;
+        std::stringstream parts(name);
+        std::string part;
+        while (std::getline(parts, part, '_')) {
+            if (part.empty()) {
+                continue;
+            }
+            bool allUpperCase = true;
+            for (char character : part) {
+                if (islower((unsigned char)character)) {
+                    allUpperCase = false;
+                }
+            }
+            if (allUpperCase) {
+                for (size_t index = 1; index < part.size(); index++) {
+                    part[index] = (char)tolower((unsigned char)part[index]);
+                }
+            }
+            part[0] = memberName.empty() ? (char)tolower((unsigned char)part[0]) : (char)toupper((unsigned char)part[0]);
+            memberName += part;
+        }
+        if (memberName.empty() || isdigit((unsigned char)memberName[0])) {
+            memberName = "_" + memberName;
+        }
+        return memberName;
+    }
+
+    std::string ToTypeName(const std::string& memberName) {
+        std::string typeName = memberName;
+        typeName[0] = (char)toupper((unsigned char)typeName[0]);
+        return typeName;
+    }
+
+    // Convert a decimal number like "0.125" or "1E-005" to an exact std::ratio
+    std::string ToRatio(const std::string& decimal) {
+        std::string mantissa = decimal;
+        int exponent = 0;
+        size_t exponentPosition = decimal.find_first_of("eE");
+        if (exponentPosition != std::string::npos) {
+            mantissa = decimal.substr(0, exponentPosition);
+            exponent = std::stoi(decimal.substr(exponentPosition + 1));
+        }
+        bool negative = !mantissa.empty() && mantissa[0] == '-';
+        long long numerator = 0;
+        long long denominator = 1;
+        bool fraction = false;
+        for (char character : mantissa) {
+            if (character == '.') {
+                fraction = true;
+            }
+            else if (isdigit((unsigned char)character)) {
+                numerator = numerator * 10 + (character - '0');
+                if (fraction) {
+                    exponent--;
+                }
+            }
+        }
+        for (; exponent > 0; exponent--) {
+            numerator *= 10;
+        }
+        for (; exponent < 0; exponent++) {
+            denominator *= 10;
+        }
+        std::stringstream ratio;
+        ratio << "std::ratio<" << (negative ? "-" : "") << numerator << ", " << denominator << ">";
+        return ratio.str();
+    }
+
+    std::string ValueType(const Signal& signal) {
+        if (signal.length == 1 && !signal.isSigned) {
+            return "bool";
+        }
+        std::string type = signal.isSigned ? "int" : "uint";
+        if (signal.length <= 8) {
+            return type + "8_t";
+        }
+        if (signal.length <= 16) {
+            return type + "16_t";
+        }
+        return type + "32_t";
+    }
+
+    bool Parse(std::istream& input, std::vector<Message>& messages) {
+        static const std::regex messageExpression(R"(^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+\w+)");
+        static const std::regex signalExpression(
+            R"(^\s+SG_\s+(\w+)\s*(\w*)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*\(([^,]+),([^)]+)\)\s*\[[^\]]*\]\s*\"([^\"]*)\")");
+        std::string line;
+        Message* message = nullptr;
+        while (std::getline(input, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            std::smatch match;
+            if (std::regex_search(line, match, messageExpression)) {
+                uint32_t identifier = (uint32_t)std::stoul(match[1]);
+                unsigned dataLengthCode = (unsigned)std::stoul(match[3]);
+                // Extended identifiers have bit 31 set
+                if (identifier > 0x7ff || dataLengthCode > 8) {
+                    std::cerr << "Skipping message " << match[2] << ", only standard CAN messages are supported" << std::endl;
+                    message = nullptr;
+                    continue;
+                }
+                messages.push_back({ identifier, match[2], ToMemberName(match[2]), dataLengthCode, {} });
+                message = &messages.back();
+            }
+            else if (std::regex_search(line, match, signalExpression)) {
+                if (message == nullptr) {
+                    continue;
+                }
+                Signal signal = {
+                    match[1], ToMemberName(match[1]),
+                    (unsigned)std::stoul(match[3]), (unsigned)std::stoul(match[4]),
+                    match[5] == "0", match[6] == "-",
+                    match[7], match[8], match[9]
+                };
+                if (match[2].length() > 0 && match[2] != "M") {
+                    std::cerr << "Skipping multiplexed signal " << message->name << "." << signal.name << std::endl;
+                    continue;
+                }
+                if (signal.length < 1 || signal.length > 32) {
+                    std::cerr << "Skipping signal " << message->name << "." << signal.name << ", only signals of 1-32 bits are supported" << std::endl;
+                    continue;
+                }
+                message->signals.push_back(signal);
+            }
+            else if (line.empty() || line[0] != ' ') {
+                message = nullptr;
+            }
+        }
+        return !messages.empty();
+    }
+
+    std::string SignalType(const Message& message, const Signal& signal) {
+        std::stringstream signalType;
+        signalType << ToTypeName(message.memberName) << "Signals::" << ToTypeName(signal.memberName);
+        return signalType.str();
+    }
+
+    // Minimum data length code needed to decode all signals of a message
+    unsigned MinimumDataLengthCode(const Message& message) {
+        unsigned minimumDataLengthCode = 0;
+        for (const Signal& signal : message.signals) {
+            unsigned lastBit = signal.bigEndian ?
+                (signal.startBit / 8) * 8 + (7 - signal.startBit % 8) + signal.length - 1 :
+                signal.startBit + signal.length - 1;
+            if (lastBit / 8 + 1 > minimumDataLengthCode) {
+                minimumDataLengthCode = lastBit / 8 + 1;
+            }
+        }
+        return minimumDataLengthCode;
+    }
+
+    void WriteHeader(std::ostream& output, const std::string& className, const std::string& inputName, const std::vector<Message>& messages) {
+        output <<
+            "/*\n"
+            " * " << className << "\n"
+            " *\n"
+            " * Decoding and encoding of the CAN bus messages in " << inputName << "\n"
+            " *\n"
+            " * Generated by DbcImporter, do not edit\n"
+            " *\n"
+            " * When decoding, the data of each message is stored in its AdditionalData. Encoding\n"
+            " * inserts the signals into that data, so bits that are not part of a signal are\n"
+            " * encoded as they were decoded.\n"
+            " * Signals hold raw values, the comment of each signal shows how to get the physical value.\n"
+            " *\n"
+            " */\n"
+            "\n"
+            "#pragma once\n"
+            "\n"
+            "#include <stddef.h>\n"
+            "#include <stdint.h>\n"
+            "#include <string>\n"
+            "\n"
+            "class " << className << " {\n"
+            "public:\n"
+            "    /// @brief Decode a CAN message\n"
+            "    /// @param inIdentifier CAN message identifier\n"
+            "    /// @param inDataLengthCode CAN message data length code\n"
+            "    /// @param inData CAN message data\n"
+            "    /// @return true on success, false on failure\n"
+            "    bool Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData);\n"
+            "    /// @brief Encode a CAN message\n"
+            "    /// @param outIdentifier CAN message identifier\n"
+            "    /// @param outDataLengthCode CAN message data length code\n"
+            "    /// @param outData CAN message data, must be able to hold 8 bytes\n"
+            "    void Encode(uint32_t& outIdentifier, uint8_t& outDataLengthCode, uint8_t* outData);\n"
+            "    /// @brief Create a string for logging, showing the contents of the CAN message stored in this instance\n"
+            "    /// @return A string you can use for logging\n"
+            "    std::string ToString();\n"
+            "\n"
+            "    // CAN IDs\n"
+            "    enum class Identifier\n"
+            "    {\n";
+        for (size_t index = 0; index < messages.size(); index++) {
+            char identifier[8];
+            snprintf(identifier, sizeof(identifier), "0x%03X", messages[index].identifier);
+            output << "        " << messages[index].memberName << " = " << identifier << (index + 1 < messages.size() ? ",\n" : "\n");
+        }
+        output << "    } _identifier = (Identifier)0;\n";
+        for (const Message& message : messages) {
+            output << "    struct " << ToTypeName(message.memberName) << " {\n";
+            for (const Signal& signal : message.signals) {
+                output << "        // Physical value = raw * " << signal.scale << " + " << signal.offset;
+                if (!signal.unit.empty()) {
+                    output << " [" << signal.unit << "]";
+                }
+                output << "\n        " << ValueType(signal) << " " << signal.memberName << ";\n";
+            }
+            output <<
+                "        struct AdditionalData {\n"
+                "            uint8_t dataLengthCode = " << message.dataLengthCode << ";\n"
+                "            uint8_t uncodedData[8] = {};\n"
+                "        } additionalData;\n"
+                "    } _" << message.memberName << " = {};\n";
+        }
+        output << "};\n";
+    }
+
+    void WriteSource(std::ostream& output, const std::string& className, const std::vector<Message>& messages) {
+        output <<
+            "// Generated by DbcImporter, do not edit\n"
+            "\n"
+            "#include \"" << className << ".h\"\n"
+            "#include \"CanSignal.h\"\n"
+            "#include <sstream>\n"
+            "#include <string.h>\n"
+            "\n"
+            "namespace {\n"
+            "    // Signals\n";
+        for (const Message& message : messages) {
+            output << "\n    namespace " << ToTypeName(message.memberName) << "Signals {\n";
+            for (const Signal& signal : message.signals) {
+                output << "        using " << ToTypeName(signal.memberName) << " = CanSignal<" <<
+                    signal.startBit << ", " << signal.length << ", " <<
+                    (signal.bigEndian ? "CanByteOrder::bigEndian" : "CanByteOrder::littleEndian") << ", " <<
+                    (signal.isSigned ? "true" : "false") << ", " <<
+                    ToRatio(signal.scale) << ", " << ToRatio(signal.offset) << ">;\n";
+            }
+            output << "    }\n";
+        }
+
+        output << "\n    // Decoders\n";
+        for (const Message& message : messages) {
+            std::string member = "coder._" + message.memberName;
+            output << "\n    void Decode" << ToTypeName(message.memberName) << "(" << className << "& coder, uint8_t inDataLengthCode, const uint8_t* inData) {\n";
+            for (const Signal& signal : message.signals) {
+                output << "        " << member << "." << signal.memberName << " = " << SignalType(message, signal) << "::Extract(inData)" <<
+                    (ValueType(signal) == "bool" ? " != 0" : "") << ";\n";
+            }
+            output <<
+                "        " << member << ".additionalData.dataLengthCode = inDataLengthCode;\n"
+                "        memcpy(" << member << ".additionalData.uncodedData, inData, inDataLengthCode);\n"
+                "    }\n";
+        }
+
+        output << "\n    // Encoders\n";
+        for (const Message& message : messages) {
+            std::string member = "coder._" + message.memberName;
+            output <<
+                "\n    void Encode" << ToTypeName(message.memberName) << "(" << className << "& coder, uint8_t& outDataLengthCode, uint8_t* outData) {\n"
+                "        outDataLengthCode = " << member << ".additionalData.dataLengthCode;\n"
+                "        if (outDataLengthCode < " << MinimumDataLengthCode(message) << ") {\n"
+                "            outDataLengthCode = " << MinimumDataLengthCode(message) << ";\n"
+                "        }\n"
+                "        memcpy(outData, " << member << ".additionalData.uncodedData, outDataLengthCode);\n";
+            for (const Signal& signal : message.signals) {
+                output << "        " << SignalType(message, signal) << "::Insert(outData, " << member << "." << signal.memberName << ");\n";
+            }
+            output << "    }\n";
+        }
+
+        output << "\n    // Formatters\n";
+        for (const Message& message : messages) {
+            std::string member = "coder._" + message.memberName;
+            output <<
+                "\n    void " << ToTypeName(message.memberName) << "ToString(const " << className << "& coder, std::stringstream& messageString) {\n"
+                "        messageString << \"ID:" << message.name << "\"";
+            for (const Signal& signal : message.signals) {
+                // Print 8 bit values as numbers instead of characters
+                bool isCharacter = ValueType(signal) == "uint8_t" || ValueType(signal) == "int8_t";
+                output << " << \" " << signal.memberName << ":\" << " << (isCharacter ? "(int)" : "") << member << "." << signal.memberName;
+            }
+            output << ";\n    }\n";
+        }
+
+        output <<
+            "\n"
+            "    // Dispatching\n"
+            "\n"
+            "    struct MessageHandler {\n"
+            "        " << className << "::Identifier identifier;\n"
+            "        // Messages with a lower data length code are rejected\n"
+            "        uint8_t minimumDataLengthCode;\n"
+            "        void (*decode)(" << className << "& coder, uint8_t inDataLengthCode, const uint8_t* inData);\n"
+            "        void (*encode)(" << className << "& coder, uint8_t& outDataLengthCode, uint8_t* outData);\n"
+            "        void (*toString)(const " << className << "& coder, std::stringstream& messageString);\n"
+            "    };\n"
+            "\n"
+            "    constexpr MessageHandler messageHandlers[] = {\n";
+        for (size_t index = 0; index < messages.size(); index++) {
+            std::string typeName = ToTypeName(messages[index].memberName);
+            output << "        { " << className << "::Identifier::" << messages[index].memberName << ", " << MinimumDataLengthCode(messages[index]) << ", " <<
+                "Decode" << typeName << ", Encode" << typeName << ", " << typeName << "ToString }" << (index + 1 < messages.size() ? ",\n" : "\n");
+        }
+        output <<
+            "    };\n"
+            "    constexpr size_t messageHandlerCount = sizeof(messageHandlers) / sizeof(messageHandlers[0]);\n"
+            "\n"
+            "    // Standard CAN identifiers are 11 bits\n"
+            "    constexpr uint32_t identifierCount = 0x800;\n"
+            "\n"
+            "    // Dense table holding for each identifier its position in messageHandlers plus 1\n"
+            "    // Zero means the identifier is not supported\n"
+            "    struct DispatchTable {\n"
+            "        uint16_t handlerNumber[identifierCount];\n"
+            "    };\n"
+            "\n"
+            "    constexpr DispatchTable CreateDispatchTable() {\n"
+            "        DispatchTable dispatchTable = {};\n"
+            "        for (size_t index = 0; index < messageHandlerCount; index++) {\n"
+            "            dispatchTable.handlerNumber[(uint32_t)messageHandlers[index].identifier] = (uint16_t)(index + 1);\n"
+            "        }\n"
+            "        return dispatchTable;\n"
+            "    }\n"
+            "\n"
+            "    constexpr DispatchTable dispatchTable = CreateDispatchTable();\n"
+            "\n"
+            "    const MessageHandler* FindMessageHandler(uint32_t identifier) {\n"
+            "        if (identifier >= identifierCount) {\n"
+            "            return nullptr;\n"
+            "        }\n"
+            "        uint16_t handlerNumber = dispatchTable.handlerNumber[identifier];\n"
+            "        if (handlerNumber == 0) {\n"
+            "            return nullptr;\n"
+            "        }\n"
+            "        return &messageHandlers[handlerNumber - 1];\n"
+            "    }\n"
+            "}\n"
+            "\n"
+            "bool " << className << "::Decode(uint32_t inIdentifier, uint8_t inDataLengthCode, uint8_t* inData) {\n"
+            "    _identifier = (Identifier)inIdentifier;\n"
+            "    if (inDataLengthCode > 8) {\n"
+            "        return false;\n"
+            "    }\n"
+            "    const MessageHandler* messageHandler = FindMessageHandler(inIdentifier);\n"
+            "    if (messageHandler == nullptr || inDataLengthCode < messageHandler->minimumDataLengthCode) {\n"
+            "        return false;\n"
+            "    }\n"
+            "    messageHandler->decode(*this, inDataLengthCode, inData);\n"
+            "    return true;\n"
+            "}\n"
+            "\n"
+            "void " << className << "::Encode(uint32_t& outIdentifier, uint8_t& outDataLengthCode, uint8_t* outData) {\n"
+            "    outIdentifier = (uint32_t)_identifier;\n"
+            "    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)_identifier);\n"
+            "    if (messageHandler != nullptr) {\n"
+            "        messageHandler->encode(*this, outDataLengthCode, outData);\n"
+            "    }\n"
+            "}\n"
+            "\n"
+            "std::string " << className << "::ToString() {\n"
+            "    std::stringstream messageString;\n"
+            "    const MessageHandler* messageHandler = FindMessageHandler((uint32_t)_identifier);\n"
+            "    if (messageHandler != nullptr) {\n"
+            "        messageHandler->toString(*this, messageString);\n"
+            "    }\n"
+            "    return messageString.str();\n"
+            "}\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.dbc> <ClassName> [output directory]" << std::endl;
+        return 1;
+    }
+    std::string inputPath = argv[1];
+    std::string className = argv[2];
+    std::string outputDirectory = argc > 3 ? std::string(argv[3]) + "/" : "";
+
+    std::ifstream input(inputPath);
+    if (!input) {
+        std::cerr << "Can not open " << inputPath << std::endl;
+        return 1;
+    }
+    std::vector<Message> messages;
+    if (!Parse(input, messages)) {
+        std::cerr << "No supported messages found in " << inputPath << std::endl;
+        return 1;
+    }
+
+    std::string inputName = inputPath.substr(inputPath.find_last_of("/\\") + 1);
+    std::ofstream header(outputDirectory + className + ".h");
+    std::ofstream source(outputDirectory + className + ".cpp");
+    if (!header || !source) {
+        std::cerr << "Can not create output files in " << (outputDirectory.empty() ? "." : outputDirectory) << std::endl;
+        return 1;
+    }
+    WriteHeader(header, className, inputName, messages);
+    WriteSource(source, className, messages);
+    std::cout << "Generated " << className << " with " << messages.size() << " messages" << std::endl;
+    return 0;
+}